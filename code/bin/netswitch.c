@@ -0,0 +1,335 @@
+/* netswitch.c 
+ *
+ * This program is a simulated network switch for a cluster of Nachos
+ * machines.  A machine started with "-sw" sends every packet to the 
+ * switch's socket, SOCKET_SWITCH in the current directory, rather than
+ * straight to the destination's SOCKET_<n>.  The switch forwards each
+ * packet over a simulated link from the sender to the receiver; every
+ * link has its own
+ *
+ *	bandwidth -- packets leave one at a time, MaxWireSize bytes each;
+ *	latency -- added to every packet once it has left;
+ *	loss -- the chance that a packet is dropped;
+ *	reordering -- the chance that a packet is held back by up to four
+ *		latencies (plus a millisecond), so that later ones pass it.
+ *
+ * Times are real (host) time.  The switch runs until it is killed 
+ * (SIGINT or SIGTERM), and then prints what each link carried.
+ *
+ * Usage: netswitch [-b bytes/sec] [-l latency ms] [-p loss] 
+ *		[-r reorder] [-f link file] [-s seed]
+ *
+ * The options set every link; the link file, if any, then overrides
+ * single links, one per line:
+ *
+ *	<from> <to> <bytes/sec> <latency ms> <loss> <reorder>
+ *
+ * A bandwidth of 0 means unlimited.  Lines starting with '#' are 
+ * ignored.
+ *
+ * Copyright (c) 1992-1993 The Regents of the University of California.
+ * All rights reserved.  See copyright.h for copyright notice and limitation 
+ * of liability and disclaimer of warranty provisions.
+ */
+
+#define MAIN
+#include "copyright.h" 
+#undef MAIN
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* These must match machine/network.h */
+#define MaxWireSize	64
+typedef struct {
+    int to;			/* destination machine ID */
+    int from;			/* source machine ID */
+    unsigned length;		/* bytes of packet data */
+} WireHeader;
+
+#define SwitchSocket	"SOCKET_SWITCH"
+#define MaxNodes	64
+#define MaxPending	8192	/* packets in transit at once */
+#define RetryDelay	0.001	/* seconds before retrying a full socket */
+
+typedef struct {
+    double bandwidth;		/* bytes per second, 0 if unlimited */
+    double latency;		/* seconds */
+    double loss, reorder;	/* probabilities */
+    double busyUntil;		/* when the link is free to send again */
+    int forwarded, dropped, reordered;
+} Link;
+
+typedef struct {
+    double when;		/* time to deliver */
+    int to;
+    char packet[MaxWireSize];
+} Pending;
+
+static Link links[MaxNodes][MaxNodes];
+static Pending pending[MaxPending];	/* a heap, earliest first */
+static int numPending;
+static int overflows, undeliverable;
+static volatile int stop;
+
+/*
+ * Now
+ *	Return the time of day, in seconds.
+ */
+
+static double
+Now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/*
+ * Push, Pop
+ *	Add a packet to the heap of packets in transit, or take off the 
+ *	one that is due first.
+ */
+
+static void
+Push(double when, int to, char *packet)
+{
+    int i = numPending++, parent;
+
+    while (i > 0) {
+	parent = (i - 1) / 2;
+	if (pending[parent].when <= when)
+	    break;
+	pending[i] = pending[parent];
+	i = parent;
+    }
+    pending[i].when = when;
+    pending[i].to = to;
+    memcpy(pending[i].packet, packet, MaxWireSize);
+}
+
+static void
+Pop(Pending *out)
+{
+    Pending last = pending[--numPending];
+    int i = 0, child;
+
+    *out = pending[0];
+    for (;;) {
+	child = 2 * i + 1;
+	if (child >= numPending)
+	    break;
+	if ((child + 1 < numPending) 
+		&& (pending[child + 1].when < pending[child].when))
+	    child++;
+	if (last.when <= pending[child].when)
+	    break;
+	pending[i] = pending[child];
+	i = child;
+    }
+    pending[i] = last;
+}
+
+/*
+ * Route
+ *	A packet has come in: send it down its link, or drop it.
+ */
+
+static void
+Route(char *packet, double now)
+{
+    WireHeader *hdr = (WireHeader *) packet;
+    Link *link;
+    double depart, when;
+
+    if ((hdr->from < 0) || (hdr->from >= MaxNodes) 
+		|| (hdr->to < 0) || (hdr->to >= MaxNodes)) {
+	fprintf(stderr, "netswitch: bad packet from %d to %d\n", 
+						hdr->from, hdr->to);
+	return;
+    }
+    link = &links[hdr->from][hdr->to];
+    if (drand48() < link->loss) {
+	link->dropped++;
+	return;
+    }
+    if (numPending == MaxPending) {
+	overflows++;
+	return;
+    }
+    depart = (link->busyUntil > now) ? link->busyUntil : now;
+    if (link->bandwidth > 0)
+	depart += MaxWireSize / link->bandwidth;
+    link->busyUntil = depart;
+    when = depart + link->latency;
+    if (drand48() < link->reorder) {
+	when += drand48() * 4 * (link->latency + 0.001);
+	link->reordered++;
+    }
+    link->forwarded++;
+    Push(when, hdr->to, packet);
+}
+
+/*
+ * Deliver
+ *	Send a packet that is due on to its destination.  If the 
+ *	destination's socket is full, try again shortly; if it is gone 
+ *	(that machine has halted), forget the packet.
+ */
+
+static void
+Deliver(int sock, Pending *p, double now)
+{
+    struct sockaddr_un name;
+
+    memset(&name, 0, sizeof(name));
+    name.sun_family = AF_UNIX;
+    sprintf(name.sun_path, "SOCKET_%d", p->to);
+    if (sendto(sock, p->packet, MaxWireSize, MSG_DONTWAIT, 
+		(struct sockaddr *) &name, sizeof(name)) == MaxWireSize)
+	return;
+    if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == ENOBUFS))
+	Push(now + RetryDelay, p->to, p->packet);
+    else
+	undeliverable++;
+}
+
+/*
+ * ReadLinks
+ *	Apply the per-link settings in file "name".
+ */
+
+static void
+ReadLinks(char *name)
+{
+    FILE *fp = fopen(name, "r");
+    char line[256];
+    int from, to;
+    double bandwidth, latency, loss, reorder;
+
+    if (fp == NULL) {
+	perror(name);
+	exit(1);
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+	if ((line[0] == '#') || (line[0] == '\n'))
+	    continue;
+	if ((sscanf(line, "%d %d %lf %lf %lf %lf", &from, &to, &bandwidth,
+			&latency, &loss, &reorder) != 6)
+		|| (from < 0) || (from >= MaxNodes) 
+		|| (to < 0) || (to >= MaxNodes)) {
+	    fprintf(stderr, "netswitch: bad link line: %s", line);
+	    exit(1);
+	}
+	links[from][to].bandwidth = bandwidth;
+	links[from][to].latency = latency / 1000;
+	links[from][to].loss = loss;
+	links[from][to].reorder = reorder;
+    }
+    fclose(fp);
+}
+
+static void
+Stop(int sig)
+{
+    stop = 1;
+}
+
+int
+main(int argc, char **argv)
+{
+    double bandwidth = 0, latency = 0, loss = 0, reorder = 0, now, wait;
+    char *linkFile = NULL, packet[MaxWireSize];
+    struct sockaddr_un name;
+    struct timeval tv;
+    fd_set fds;
+    Pending p;
+    Link *link;
+    int sock, i, j;
+    long seed = 1;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+	if (!strcmp(argv[i], "-b"))
+	    bandwidth = atof(argv[i + 1]);
+	else if (!strcmp(argv[i], "-l"))
+	    latency = atof(argv[i + 1]) / 1000;
+	else if (!strcmp(argv[i], "-p"))
+	    loss = atof(argv[i + 1]);
+	else if (!strcmp(argv[i], "-r"))
+	    reorder = atof(argv[i + 1]);
+	else if (!strcmp(argv[i], "-f"))
+	    linkFile = argv[i + 1];
+	else if (!strcmp(argv[i], "-s"))
+	    seed = atol(argv[i + 1]);
+	else
+	    break;
+    }
+    if (i != argc) {
+	fprintf(stderr, "usage: netswitch [-b bytes/sec] [-l latency ms] "
+		"[-p loss] [-r reorder] [-f link file] [-s seed]\n");
+	exit(1);
+    }
+    for (i = 0; i < MaxNodes; i++)
+	for (j = 0; j < MaxNodes; j++) {
+	    links[i][j].bandwidth = bandwidth;
+	    links[i][j].latency = latency;
+	    links[i][j].loss = loss;
+	    links[i][j].reorder = reorder;
+	}
+    if (linkFile != NULL)
+	ReadLinks(linkFile);
+    srand48(seed);
+
+    sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+    memset(&name, 0, sizeof(name));
+    name.sun_family = AF_UNIX;
+    strcpy(name.sun_path, SwitchSocket);
+    unlink(SwitchSocket);
+    if ((sock < 0) || (bind(sock, (struct sockaddr *) &name, 
+						sizeof(name)) < 0)) {
+	perror(SwitchSocket);
+	exit(1);
+    }
+    signal(SIGINT, Stop);
+    signal(SIGTERM, Stop);
+
+    while (!stop) {
+	now = Now();
+	while ((numPending > 0) && (pending[0].when <= now)) {
+	    Pop(&p);
+	    Deliver(sock, &p, now);
+	}
+	wait = (numPending > 0) ? pending[0].when - now : 1.0;
+	tv.tv_sec = (long) wait;
+	tv.tv_usec = (long) ((wait - tv.tv_sec) * 1e6);
+	FD_ZERO(&fds);
+	FD_SET(sock, &fds);
+	if (select(sock + 1, &fds, NULL, NULL, &tv) <= 0)
+	    continue;				/* timeout, or a signal */
+	now = Now();
+	while (recv(sock, packet, MaxWireSize, MSG_DONTWAIT) == MaxWireSize)
+	    Route(packet, now);
+    }
+
+    close(sock);
+    unlink(SwitchSocket);
+    printf("link,forwarded,dropped,reordered\n");
+    for (i = 0; i < MaxNodes; i++)
+	for (j = 0; j < MaxNodes; j++) {
+	    link = &links[i][j];
+	    if (link->forwarded + link->dropped > 0)
+		printf("%d->%d,%d,%d,%d\n", i, j, link->forwarded, 
+				link->dropped, link->reordered);
+	}
+    printf("in transit %d, overflows %d, undeliverable %d\n", numPending,
+					overflows, undeliverable);
+    return 0;
+}
@@ -0,0 +1,262 @@
+/* pgreplay.c 
+ *
+ * This program reads a page trace written by Nachos (nachos -pt <file>),
+ * and prints, for every number of physical frames from 1 up to a 
+ * maximum, how many page faults the reference string would have 
+ * caused under FIFO, LRU and OPT replacement.  Output is in CSV form,
+ * one line per frame count, ready to be plotted.
+ *
+ * LRU and OPT are stack algorithms, so a single pass of Mattson's stack
+ * algorithm gives the stack distance of every reference, and with it
+ * the fault count for all frame counts at once.  FIFO is not a stack
+ * algorithm (it suffers from Belady's anomaly), so it is simulated for
+ * each frame count -- but still within the same pass over the trace.
+ *
+ * Memory is assumed to be shared by all address spaces in the trace
+ * (global replacement, as in the Nachos kernel).
+ *
+ * Usage: pgreplay <trace file> [max frames]
+ *
+ * Copyright (c) 1992-1993 The Regents of the University of California.
+ * All rights reserved.  See copyright.h for copyright notice and limitation 
+ * of liability and disclaimer of warranty provisions.
+ */
+
+#define MAIN
+#include "copyright.h" 
+#undef MAIN
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "pgtrace.h"
+
+#define DefaultMaxFrames	64
+#define Never			0x7fffffff	/* next use of a page that is
+						 * not referenced again */
+
+static int *refs;		/* the reference string, as page numbers */
+static int numRefs;
+static int numPages;		/* distinct (space, vpn) pairs */
+
+/*
+ * ReadTrace
+ *	Read the TraceRef events of "name" into "refs", numbering the
+ *	pages 0 .. numPages-1.  Returns the number of faults the kernel
+ *	itself recorded.
+ */
+
+static int
+ReadTrace(char *name)
+{
+    FILE *fp = fopen(name, "rb");
+    TraceEvent event;
+    int magic, maxSpace = 0, maxVPN = 0, kernelFaults = 0, size = 1024;
+    int *spaces, *vpns, *pageOf, i;
+
+    if (fp == NULL) {
+	perror(name);
+	exit(1);
+    }
+    if ((fread(&magic, sizeof(int), 1, fp) != 1) || (magic != PGTRACEMAGIC)) {
+	fprintf(stderr, "%s: not a Nachos page trace\n", name);
+	exit(1);
+    }
+
+    spaces = (int *) malloc(size * sizeof(int));
+    vpns = (int *) malloc(size * sizeof(int));
+    numRefs = 0;
+    while (fread(&event, sizeof(TraceEvent), 1, fp) == 1) {
+	if (event.type == TraceFault) {
+	    kernelFaults++;
+	    continue;
+	}
+	if (numRefs == size) {
+	    size *= 2;
+	    spaces = (int *) realloc(spaces, size * sizeof(int));
+	    vpns = (int *) realloc(vpns, size * sizeof(int));
+	}
+	spaces[numRefs] = event.space;
+	vpns[numRefs] = event.vpn;
+	if (event.space > maxSpace) maxSpace = event.space;
+	if (event.vpn > maxVPN) maxVPN = event.vpn;
+	numRefs++;
+    }
+    fclose(fp);
+
+    /* renumber the (space, vpn) pairs densely */
+    pageOf = (int *) malloc((maxSpace + 1) * (maxVPN + 1) * sizeof(int));
+    for (i = 0; i < (maxSpace + 1) * (maxVPN + 1); i++)
+	pageOf[i] = -1;
+    refs = (int *) malloc((numRefs + 1) * sizeof(int));
+    numPages = 0;
+    for (i = 0; i < numRefs; i++) {
+	int key = spaces[i] * (maxVPN + 1) + vpns[i];
+
+	if (pageOf[key] < 0)
+	    pageOf[key] = numPages++;
+	refs[i] = pageOf[key];
+    }
+    free(spaces);
+    free(vpns);
+    free(pageOf);
+    return kernelFaults;
+}
+
+/*
+ * StackDistances
+ *	One pass of Mattson's algorithm.  For each reference, find the
+ *	depth of the page in the LRU stack and in the OPT stack (0 if
+ *	it is not in the stack at all, i.e. a first reference), and
+ *	count the references at each depth in "lruDist" and "optDist".
+ *
+ *	The LRU stack is kept in order of last use.  The OPT stack is
+ *	kept in order of priority, where a page is more important the
+ *	sooner it will be used again; on each reference the referenced
+ *	page goes to the top, and the pages above its old position are
+ *	re-sorted by carrying the less important page downward.
+ */
+
+static void
+StackDistances(int *lruDist, int *optDist)
+{
+    int *nextUse = (int *) malloc(numRefs * sizeof(int));
+    int *lastSeen = (int *) malloc(numPages * sizeof(int));
+    int *pageNext = (int *) malloc(numPages * sizeof(int));
+    int *lru = (int *) malloc(numPages * sizeof(int));
+    int *opt = (int *) malloc(numPages * sizeof(int));
+    int depth = 0;		/* both stacks hold the same pages */
+    int t, i, d, page, carry;
+
+    /* when is each page referenced next? */
+    for (i = 0; i < numPages; i++)
+	lastSeen[i] = Never;
+    for (t = numRefs - 1; t >= 0; t--) {
+	nextUse[t] = lastSeen[refs[t]];
+	lastSeen[refs[t]] = t;
+    }
+
+    for (t = 0; t < numRefs; t++) {
+	page = refs[t];
+
+	/* LRU: move the page to the top */
+	for (d = 0; (d < depth) && (lru[d] != page); d++)
+	    ;
+	lruDist[(d < depth) ? d + 1 : 0]++;
+	for (i = (d < depth) ? d : depth; i > 0; i--)
+	    lru[i] = lru[i - 1];
+	lru[0] = page;
+
+	/* OPT: put the page on top, and let the others settle */
+	for (d = 0; (d < depth) && (opt[d] != page); d++)
+	    ;
+	optDist[(d < depth) ? d + 1 : 0]++;
+	if (d == depth)
+	    depth++;
+	pageNext[page] = nextUse[t];
+	if (d > 0) {
+	    carry = opt[0];
+	    opt[0] = page;
+	    for (i = 1; i < d; i++)
+		if (pageNext[opt[i]] > pageNext[carry]) {
+		    int tmp = opt[i];	/* "carry" is needed sooner */
+
+		    opt[i] = carry;
+		    carry = tmp;
+		}
+	    opt[d] = carry;
+	} else
+	    opt[0] = page;
+    }
+    free(nextUse);
+    free(lastSeen);
+    free(pageNext);
+    free(lru);
+    free(opt);
+}
+
+/*
+ * FifoFaults
+ *	Simulate FIFO replacement with 1 .. maxFrames frames, all in the
+ *	same pass, and store the fault counts in "faults".
+ */
+
+static void
+FifoFaults(int maxFrames, int *faults)
+{
+    char **resident = (char **) malloc((maxFrames + 1) * sizeof(char *));
+    int **queue = (int **) malloc((maxFrames + 1) * sizeof(int *));
+    int *used = (int *) calloc(maxFrames + 1, sizeof(int));
+    int *oldest = (int *) calloc(maxFrames + 1, sizeof(int));
+    int f, t;
+
+    for (f = 1; f <= maxFrames; f++) {
+	resident[f] = (char *) calloc(numPages, 1);
+	queue[f] = (int *) malloc(f * sizeof(int));
+	faults[f] = 0;
+    }
+    for (t = 0; t < numRefs; t++)
+	for (f = 1; f <= maxFrames; f++) {
+	    int page = refs[t];
+
+	    if (resident[f][page])
+		continue;
+	    faults[f]++;
+	    if (used[f] < f)
+		queue[f][used[f]++] = page;
+	    else {		/* replace the page that came in first */
+		resident[f][queue[f][oldest[f]]] = 0;
+		queue[f][oldest[f]] = page;
+		oldest[f] = (oldest[f] + 1) % f;
+	    }
+	    resident[f][page] = 1;
+	}
+    for (f = 1; f <= maxFrames; f++) {
+	free(resident[f]);
+	free(queue[f]);
+    }
+    free(resident);
+    free(queue);
+    free(used);
+    free(oldest);
+}
+
+int
+main(int argc, char **argv)
+{
+    int maxFrames = DefaultMaxFrames, kernelFaults, f;
+    int *lruDist, *optDist, *fifo;
+    int lruFaults, optFaults;
+
+    if ((argc < 2) || (argc > 3)) {
+	fprintf(stderr, "Usage: %s <trace file> [max frames]\n", argv[0]);
+	exit(1);
+    }
+    if (argc == 3)
+	maxFrames = atoi(argv[2]);
+    if (maxFrames < 1) {
+	fprintf(stderr, "%s: need at least one frame\n", argv[0]);
+	exit(1);
+    }
+
+    kernelFaults = ReadTrace(argv[1]);
+    lruDist = (int *) calloc(numPages + 1, sizeof(int));
+    optDist = (int *) calloc(numPages + 1, sizeof(int));
+    fifo = (int *) malloc((maxFrames + 1) * sizeof(int));
+    StackDistances(lruDist, optDist);
+    FifoFaults(maxFrames, fifo);
+
+    printf("# %d references to %d distinct pages, %d faults in the kernel\n",
+		numRefs, numPages, kernelFaults);
+    printf("frames,fifo,lru,opt\n");
+
+    /* with f frames, references deeper than f in the stack fault */
+    lruFaults = optFaults = numRefs;
+    for (f = 1; f <= maxFrames; f++) {
+	if (f <= numPages) {
+	    lruFaults -= lruDist[f];
+	    optFaults -= optDist[f];
+	}
+	printf("%d,%d,%d,%d\n", f, fifo[f], lruFaults, optFaults);
+    }
+    return 0;
+}
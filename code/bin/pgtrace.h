@@ -0,0 +1,30 @@
+/* pgtrace.h 
+ *     Data structures defining the page reference trace written by
+ *     the Nachos kernel (see userprog/pagetrace.cc), and read back by
+ *     the offline replay tool pgreplay.
+ *
+ *     A trace file is the word PGTRACEMAGIC followed by any number of
+ *     TraceEvent records, all in the byte order of the host that
+ *     wrote them.
+ */
+
+#ifndef PGTRACE_H
+#define PGTRACE_H
+
+#define PGTRACEMAGIC	0x70677472	/* "pgtr" */
+
+#define TraceRef	0	/* page referenced, translation was valid */
+#define TraceFault	1	/* page fault -- page had to be brought in */
+
+typedef struct traceEvent {
+  int tick;			/* stats->totalTicks at the time */
+  int space;			/* address space ID of the reference */
+  int vpn;			/* virtual page referenced */
+  int type;			/* TraceRef or TraceFault */
+  int evicted;			/* on a fault, virtual page evicted to make
+				 * room for this one, or -1 if none */
+  int dirty;			/* on a fault, 1 if the evicted page had 
+				 * to be written to swap */
+} TraceEvent;
+
+#endif /* PGTRACE_H */
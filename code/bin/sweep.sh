@@ -0,0 +1,170 @@
+#!/bin/sh
+# sweep.sh
+#	Run many independent Nachos simulations in parallel, one per
+#	configuration, and collect their statistics into one CSV file.
+#	Run it in the directory you would run the simulations in:
+#
+#		../bin/sweep.sh [-j jobs] [-k] program [configs] > sweep.csv
+#
+#	Each line of the configs file (standard input if there is none,
+#	or it is "-") is the arguments for one run of program; blank
+#	lines and lines starting with # are skipped.  For example, the
+#	page replacement runs of lab7/n7tset.sh are
+#
+#		for i in 1 2 3 4 5 6; do echo "-pra $i -x ../test/sort.noff"
+#		done | ../bin/sweep.sh ./n7 > n7sweep.csv
+#
+#	Up to "jobs" runs (default: one per host CPU) go at a time.
+#
+#	Nachos keeps its disk (DISK), swap file (SWAP, SWAP0) and
+#	network sockets (SOCKET_*) in the directory it runs in, so two
+#	runs there at once would trample each other.  Instead each run
+#	gets a scratch copy of the directory, and of its parent, so that
+#	paths like ./nachos and ../test/sort.noff still work: everything
+#	is a symbolic link to the original, except that the disk and swap
+#	images are private copies, and there are no sockets.  A run starts
+#	from the disk it would have had, and nothing it does to it is kept.
+#
+#	The CSV has a line per run, in the order of the configs: the run
+#	number, its arguments, its exit status, then the numbers printed
+#	by Statistics::Print when the machine halted, one column each
+#	("ticks total", "context switches", "disk i/o reads", ...).
+#	Columns a run didn't print are left empty.  Each run's output is
+#	in <scratch>/<run>/out.log; the scratch directory is removed at
+#	the end, unless -k is given.
+#
+# Copyright (c) 1992-1993 The Regents of the University of California.
+# All rights reserved.  See copyright.h for copyright notice and limitation
+# of liability and disclaimer of warranty provisions.
+
+jobs=`getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1`
+keep=0
+while [ $# -gt 0 ]; do
+    case "$1" in
+    -j)	jobs=$2; shift 2 ;;
+    -k)	keep=1; shift ;;
+    *)	break ;;
+    esac
+done
+if [ $# -lt 1 ] || [ $# -gt 2 ] || [ "$jobs" -lt 1 ]; then
+    echo "usage: $0 [-j jobs] [-k] program [configs]" >&2
+    exit 1
+fi
+program=$1
+configs=${2:--}
+
+here=`pwd`
+parent=`dirname "$here"`
+base=`basename "$here"`
+scratch=`mktemp -d "${TMPDIR:-/tmp}/sweep.XXXXXX"` || exit 1
+trap 'rm -rf "$scratch"; exit 1' INT TERM
+
+grep -v '^[ 	]*\(#.*\)\{0,1\}$' "$configs" > "$scratch/configs"
+runs=`wc -l < "$scratch/configs"`
+if [ $runs -lt $jobs ]; then
+    jobs=$runs
+fi
+
+# Shadow "from" in directory "to": a link to each entry, except "skip"
+# (and with the disk and swap images copied, and no sockets).
+shadow() {
+    for f in "$1"/*; do
+	[ -e "$f" ] || continue
+	name=`basename "$f"`
+	case "$name" in
+	"$3")		;;
+	SOCKET_*)	;;
+	DISK|SWAP*)	cp "$f" "$2/$name" ;;
+	*)		ln -s "$f" "$2/$name" ;;
+	esac
+    done
+}
+
+# Do run number $1, with arguments $2.
+run() {
+    dir="$scratch/$1"
+    mkdir -p "$dir/$base"
+    shadow "$parent" "$dir" "$base"
+    shadow "$here" "$dir/$base" ""
+    set -f			# the arguments are only split, not globbed
+    (cd "$dir/$base" && $program $2) < /dev/null > "$dir/out.log" 2>&1
+    echo $? > "$dir/status"
+    set +f
+}
+
+# Worker $1 of $jobs: does every jobs'th run.
+worker() {
+    n=0
+    while IFS= read -r args; do
+	n=$((n + 1))
+	if [ $((n % jobs)) -eq "$1" ]; then
+	    run $n "$args"
+	fi
+    done < "$scratch/configs"
+}
+
+start=`date +%s`
+pids=""
+w=0
+while [ $w -lt $jobs ]; do
+    worker $w &
+    pids="$pids $!"
+    w=$((w + 1))
+done
+for pid in $pids; do
+    wait $pid
+done
+echo "sweep: $runs runs, $jobs at a time, `expr \`date +%s\` - $start` seconds" >&2
+
+# Each run's output, behind a line saying which run it is, goes through
+# one awk script that turns "Label: name value, name value" lines into
+# columns.
+n=0
+while IFS= read -r args; do
+    n=$((n + 1))
+    echo "@@sweep $n `cat \"$scratch/$n/status\" 2>/dev/null` $args"
+    cat "$scratch/$n/out.log" 2>/dev/null
+done < "$scratch/configs" | awk '
+/^@@sweep / {
+    run = $2; runs = run
+    status[run] = $3
+    a = $0; sub(/^@@sweep [^ ]+ [^ ]* ?/, "", a); args[run] = a
+    instats = 0
+    next
+}
+/Machine halting!/	{ instats = 1; next }
+/^Cleaning up/		{ instats = 0; next }
+instats && /^[A-Z][A-Za-z\/ ]*: / {
+    label = tolower(substr($0, 1, index($0, ":") - 1))
+    k = split(substr($0, index($0, ":") + 2), parts, ", ")
+    for (i = 1; i <= k; i++) {
+	m = split(parts[i], words, " ")
+	col = label
+	if (m > 1) {
+	    name = parts[i]; sub(/ [^ ]*$/, "", name)
+	    col = label " " name
+	}
+	if (!(col in seen)) { seen[col] = 1; cols[++ncols] = col }
+	value[run, col] = words[m]
+    }
+}
+END {
+    line = "run,arguments,exit status"
+    for (c = 1; c <= ncols; c++)
+	line = line "," cols[c]
+    print line
+    for (r = 1; r <= runs; r++) {
+	a = args[r]; gsub(/"/, "\"\"", a)
+	line = r ",\"" a "\"," status[r]
+	for (c = 1; c <= ncols; c++)
+	    line = line "," value[r, cols[c]]
+	print line
+    }
+}'
+
+if [ $keep -eq 1 ]; then
+    echo "sweep: runs kept in $scratch" >&2
+else
+    rm -rf "$scratch"
+fi
+exit 0
@@ -3,55 +3,306 @@
 
 //----------------------------------------------------------------------
 // Barrier::Barrier
-// 	初始化一个屏障对象，设置需要等待的线程数和相关信号量
+// 	初始化屏障的公共部分
 //
 //	"debugName" 是调试用的名称
 //	"n" 是需要等待的线程总数
 //----------------------------------------------------------------------
 Barrier::Barrier(const char* debugName, int n)
 {
+    ASSERT(n > 0);
     name = (char*)debugName;
     threadCount = n;
+}
+
+Barrier::~Barrier()
+{
+}
+
+//----------------------------------------------------------------------
+// BarrierFlag::BarrierFlag
+// 	初始值为FALSE，没有等待者
+//----------------------------------------------------------------------
+BarrierFlag::BarrierFlag()
+{
+    value = FALSE;
+    waiters = new ThreadQueue;
+}
+
+BarrierFlag::~BarrierFlag()
+{
+    delete waiters;
+}
+
+//----------------------------------------------------------------------
+// BarrierFlag::Set
+// 	设置标志的值，并把所有等待者放回就绪队列，由它们自己重新检查
+//----------------------------------------------------------------------
+void BarrierFlag::Set(bool newValue)
+{
+    Thread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    value = newValue;
+    while ((thread = waiters->Remove()) != NULL)
+        scheduler->ReadyToRun(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// BarrierFlag::WaitFor
+// 	睡眠直到标志的值等于wanted
+//----------------------------------------------------------------------
+void BarrierFlag::WaitFor(bool wanted)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    while (value != wanted) {
+        waiters->Append(currentThread);
+        currentThread->Sleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// SemaphoreBarrier::SemaphoreBarrier
+// 	初始化一个屏障对象，设置需要等待的线程数和相关信号量
+//----------------------------------------------------------------------
+SemaphoreBarrier::SemaphoreBarrier(const char* debugName, int n)
+    : Barrier(debugName, n)
+{
     arrivedCount = 0;
     mutex = new Semaphore("barrier mutex", 1);  // 初始值为1的互斥信号量
     barrier = new Semaphore("barrier", 0);      // 初始值为0的屏障信号量
+    barrier2 = new Semaphore("barrier 2", 0);   // 第二阶段的屏障信号量
 }
 
 //----------------------------------------------------------------------
-// Barrier::~Barrier
+// SemaphoreBarrier::~SemaphoreBarrier
 // 	释放屏障对象占用的资源
 //----------------------------------------------------------------------
-Barrier::~Barrier()
+SemaphoreBarrier::~SemaphoreBarrier()
 {
     delete mutex;
     delete barrier;
+    delete barrier2;
 }
 
 //----------------------------------------------------------------------
-// Barrier::Wait
+// SemaphoreBarrier::Wait
 // 	等待所有线程到达屏障点，实现N线程屏障
-// 	修改后的实现，消除竞争条件
+//
+// 	原来的实现只有一个阶段，只能用一次：最后到达的线程V完之后立即
+// 	进入下一轮，可能在被唤醒的线程运行之前就把留给它们的V消耗掉，
+// 	从而提前通过。这里按"The Little Book of Semaphores" 3.7分两个
+// 	阶段：所有线程都离开第一阶段之后，第二阶段才放行，下一轮的到达
+// 	不会和上一轮混在一起。每个阶段最后的线程做threadCount次V。
 //----------------------------------------------------------------------
-void Barrier::Wait()
+void SemaphoreBarrier::Wait(int which)
 {
+    int i;
+
     // rendezvous point
-    
-    // 进入互斥区，保护共享变量和条件检查
     mutex->P();
     arrivedCount = arrivedCount + 1;
-    
-    // 在互斥区内检查并处理屏障唤醒，确保原子性
     if (arrivedCount == threadCount) {
-        // 最后一个线程：重置计数器并唤醒所有等待的线程
-        arrivedCount = 0;  // 重置计数器，为下一次使用做准备
-        for (int i = 0; i < threadCount - 1; i++) {
-            barrier->V();  // 唤醒其他threadCount-1个线程
-        }
-        mutex->V();  // 最后一个线程不需要等待，直接通过
-    } else {
-        mutex->V();  // 非最后一个线程：释放互斥锁
-        barrier->P();  // 等待被最后一个线程唤醒
-    }
-    
-    // critical point - 所有线程都已通过屏障
-}
\ No newline at end of file
+        for (i = 0; i < threadCount; i++)
+            barrier->V();  // 放行本轮所有线程（包括自己）
+    }
+    mutex->V();
+    barrier->P();
+
+    // critical point - 所有线程都已到达屏障
+
+    mutex->P();
+    arrivedCount = arrivedCount - 1;
+    if (arrivedCount == 0) {
+        for (i = 0; i < threadCount; i++)
+            barrier2->V();  // 所有线程都已离开第一阶段
+    }
+    mutex->V();
+    barrier2->P();
+}
+
+//----------------------------------------------------------------------
+// CentralBarrier::CentralBarrier
+// 	计数器从n开始，全局sense和所有本地sense都为FALSE
+//----------------------------------------------------------------------
+CentralBarrier::CentralBarrier(const char* debugName, int n)
+    : Barrier(debugName, n)
+{
+    count = n;
+    sense = new BarrierFlag;
+    localSense = new bool[n];
+    for (int i = 0; i < n; i++)
+        localSense[i] = FALSE;
+}
+
+CentralBarrier::~CentralBarrier()
+{
+    delete sense;
+    delete [] localSense;
+}
+
+//----------------------------------------------------------------------
+// CentralBarrier::Wait
+// 	翻转本地sense后到达。计数器的递减用关中断保证原子性，相当于
+// 	多处理器上的fetch-and-decrement。
+//----------------------------------------------------------------------
+void CentralBarrier::Wait(int which)
+{
+    bool mySense = !localSense[which];
+    bool last;
+    IntStatus oldLevel;
+
+    localSense[which] = mySense;
+    oldLevel = interrupt->SetLevel(IntOff);
+    last = (--count == 0);
+    if (last)
+        count = threadCount;  // 在释放之前重置，下一轮的到达不会看到旧值
+    (void) interrupt->SetLevel(oldLevel);
+
+    if (last)
+        sense->Set(mySense);
+    else
+        sense->WaitFor(mySense);
+}
+
+//----------------------------------------------------------------------
+// TreeBarrier::TreeBarrier
+// 	自底向上建树：第0层是ceil(n/TreeFanIn)个叶结点，每层结点数是
+// 	下一层的1/TreeFanIn，直到只剩根结点。结点按层连续存放在数组中，
+// 	根是最后一个。
+//----------------------------------------------------------------------
+TreeBarrier::TreeBarrier(const char* debugName, int n)
+    : Barrier(debugName, n)
+{
+    int levelStart, levelSize, nextSize, i;
+
+    numNodes = 0;
+    for (levelSize = divRoundUp(n, TreeFanIn); ; 
+         levelSize = divRoundUp(levelSize, TreeFanIn)) {
+        numNodes += levelSize;
+        if (levelSize == 1)
+            break;
+    }
+    count = new int[numNodes];
+    fanIn = new int[numNodes];
+    parent = new int[numNodes];
+    sense = new BarrierFlag*[numNodes];
+
+    levelSize = divRoundUp(n, TreeFanIn);
+    for (i = 0; i < levelSize; i++)   // 叶结点的到达者是线程
+        fanIn[i] = min(TreeFanIn, n - i * TreeFanIn);
+    for (levelStart = 0; levelSize > 1; levelStart += levelSize,
+                                        levelSize = nextSize) {
+        nextSize = divRoundUp(levelSize, TreeFanIn);
+        for (i = 0; i < nextSize; i++)  // 内部结点的到达者是子结点
+            fanIn[levelStart + levelSize + i] = 
+                min(TreeFanIn, levelSize - i * TreeFanIn);
+        for (i = 0; i < levelSize; i++)
+            parent[levelStart + i] = levelStart + levelSize + i / TreeFanIn;
+    }
+    parent[numNodes - 1] = -1;
+
+    for (i = 0; i < numNodes; i++) {
+        count[i] = fanIn[i];
+        sense[i] = new BarrierFlag;
+    }
+    localSense = new bool[n];
+    for (i = 0; i < n; i++)
+        localSense[i] = FALSE;
+}
+
+TreeBarrier::~TreeBarrier()
+{
+    for (int i = 0; i < numNodes; i++)
+        delete sense[i];
+    delete [] sense;
+    delete [] count;
+    delete [] fanIn;
+    delete [] parent;
+    delete [] localSense;
+}
+
+//----------------------------------------------------------------------
+// TreeBarrier::Arrive
+// 	到达结点node。最后到达者继续到父结点，从那里返回（整棵树都已
+// 	到齐）后重置本结点并唤醒本结点的等待者；其余线程在本结点等待。
+//----------------------------------------------------------------------
+void TreeBarrier::Arrive(int node, bool mySense)
+{
+    bool last;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    last = (--count[node] == 0);
+    (void) interrupt->SetLevel(oldLevel);
+
+    if (last) {
+        if (parent[node] >= 0)
+            Arrive(parent[node], mySense);
+        count[node] = fanIn[node];  // 本结点的子树都还在等待，可以安全重置
+        sense[node]->Set(mySense);
+    } else
+        sense[node]->WaitFor(mySense);
+}
+
+//----------------------------------------------------------------------
+// TreeBarrier::Wait
+// 	翻转本地sense，从自己的叶结点开始到达
+//----------------------------------------------------------------------
+void TreeBarrier::Wait(int which)
+{
+    localSense[which] = !localSense[which];
+    Arrive(which / TreeFanIn, localSense[which]);
+}
+
+//----------------------------------------------------------------------
+// DisseminationBarrier::DisseminationBarrier
+// 	每个线程每轮每套一个标志，初始都为FALSE；本地sense从TRUE开始
+//----------------------------------------------------------------------
+DisseminationBarrier::DisseminationBarrier(const char* debugName, int n)
+    : Barrier(debugName, n)
+{
+    int i;
+
+    for (rounds = 0; (1 << rounds) < n; rounds++)
+        ;
+    flags = new BarrierFlag*[2 * rounds * n];
+    for (i = 0; i < 2 * rounds * n; i++)
+        flags[i] = new BarrierFlag;
+    parity = new int[n];
+    localSense = new bool[n];
+    for (i = 0; i < n; i++) {
+        parity[i] = 0;
+        localSense[i] = TRUE;
+    }
+}
+
+DisseminationBarrier::~DisseminationBarrier()
+{
+    for (int i = 0; i < 2 * rounds * threadCount; i++)
+        delete flags[i];
+    delete [] flags;
+    delete [] parity;
+    delete [] localSense;
+}
+
+//----------------------------------------------------------------------
+// DisseminationBarrier::Wait
+// 	每轮先通知伙伴，再等待自己的通知。用完第二套标志后翻转sense。
+//----------------------------------------------------------------------
+void DisseminationBarrier::Wait(int which)
+{
+    int r, partner;
+    BarrierFlag **mine = &flags[parity[which] * rounds * threadCount];
+
+    for (r = 0; r < rounds; r++) {
+        partner = (which + (1 << r)) % threadCount;
+        mine[r * threadCount + partner]->Set(localSense[which]);
+        mine[r * threadCount + which]->WaitFor(localSense[which]);
+    }
+    if (parity[which] == 1)
+        localSense[which] = !localSense[which];
+    parity[which] = 1 - parity[which];
+}
@@ -3,19 +3,108 @@
 
 #include "synch.h"
 
+// 所有屏障的公共接口。n个线程编号为0..n-1，每个线程调用Wait(自己的编号)，
+// 直到n个线程都到达后才一起返回。屏障可以反复使用。
 class Barrier {
 public:
     Barrier(const char* debugName, int n);  // 构造函数，n为需要等待的线程数
-    ~Barrier();                            // 析构函数
-    
-    void Wait();                           // 等待所有线程到达屏障点
+    virtual ~Barrier();                     // 析构函数
+    char* getName() { return name; }
 
-private:
+    virtual void Wait(int which) = 0;      // 线程which等待所有线程到达屏障点
+
+protected:
     char* name;                            // 屏障名称，用于调试
     int threadCount;                       // 需要等待的线程总数
+};
+
+// 可以在其上阻塞等待的布尔标志，相当于多处理器上自旋等待的那个变量。
+// 在单处理器的Nachos上自旋只会浪费CPU，所以等待的线程睡眠，
+// Set改变值时把它们放回就绪队列。
+class BarrierFlag {
+public:
+    BarrierFlag();
+    ~BarrierFlag();
+
+    void Set(bool newValue);               // 设置值，唤醒等待该值的线程
+    void WaitFor(bool wanted);             // 等待直到值等于wanted
+
+private:
+    bool value;
+    ThreadQueue* waiters;                  // 在此标志上睡眠的线程
+};
+
+// 原来的信号量实现：最后到达的线程在持有mutex时对barrier做
+// threadCount次V。为了能反复使用加了第二阶段，保留下来作为基准。
+class SemaphoreBarrier : public Barrier {
+public:
+    SemaphoreBarrier(const char* debugName, int n);
+    ~SemaphoreBarrier();
+
+    void Wait(int which);
+
+private:
     int arrivedCount;                      // 已到达屏障的线程数
     Semaphore* mutex;                      // 互斥信号量，保护共享变量
     Semaphore* barrier;                    // 屏障信号量，控制线程通过
+    Semaphore* barrier2;                   // 第二阶段，控制线程离开
+};
+
+// 感应反转的集中式屏障：一个计数器加一个全局sense标志。最后到达的
+// 线程重置计数器并翻转sense，其余线程等待sense变为自己的本地sense。
+// 因为每一轮等待的值都不同，计数器的重置与下一轮的到达之间没有竞争。
+class CentralBarrier : public Barrier {
+public:
+    CentralBarrier(const char* debugName, int n);
+    ~CentralBarrier();
+
+    void Wait(int which);
+
+private:
+    int count;                             // 本轮还未到达的线程数
+    BarrierFlag* sense;                    // 全局sense
+    bool* localSense;                      // 每个线程本轮等待的sense
+};
+
+// 合并树屏障：线程按TreeFanIn个一组分到叶结点上，每个结点的最后到达者
+// 继续到父结点，根结点的最后到达者结束本轮。释放时每个获胜者只唤醒
+// 它所在结点上的等待者，因此唤醒工作分散在O(log n)层上。
+#define TreeFanIn 4
+
+class TreeBarrier : public Barrier {
+public:
+    TreeBarrier(const char* debugName, int n);
+    ~TreeBarrier();
+
+    void Wait(int which);
+
+private:
+    void Arrive(int node, bool mySense);   // 到达结点node
+
+    int numNodes;
+    int* count;                            // 每个结点本轮还未到达的数目
+    int* fanIn;                            // 每个结点的到达者总数
+    int* parent;                           // 父结点，根为-1
+    BarrierFlag** sense;                   // 每个结点的sense
+    bool* localSense;                      // 线程i的叶结点为i/TreeFanIn
+};
+
+// 传播(dissemination)屏障：共ceil(log2 n)轮，第r轮线程i通知线程
+// (i + 2^r) mod n，并等待线程(i - 2^r) mod n的通知。没有任何集中的
+// 计数器，每个线程每轮只唤醒一个线程。标志按parity交替使用两套，
+// 两轮后翻转sense，所以不需要重置。
+class DisseminationBarrier : public Barrier {
+public:
+    DisseminationBarrier(const char* debugName, int n);
+    ~DisseminationBarrier();
+
+    void Wait(int which);
+
+private:
+    int rounds;                            // ceil(log2 n)
+    BarrierFlag** flags;                   // flags[(parity*rounds + r)*n + i]
+    int* parity;                           // 每个线程当前使用的一套标志
+    bool* localSense;
 };
 
-#endif // BARRIER_H
\ No newline at end of file
+#endif // BARRIER_H
@@ -2,101 +2,86 @@
 #include "barrier.h"
 #include "system.h"
 
-#define NUM_THREADS 10  // 测试线程数量
+#define MIN_THREADS 2     // 测试的最少线程数
+#define MAX_THREADS 256   // 测试的最多线程数，每次翻倍
+#define EPISODES    20    // 每次测试中每个线程通过屏障的次数
+#define TICKS_PER_SECOND 1000000  // 一个tick相当于一微秒（见stats.h）
 
-Barrier* barrier;  // 全局屏障对象
+Barrier* barrier;         // 当前测试的屏障对象
+int threadCount;          // 当前测试的线程数
+int arrivals;             // 所有线程到达屏障的总次数，用于检查正确性
+Semaphore* finished;      // 每个线程结束时V一次
 
 //----------------------------------------------------------------------
 // BarrierThread
-// 	测试线程函数，模拟线程到达屏障点的过程
+// 	测试线程函数，连续EPISODES次到达屏障。每次通过屏障后检查所有
+// 	线程都已到达过本轮的屏障点，即没有线程提前通过。
 //
 //	"which" 是线程编号
 //----------------------------------------------------------------------
-void BarrierThread(int which)
+void BarrierThread(_int which)
 {
-    printf("Thread %d: Starting work\n", which);
-    
-    // 模拟一些工作，使用更大的随机循环增加不确定性
-    int work = 5000 + (which * 500) + (Random() % 5000);  // 保持原有基数，增加随机性
-    for (int i = 0; i < work; i++) {
-        // 空循环模拟工作
-        if (i % 50 == 0) {  // 保持原有的让出CPU频率
-            currentThread->Yield();
-        }
-    }
-    
-    // 在到达rendezvous点之前添加随机延迟
-    int randomDelay = Random() % 2000;
-    for (int i = 0; i < randomDelay; i++) {
-        if (i % 30 == 0) {  // 在延迟期间也频繁让出CPU
-            currentThread->Yield();
-        }
+    for (int e = 0; e < EPISODES; e++) {
+        arrivals++;                         // rendezvous
+        barrier->Wait(which);
+        ASSERT(arrivals >= threadCount * (e + 1));  // critical point
     }
-    
-    printf("Thread %d: Reached rendezvous point\n", which);
-    
-    // 等待所有线程到达屏障
-    barrier->Wait();
-    
-    printf("Thread %d: Passed barrier, continuing work\n", which);
-    
-    // 继续执行后续工作
-    for (int i = 0; i < 500; i++) {
-        // 空循环模拟后续工作
+    finished->V();
+}
+
+//----------------------------------------------------------------------
+// MakeBarrier
+// 	按编号创建一种屏障，kind超出范围时返回NULL
+//----------------------------------------------------------------------
+static Barrier* MakeBarrier(int kind, int n)
+{
+    switch (kind) {
+      case 0: return new SemaphoreBarrier("semaphore", n);
+      case 1: return new CentralBarrier("central", n);
+      case 2: return new TreeBarrier("tree", n);
+      case 3: return new DisseminationBarrier("dissemination", n);
+      default: return NULL;
     }
-    
-    printf("Thread %d: Finished\n", which);
 }
 
 //----------------------------------------------------------------------
 // ThreadsBarrier
-// 	初始化并启动N线程屏障测试
+// 	对每种屏障、从MIN_THREADS到MAX_THREADS个线程，测量每模拟秒能
+// 	完成的屏障轮数（所有线程都通过一次为一轮）。输出为逗号分隔，
+// 	可以直接导入表格：
+//	    ./nachos > barrier.csv
+//	加-rs可以让线程在随机位置让出CPU，打乱到达顺序。
 //----------------------------------------------------------------------
 void ThreadsBarrier()
 {
-    barrier = new Barrier("test barrier", NUM_THREADS + 1);  // 10个工作线程 + 1个主线程
-    
-    printf("Starting N-thread barrier test with %d threads\n", NUM_THREADS);
-    printf("Each thread will do some work, then wait at the barrier\n");
-    printf("Only when all threads reach the barrier will they continue\n\n");
-    
-    // 创建并启动测试线程
-    for (int i = 0; i < NUM_THREADS; i++) {
-        char* threadName = new char[16];
-        sprintf(threadName, "Thread %d", i);
-        Thread* t = new Thread(threadName);
-        t->Fork(BarrierThread, i);
-    }
-    
-    // 主线程也参与测试
-    printf("Main thread: Starting work\n");
-    
-    // 模拟主线程的工作，增加随机性
-    int mainWork = 800 + (Random() % 3000);
-    for (int i = 0; i < mainWork; i++) {
-        if (i % 50 == 0) {
-            currentThread->Yield();
-        }
-    }
-    
-    // 在到达rendezvous点之前添加随机延迟
-    int mainRandomDelay = Random() % 2000;
-    for (int i = 0; i < mainRandomDelay; i++) {
-        if (i % 30 == 0) {
-            currentThread->Yield();
+    int kind, i, startTicks, startSwitches, ticks, switches;
+
+    printf("barrier,threads,episodes,ticks,switches,episodes per second\n");
+    for (kind = 0; (barrier = MakeBarrier(kind, 1)) != NULL; kind++) {
+        delete barrier;
+        for (threadCount = MIN_THREADS; threadCount <= MAX_THREADS; 
+             threadCount *= 2) {
+            barrier = MakeBarrier(kind, threadCount);
+            finished = new Semaphore("finished", 0);
+            arrivals = 0;
+
+            startTicks = stats->totalTicks;
+            startSwitches = stats->numContextSwitches;
+            for (i = 0; i < threadCount; i++) {
+                Thread* t = new Thread("barrier thread");
+                t->Fork(BarrierThread, i);
+            }
+            for (i = 0; i < threadCount; i++)
+                finished->P();
+            ticks = stats->totalTicks - startTicks;
+            switches = stats->numContextSwitches - startSwitches;
+            ASSERT(arrivals == threadCount * EPISODES);
+
+            printf("%s,%d,%d,%d,%d,%d\n", barrier->getName(), threadCount,
+                   EPISODES, ticks, switches, 
+                   (int) (EPISODES * (double) TICKS_PER_SECOND / max(ticks, 1)));
+            delete finished;
+            delete barrier;
         }
     }
-    
-    printf("Main thread: Reached rendezvous point\n");
-    barrier->Wait();
-    
-    printf("Main thread: Passed barrier, continuing work\n");
-    
-    // 完成后续工作
-    for (int i = 0; i < 300; i++) {
-        // 空循环
-    }
-    
-    printf("Main thread: Finished\n\n");
-    printf("Barrier test completed\n");
-}
\ No newline at end of file
+}
@@ -331,14 +331,17 @@ Print(char *name)
 #define ContentSize 	strlen(Contents)
 #define FileSize 	((int)(ContentSize * 100))
 
+static bool perfQuiet = FALSE;	// PerformanceBenchmark is timing us
+
 static void 
 FileWrite()
 {
     OpenFile *openFile;    
     int i, numBytes;
 
-    printf("Sequential write of %d byte file, in %d byte chunks\n", 
-	FileSize, ContentSize);
+    if (!perfQuiet)
+	printf("Sequential write of %d byte file, in %d byte chunks\n", 
+	    FileSize, ContentSize);
     if (!fileSystem->Create(FileName, 0)) {
       printf("Perf test: can't create %s\n", FileName);
       return;
@@ -399,8 +402,9 @@ FileRead()
     char *buffer = new char[ContentSize];
     int i, numBytes;
 
-    printf("Sequential read of %d byte file, in %d byte chunks\n", 
-	FileSize, ContentSize);
+    if (!perfQuiet)
+	printf("Sequential read of %d byte file, in %d byte chunks\n", 
+	    FileSize, ContentSize);
 
     if ((openFile = fileSystem->Open(FileName)) == NULL) {
 	printf("Perf test: unable to open file %s\n", FileName);
@@ -434,3 +438,41 @@ PerformanceTest()
     stats->Print();
 }
 
+//----------------------------------------------------------------------
+// PerformanceBenchmark
+// 	Time the performance test on the host: do it "runs" times over,
+//	and print how long that took in real time, in all and per disk
+//	request.  Run it once with -dm and once without, to compare the
+//	two ways of simulating the disk.
+//
+//	Output is comma-separated:
+//	    ./nachos -f -tb 200 > disk.csv
+//	    ./nachos -f -dm -tb 200 | tail -1 >> disk.csv
+//----------------------------------------------------------------------
+
+void
+PerformanceBenchmark(int runs)
+{
+    int requests = stats->numDiskReads + stats->numDiskWrites;
+    double start, elapsed;
+    int i;
+
+    perfQuiet = TRUE;
+    start = WallClock();
+    for (i = 0; i < runs; i++) {
+	FileWrite();
+	FileRead();
+	if (!fileSystem->Remove(FileName)) {
+	    printf("Perf test: unable to remove %s\n", FileName);
+	    break;
+	}
+    }
+    elapsed = WallClock() - start;
+    perfQuiet = FALSE;
+
+    requests = stats->numDiskReads + stats->numDiskWrites - requests;
+    printf("disk,tracks,runs,disk requests,host ms,host us per request\n");
+    printf("%s,%d,%d,%d,%.1f,%.2f\n", diskMapped ? "mapped" : "file",
+	   diskTracks, i, requests, elapsed * 1000.0,
+	   elapsed * 1000000.0 / max(requests, 1));
+}
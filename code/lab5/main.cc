@@ -10,8 +10,9 @@
 //
 // Usage: nachos -d <debugflags> -rs <random seed #>
 //		-s -x <nachos file> -c <consoleIn> <consoleOut>
-//		-f -cp <unix file> <nachos file>
-//		-p <nachos file> -r <nachos file> -l -D -DI -t
+//		-f -ds <# disk tracks> -dm -snap <snapshot> -commit
+//		-cp <unix file> <nachos file>
+//		-p <nachos file> -r <nachos file> -l -D -DI -t -tb <# runs>
 //              -n <network reliability> -m <machine id>
 //              -o <other machine id>
 //              -z
@@ -27,6 +28,10 @@
 //
 //  FILESYS
 //	-f causes the physical disk to be formatted
+//    -ds sets the number of tracks on the disk (format it again, with -f)
+//    -dm maps the disk's UNIX file into memory (see machine/disk.h)
+//    -snap starts the disk from a snapshot, discarding what is written to it
+//    -commit keeps what is written, in the snapshot
 //    -cp copies a file from UNIX to Nachos
 //    -p prints a Nachos file to stdout
 //    -r removes a Nachos file from the file system
@@ -34,6 +39,7 @@
 //    -D prints the contents of the entire file system 
 //    -DI prints disk usage information
 //    -t tests the performance of the Nachos file system
+//    -tb times -t on the host, run that many times (see fstest.cc)
 //
 //  NETWORK
 //    -n sets the network reliability
@@ -60,6 +66,7 @@ extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
 extern void Append(char *unixFile, char *nachosFile, int half);
 extern void NAppend(char *nachosFileFrom, char *nachosFileTo);
 extern void Print(char *file), PerformanceTest(void);
+extern void PerformanceBenchmark(int runs);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out);
 extern void MailTest(int networkID);
 
@@ -150,6 +157,10 @@ main(int argc, char **argv)
             fileSystem->PrintDiskInfo();
 	} else if (!strcmp(*argv, "-t")) {	// performance test
             PerformanceTest();
+	} else if (!strcmp(*argv, "-tb")) {	// time it on the host
+	    ASSERT(argc > 1);
+	    PerformanceBenchmark(atoi(*(argv + 1)));
+	    argCount = 2;
 	}
 #endif // FILESYS
 #ifdef NETWORK
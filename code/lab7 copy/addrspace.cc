@@ -94,7 +94,7 @@ AddrSpace::AddrSpace(OpenFile *executable)
 
     numPages = divRoundUp(size, PageSize);
     size = numPages * PageSize;
-    ASSERT(numPages <= NumPhysPages); 
+    ASSERT(numPages <= (unsigned) NumPhysPages); 
 
     DEBUG('a', "Initializing address space, num pages %d, size %d\n",
           numPages, size);
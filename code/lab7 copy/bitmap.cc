@@ -2,6 +2,10 @@
 //	Routines to manage a bitmap -- an array of bits each of which
 //	can be either on or off.  Represented as an array of integers.
 //
+//	Searches look at a whole word at a time: a word that is all ones
+//	has no clear bit, and otherwise __builtin_ctz of its complement
+//	is the first clear bit in it.
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -22,8 +26,10 @@ BitMap::BitMap(int nitems)
     numBits = nitems;
     numWords = divRoundUp(numBits, BitsInWord);
     map = new unsigned int[numWords];
-    for (int i = 0; i < numBits; i++) 
-        Clear(i);
+    for (int i = 0; i < numWords; i++) 
+        map[i] = 0;
+    numClear = numBits;
+    firstClear = nextFit = 0;
 }
 
 //----------------------------------------------------------------------
@@ -46,8 +52,13 @@ BitMap::~BitMap()
 void
 BitMap::Mark(int which) 
 { 
+    unsigned int bit = 1U << (which % BitsInWord);
+
     ASSERT(which >= 0 && which < numBits);
-    map[which / BitsInWord] |= 1 << (which % BitsInWord);
+    if (!(map[which / BitsInWord] & bit)) {
+	map[which / BitsInWord] |= bit;
+	numClear--;
+    }
 }
     
 //----------------------------------------------------------------------
@@ -60,8 +71,15 @@ BitMap::Mark(int which)
 void 
 BitMap::Clear(int which) 
 {
+    unsigned int bit = 1U << (which % BitsInWord);
+
     ASSERT(which >= 0 && which < numBits);
-    map[which / BitsInWord] &= ~(1 << (which % BitsInWord));
+    if (map[which / BitsInWord] & bit) {
+	map[which / BitsInWord] &= ~bit;
+	numClear++;
+	if (which < firstClear)
+	    firstClear = which;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -82,6 +100,52 @@ BitMap::Test(int which)
 	return FALSE;
 }
 
+//----------------------------------------------------------------------
+// BitMap::NextClear
+// 	Return the number of the first clear bit at or after "from", or
+//	numBits if there is none.
+//----------------------------------------------------------------------
+
+int
+BitMap::NextClear(int from)
+{
+    int w = from / BitsInWord;
+    unsigned int free;
+
+    if (from >= numBits)
+	return numBits;
+    free = ~map[w] & (~0U << (from % BitsInWord));	// ignore bits below
+    while (free == 0) {
+	if (++w >= numWords)
+	    return numBits;
+	free = ~map[w];
+    }
+    return min(w * BitsInWord + __builtin_ctz(free), numBits);
+}
+
+//----------------------------------------------------------------------
+// BitMap::NextSet
+// 	Return the number of the first set bit at or after "from", or
+//	numBits if there is none.
+//----------------------------------------------------------------------
+
+int
+BitMap::NextSet(int from)
+{
+    int w = from / BitsInWord;
+    unsigned int used;
+
+    if (from >= numBits)
+	return numBits;
+    used = map[w] & (~0U << (from % BitsInWord));
+    while (used == 0) {
+	if (++w >= numWords)
+	    return numBits;
+	used = map[w];
+    }
+    return min(w * BitsInWord + __builtin_ctz(used), numBits);
+}
+
 //----------------------------------------------------------------------
 // BitMap::Find
 // 	Return the number of the first bit which is clear.
@@ -94,28 +158,97 @@ BitMap::Test(int which)
 int 
 BitMap::Find() 
 {
-    for (int i = 0; i < numBits; i++)
-	if (!Test(i)) {
-	    Mark(i);
-	    return i;
+    int which;
+
+    if (numClear == 0)
+	return -1;
+    which = NextClear(firstClear);
+    ASSERT(which < numBits);
+    Mark(which);
+    firstClear = which + 1;
+    return which;
+}
+
+//----------------------------------------------------------------------
+// BitMap::FindNext
+// 	Like Find, but start looking where the last FindNext left off,
+//	and wrap around.  Spreads allocations over the whole map, and
+//	does not rescan the crowded low end every time.
+//
+//	If no bits are clear, return -1.
+//----------------------------------------------------------------------
+
+int
+BitMap::FindNext()
+{
+    int which;
+
+    if (numClear == 0)
+	return -1;
+    which = NextClear(nextFit);
+    if (which == numBits)
+	which = NextClear(0);
+    ASSERT(which < numBits);
+    Mark(which);
+    nextFit = which + 1;
+    return which;
+}
+
+//----------------------------------------------------------------------
+// BitMap::FindRun
+// 	Find "n" clear bits in a row, set them, and return the number of
+//	the first.  Look first at or after "hint", then from the start.
+//
+//	If there is no such run, return -1.
+//----------------------------------------------------------------------
+
+int
+BitMap::FindRun(int n, int hint)
+{
+    int start, end, pass, i;
+
+    ASSERT(n > 0);
+    if ((hint < 0) || (hint >= numBits))
+	hint = 0;
+    if (numClear < n)
+	return -1;
+    for (pass = 0; pass < 2; pass++) {
+	start = (pass == 0) ? hint : 0;
+	for (start = NextClear(start); start + n <= numBits; 
+					start = NextClear(end)) {
+	    if ((pass == 1) && (start >= hint))
+		break;			// already looked there
+	    end = NextSet(start);
+	    if (end - start >= n) {
+		for (i = start; i < start + n; i++)
+		    Mark(i);
+		return start;
+	    }
 	}
+    }
     return -1;
 }
 
 //----------------------------------------------------------------------
-// BitMap::NumClear
-// 	Return the number of clear bits in the bitmap.
-//	(In other words, how many bits are unallocated?)
+// BitMap::CountClear
+// 	Count the clear bits, a word at a time, after the map has been 
+//	read in.  Bits past the end of the last word do not count.
 //----------------------------------------------------------------------
 
-int 
-BitMap::NumClear() 
+void
+BitMap::CountClear()
 {
-    int count = 0;
+    int used = 0, w;
+    int tail = numBits % BitsInWord;
 
-    for (int i = 0; i < numBits; i++)
-	if (!Test(i)) count++;
-    return count;
+    for (w = 0; w < numWords; w++) {
+	if ((w == numWords - 1) && (tail != 0))
+	    used += __builtin_popcount(map[w] & ((1U << tail) - 1));
+	else
+	    used += __builtin_popcount(map[w]);
+    }
+    numClear = numBits - used;
+    firstClear = nextFit = 0;
 }
 
 //----------------------------------------------------------------------
@@ -149,6 +282,7 @@ void
 BitMap::FetchFrom(OpenFile *file) 
 {
     file->ReadAt((char *)map, numWords * sizeof(unsigned), 0);
+    CountClear();
 }
 
 //----------------------------------------------------------------------
@@ -166,11 +300,10 @@ BitMap::WriteBack(OpenFile *file)
 
 int
 BitMap::FindIn(int start, int end)  {
-    for(int i=start;i<end;i++){
-        if(!Test(i)){
-            Mark(i);
-            return i;
-        }
-    }
-    return -1;
+    int which = NextClear(start);	// word at a time, as in Find
+
+    if (which >= min(end, numBits))
+        return -1;
+    Mark(which);
+    return which;
 }
\ No newline at end of file
@@ -48,9 +48,11 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 
 // IntType records which hardware device generated an interrupt.
 // In Nachos, we support a hardware timer device, a disk, a console
-// display and keyboard, and a network.
+// display and keyboard, and a network.  AlarmInt is the alarm clock's
+// wakeup (threads/alarm.h); unlike the timer, it keeps Nachos from
+// halting while threads are asleep.
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-				NetworkSendInt, NetworkRecvInt};
+				NetworkSendInt, NetworkRecvInt, AlarmInt};
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
@@ -58,6 +60,7 @@ enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt,
 
 class PendingInterrupt {
   public:
+    PendingInterrupt() {}	// an empty slot, for SortedQueue
     PendingInterrupt(VoidFunctionPtr func, _int param, int time, IntType kind);
 				// initialize an interrupt that will
 				// occur in the future
@@ -19,6 +19,8 @@
 Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
+    numContextSwitches = 0;
+    numDeadlineMisses = numThrottles = 0;
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
@@ -35,6 +37,11 @@ Statistics::Print()
 {
     printf("Ticks: total %d, idle %d, system %d, user %d\n", totalTicks, 
 	idleTicks, systemTicks, userTicks);
+    if (numContextSwitches > 0)
+	printf("Context switches: %d\n", numContextSwitches);
+    if (numDeadlineMisses + numThrottles > 0)
+	printf("Deadlines: missed %d, budgets used up %d\n", 
+	    numDeadlineMisses, numThrottles);
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
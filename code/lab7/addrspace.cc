@@ -95,7 +95,7 @@ AddrSpace::AddrSpace(OpenFile *execFile)
     numPages = divRoundUp(size, PageSize);
     size = numPages * PageSize;
 
-    ASSERT(numPages <= NumPhysPages);		// check we're not trying
+    ASSERT(numPages <= (unsigned) NumPhysPages);		// check we're not trying
 						// to run anything too big --
 						// at least until we have
 						// virtual memory
@@ -388,7 +388,7 @@ int AddrSpace::WriteBack(unsigned int oldPage)
                 ASSERT(swapFile != NULL);  // Ensure swap file can be opened
             }
             // Use a simpler approach: find any available slot in swap space
-            int swapPage = swapMap->Find();
+            int swapPage = swapMap->FindNext();
             if (swapPage >= 0) {
                 pageTable[oldPage].inFileAddr = swapPage * PageSize;
                 swapFile->WriteAt(&(machine->mainMemory[pageTable[oldPage].physicalPage * PageSize]), PageSize,
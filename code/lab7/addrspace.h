@@ -16,7 +16,6 @@
 #include "copyright.h"
 #include "filesys.h"
 #include "bitmap.h"
-#include <queue> // For queue container
 
 #define UserStackSize 1024 // increase this as necessary!
 #define StackPages UserStackSize / PageSize
@@ -28,7 +28,8 @@
 
 static const char *intLevelNames[] = { "off", "on"};
 static const char *intTypeNames[] = { "timer", "disk", "console write", 
-			"console read", "network send", "network recv"};
+			"console read", "network send", "network recv",
+			"alarm"};
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -27,6 +27,11 @@ class Statistics {
     int userTicks;       	// Time spent executing user code
 				// (this is also equal to # of
 				// user instructions executed)
+    int numContextSwitches;	// number of times the CPU changed threads
+    int numDeadlineMisses;	// periods in which a reserved thread
+				// did not get its budget in time
+    int numThrottles;		// times a reserved thread was held back
+				// for having used up its budget
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
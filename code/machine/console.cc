@@ -53,10 +53,14 @@ Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail,
     readHandler = readAvail;
     handlerArg = callArg;
     putBusy = FALSE;
+    putCount = 0;
     incoming = EOF;
+    readEnabled = TRUE;
+    pollPending = FALSE;
+    atEOF = FALSE;
 
     // start polling for incoming packets
-    interrupt->Schedule(ConsoleReadPoll, (_int)this, ConsoleTime, ConsoleReadInt);
+    SchedulePoll();
 }
 
 //----------------------------------------------------------------------
@@ -72,6 +76,22 @@ Console::~Console()
 	Close(writeFileNo);
 }
 
+//----------------------------------------------------------------------
+// Console::SchedulePoll
+// 	Arrange for CheckCharAvail to run after ConsoleTime, unless a 
+//	poll is already pending or the keyboard file has run out.
+//----------------------------------------------------------------------
+
+void
+Console::SchedulePoll()
+{
+    if (pollPending || atEOF)
+	return;
+    pollPending = TRUE;
+    interrupt->Schedule(ConsoleReadPoll, (_int)this, ConsoleTime, 
+			ConsoleReadInt);
+}
+
 //----------------------------------------------------------------------
 // Console::CheckCharAvail()
 // 	Periodically called to check if a character is available for
@@ -81,6 +101,12 @@ Console::~Console()
 //	character has been grabbed out of the buffer by the Nachos kernel).
 //	Invoke the "read" interrupt handler, once the character has been 
 //	put into the buffer. 
+//
+//	Polling is idle-aware: it stops while the kernel has input turned 
+//	off or has not yet taken the buffered character (GetChar and 
+//	EnableRead restart it), and stops for good once the keyboard file
+//	is at end of file.  Otherwise a pending poll would keep the 
+//	simulation from ever going idle.
 //----------------------------------------------------------------------
 
 void
@@ -88,19 +114,40 @@ Console::CheckCharAvail()
 {
     char c;
 
-    // schedule the next time to poll for a packet
-    interrupt->Schedule(ConsoleReadPoll, (_int)this, ConsoleTime, 
-			ConsoleReadInt);
+    pollPending = FALSE;
+    if (!readEnabled || (incoming != EOF))
+	return;
+
+    // nothing typed yet: look again later
+    if (!PollFile(readFileNo)) {
+	SchedulePoll();
+	return;
+    }
+
+    // otherwise, read character and tell user about it; a readable
+    // file that yields nothing is at end of file
+    if (ReadPartial(readFileNo, &c, sizeof(char)) <= 0) {
+	atEOF = TRUE;
+	DEBUG('m', "Console input at end of file, polling stopped\n");
+    } else {
+	incoming = c;
+	stats->numConsoleCharsRead++;
+    }
+    (*readHandler)(handlerArg);	
+}
 
-    // do nothing if character is already buffered, or none to be read
-    if ((incoming != EOF) || !PollFile(readFileNo))
-	return;	  
+//----------------------------------------------------------------------
+// Console::EnableRead
+// 	Turn keyboard input on or off.  While it is off the device does
+//	not poll, so characters stay in the UNIX file until wanted.
+//----------------------------------------------------------------------
 
-    // otherwise, read character and tell user about it
-    Read(readFileNo, &c, sizeof(char));
-    incoming = c ;
-    stats->numConsoleCharsRead++;
-    (*readHandler)(handlerArg);	
+void
+Console::EnableRead(bool on)
+{
+    readEnabled = on;
+    if (on && (incoming == EOF))
+	SchedulePoll();
 }
 
 //----------------------------------------------------------------------
@@ -114,7 +161,7 @@ void
 Console::WriteDone()
 {
     putBusy = FALSE;
-    stats->numConsoleCharsWritten++;
+    stats->numConsoleCharsWritten += putCount;
     (*writeHandler)(handlerArg);
 }
 
@@ -130,6 +177,8 @@ Console::GetChar()
    char ch = incoming;
 
    incoming = EOF;
+   if (readEnabled)
+       SchedulePoll();
    return ch;
 }
 
@@ -141,10 +190,24 @@ Console::GetChar()
 
 void
 Console::PutChar(char ch)
+{
+    PutChars(&ch, 1);
+}
+
+//----------------------------------------------------------------------
+// Console::PutChars()
+// 	Load "n" characters into the transmit FIFO: write them to the
+//	simulated display and schedule a single interrupt for the lot.
+//----------------------------------------------------------------------
+
+void
+Console::PutChars(char *buf, int n)
 {
     ASSERT(putBusy == FALSE);
-    WriteFile(writeFileNo, &ch, sizeof(char));
+    ASSERT((n > 0) && (n <= ConsoleFifoSize));
+    WriteFile(writeFileNo, buf, n);
     putBusy = TRUE;
+    putCount = n;
     interrupt->Schedule(ConsoleWriteDone, (_int)this, ConsoleTime,
 					ConsoleWriteInt);
 }
@@ -26,6 +26,12 @@
 #include "copyright.h"
 #include "utility.h"
 
+// The display side has a small transmit FIFO: up to ConsoleFifoSize
+// characters can be handed to the device at once, and a single
+// "writeDone" interrupt is raised when they have all gone out.
+
+#define ConsoleFifoSize		16
+
 // The following class defines a hardware console device.
 // Input and output to the device is simulated by reading 
 // and writing to UNIX files ("readFile" and "writeFile").
@@ -46,17 +52,24 @@ class Console {
     void PutChar(char ch);	// Write "ch" to the console display, 
 				// and return immediately.  "writeHandler" 
 				// is called when the I/O completes. 
+    void PutChars(char *buf, int n); // Write "n" (<= ConsoleFifoSize)
+				// characters with one completion interrupt
 
     char GetChar();	   	// Poll the console input.  If a char is 
 				// available, return it.  Otherwise, return EOF.
     				// "readHandler" is called whenever there is 
 				// a char to be gotten
 
+    void EnableRead(bool on);	// Turn keyboard polling on or off
+    bool AtEOF() { return atEOF; } // Has the keyboard file run out?
+
 // internal emulation routines -- DO NOT call these. 
     void WriteDone();	 	// internal routines to signal I/O completion
     void CheckCharAvail();
 
   private:
+    void SchedulePoll();	// arrange for the next CheckCharAvail
+
     int readFileNo;			// UNIX file emulating the keyboard 
     int writeFileNo;			// UNIX file emulating the display
     VoidFunctionPtr writeHandler; 	// Interrupt handler to call when 
@@ -67,9 +80,13 @@ class Console {
 					// interrupt handlers
     bool putBusy;    			// Is a PutChar operation in progress?
 					// If so, you can't do another one!
+    int putCount;			// Characters in the current PutChars
     char incoming;    			// Contains the character to be read,
 					// if there is one available. 
 					// Otherwise contains EOF.
+    bool readEnabled;			// Is the kernel accepting input?
+    bool pollPending;			// Is a CheckCharAvail scheduled?
+    bool atEOF;				// Has the keyboard file been exhausted?
 };
 
 #endif // CONSOLE_H
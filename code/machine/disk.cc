@@ -24,6 +24,13 @@
 #define MagicSize 	sizeof(int)
 
 #define DiskSize 	(MagicSize + (NumSectors * SectorSize))
+#define BaseSize 	(MagicSize + (baseSectors * SectorSize))
+				// the part of the UNIX file we use
+
+int diskTracks = 0;
+bool diskMapped = FALSE;
+char *diskSnapshot = NULL;
+bool diskCommit = FALSE;
 
 // dummy procedure because we can't take a pointer of a member function
 static void DiskDone(_int arg) { ((Disk *)arg)->HandleInterrupt(); }
@@ -32,7 +39,15 @@ static void DiskDone(_int arg) { ((Disk *)arg)->HandleInterrupt(); }
 // Disk::Disk()
 // 	Initialize a simulated disk.  Open the UNIX file (creating it
 //	if it doesn't exist), and check the magic number to make sure it's 
-// 	ok to treat it as Nachos disk storage.
+// 	ok to treat it as Nachos disk storage.  Make the file big enough
+//	for diskTracks tracks, working that out first if it isn't set
+//	(disk.h), and map it in if we're to.
+//
+//	If we're to start from a snapshot, the file is the snapshot's,
+//	and we set up an empty delta file for what we write.  Unless we're
+//	to commit to it, the snapshot is only read: it isn't created if
+//	it doesn't exist, or made bigger if it is short, and the sectors
+//	it doesn't have read as zeroes.
 //
 //	"name" -- text name of the file simulating the Nachos disk
 //	"callWhenDone" -- interrupt handler to be called when disk read/write
@@ -44,6 +59,8 @@ Disk::Disk(const char* name, VoidFunctionPtr callWhenDone, _int callArg)
 {
     int magicNum;
     int tmp = 0;
+    int size = 0;
+    char *fileName = (char *) name;
 
     DEBUG('d', "Initializing the disk, 0x%x 0x%x\n", callWhenDone, callArg);
     handler = callWhenDone;
@@ -51,31 +68,133 @@ Disk::Disk(const char* name, VoidFunctionPtr callWhenDone, _int callArg)
     lastSector = 0;
     bufferInit = 0;
     
-    fileno = OpenForReadWrite((char*)name, FALSE);
+    if (diskSnapshot != NULL) {
+	fileName = new char[strlen(name) + strlen(diskSnapshot) + 2];
+	sprintf(fileName, "%s.%s", name, diskSnapshot);
+	DEBUG('d', "Starting from snapshot %s\n", fileName);
+    }
+    readOnly = (diskSnapshot != NULL) && !diskCommit;
+    if (readOnly)
+	fileno = OpenForRead(fileName, FALSE);
+    else
+	fileno = OpenForReadWrite(fileName, FALSE);
     if (fileno >= 0) {		 	// file exists, check magic number 
 	Read(fileno, (char *) &magicNum, MagicSize);
 	ASSERT(magicNum == MagicNumber);
-    } else {				// file doesn't exist, create it
-        fileno = OpenForWrite((char*)name);
-	magicNum = MagicNumber;  
-	WriteFile(fileno, (char *) &magicNum, MagicSize); // write magic number
-
-	// need to write at end of file, so that reads will not return EOF
-        Lseek(fileno, DiskSize - sizeof(int), 0);	
-	WriteFile(fileno, (char *)&tmp, sizeof(int));  
+	Lseek(fileno, 0, 2);
+	size = Tell(fileno);
+	if (diskTracks == 0)		// as big as the file
+	    diskTracks = (size - MagicSize) / (SectorsPerTrack * SectorSize);
+    } else {				// file doesn't exist
+	if (!readOnly) {		// create it
+	    fileno = OpenForWrite(fileName);
+	    magicNum = MagicNumber;  
+	    WriteFile(fileno, (char *) &magicNum, MagicSize);
+	}
+	if (diskTracks == 0)
+	    diskTracks = NumTracks;
+    }
+    ASSERT(diskTracks > 0);
+
+    if (readOnly)
+	baseSectors = (fileno < 0) ? 0 
+			: min((size - (int) MagicSize) / SectorSize, NumSectors);
+    else {
+	baseSectors = NumSectors;
+	if (size < (int) DiskSize) {
+	    // need to write at end of file, so that reads will not return EOF
+	    Lseek(fileno, DiskSize - sizeof(int), 0);	
+	    WriteFile(fileno, (char *)&tmp, sizeof(int));  
+	}
+    }
+
+    image = NULL;
+    unsynced = 0;
+    if (diskMapped && readOnly && (baseSectors > 0))
+	image = MapFileReadOnly(fileno, BaseSize);
+    else if (diskMapped && !readOnly)
+	image = MapFile(fileno, DiskSize);
+
+    deltaFile = -1;
+    delta = NULL;
+    changed = NULL;
+    if (diskSnapshot != NULL) {		// nothing in the delta, yet
+	deltaFile = OpenTemporary(fileName);
+        Lseek(deltaFile, DiskSize - sizeof(int), 0);	
+	WriteFile(deltaFile, (char *)&tmp, sizeof(int));  
+	if (diskMapped)
+	    delta = MapFile(deltaFile, DiskSize);
+	changed = new bool[NumSectors];
+	for (int i = 0; i < NumSectors; i++)
+	    changed[i] = FALSE;
+	delete [] fileName;
     }
     active = FALSE;
 }
 
+//----------------------------------------------------------------------
+// ReadImage, WriteImage
+// 	Read or write a sector of a UNIX file holding disk sectors: with
+//	a copy, if it is mapped in, otherwise with a seek and a read or
+//	write.
+//
+//	"fd" -- the file
+//	"map" -- where it is mapped in, or NULL
+//----------------------------------------------------------------------
+
+static void
+ReadImage(int fd, char *map, int sector, char *data)
+{
+    if (map != NULL)
+	memcpy(data, map + SectorSize * sector + MagicSize, SectorSize);
+    else {
+	Lseek(fd, SectorSize * sector + MagicSize, 0);
+	Read(fd, data, SectorSize);
+    }
+}
+
+static void
+WriteImage(int fd, char *map, int sector, char *data)
+{
+    if (map != NULL)
+	memcpy(map + SectorSize * sector + MagicSize, data, SectorSize);
+    else {
+	Lseek(fd, SectorSize * sector + MagicSize, 0);
+	WriteFile(fd, data, SectorSize);
+    }
+}
+
 //----------------------------------------------------------------------
 // Disk::~Disk()
 // 	Clean up disk simulation, by closing the UNIX file representing the
-//	disk.
+//	disk.  If it is mapped in, first wait for our changes to be written
+//	back to it.
+//
+//	If we started from a snapshot, first commit what we wrote to it,
+//	if we're to, then close the delta file, which removes it.
 //----------------------------------------------------------------------
 
 Disk::~Disk()
 {
-    Close(fileno);
+    char data[SectorSize];
+
+    if (changed != NULL) {
+	for (int i = 0; diskCommit && (i < NumSectors); i++)
+	    if (changed[i]) {
+		ReadImage(deltaFile, delta, i, data);
+		WriteImage(fileno, image, i, data);
+	    }
+	if (delta != NULL)
+	    UnmapFile(delta, DiskSize);
+	Close(deltaFile);
+	delete [] changed;
+    }
+    if ((image != NULL) && !readOnly)
+	SyncMappedFile(image, DiskSize, TRUE);
+    if (image != NULL)
+	UnmapFile(image, BaseSize);
+    if (fileno >= 0)
+	Close(fileno);
 }
 
 //----------------------------------------------------------------------
@@ -108,6 +227,10 @@ PrintSector (bool writing, int sector, char *data)
 //	Note that a disk only allows an entire sector to be read/written,
 //	not part of a sector.
 //
+//	If we started from a snapshot, a sector we have written is read
+//	from the delta file, and every write goes there; one the snapshot
+//	doesn't have reads as zeroes.
+//
 //	"sectorNumber" -- the disk sector to read/write
 //	"data" -- the bytes to be written, the buffer to hold the incoming bytes
 //----------------------------------------------------------------------
@@ -121,8 +244,12 @@ Disk::ReadRequest(int sectorNumber, char* data)
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
     
     DEBUG('d', "Reading from sector %d\n", sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    Read(fileno, data, SectorSize);
+    if ((changed != NULL) && changed[sectorNumber])
+	ReadImage(deltaFile, delta, sectorNumber, data);
+    else if (sectorNumber < baseSectors)
+	ReadImage(fileno, image, sectorNumber, data);
+    else
+	bzero(data, SectorSize);
     if (DebugIsEnabled('d'))
 	PrintSector(FALSE, sectorNumber, data);
     
@@ -141,8 +268,16 @@ Disk::WriteRequest(int sectorNumber, char* data)
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
     
     DEBUG('d', "Writing to sector %d\n", sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    WriteFile(fileno, data, SectorSize);
+    if (changed != NULL) {
+	WriteImage(deltaFile, delta, sectorNumber, data);
+	changed[sectorNumber] = TRUE;
+    } else {
+	WriteImage(fileno, image, sectorNumber, data);
+	if ((image != NULL) && (++unsynced == DiskSyncWrites)) {
+	    SyncMappedFile(image, DiskSize, FALSE);	// start writing
+	    unsynced = 0;				// them back
+	}
+    }
     if (DebugIsEnabled('d'))
 	PrintSector(TRUE, sectorNumber, data);
     
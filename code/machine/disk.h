@@ -45,12 +45,45 @@
 // disks these days now come with a track buffer.
 //
 // The track buffer simulation can be disabled by compiling with -DNOTRACKBUF
+//
+// The number of tracks can be set with -ds; the file system must then be
+// formatted again (-f).  Otherwise it is NumTracks, for a new disk, or
+// as many as there are in the UNIX file, for an existing one.
+//
+// With -dm, the UNIX file is mapped into our memory, and a request
+// just copies the sector, rather than taking two system calls to seek
+// and then read or write it.  Every DiskSyncWrites writes, we ask the
+// host to start writing the changes back to the file; when the disk is
+// deleted, we wait until it has.
+//
+// With -snap, the disk starts out as a named snapshot: the UNIX file
+// DISK.<name> (an empty disk, if there is no such file, and zeroes past
+// its end, if it is short).  The sectors we write go to a delta file of
+// our own, which starts out empty, so that setting up takes no time 
+// however much is on the disk, and which is removed when the disk is 
+// deleted.  With -commit, its sectors are first copied into the 
+// snapshot (which is created, or made big enough, at the start);
+// otherwise they are discarded, and the snapshot is only ever read.
+// So a disk can be formatted and loaded once:
+//
+//	./nachos -snap lab5 -commit -f -cp test/big big
+//
+// and then every run can start from there, as many at once as we like:
+//
+//	./nachos -snap lab5 -t
 
 #define SectorSize 		128	// number of bytes per disk sector
 #define SectorsPerTrack 	32	// number of sectors per disk track 
-#define NumTracks 		32	// number of tracks per disk
-#define NumSectors 		(SectorsPerTrack * NumTracks)
+#define NumTracks 		32	// number of tracks per disk, by default
+#define NumSectors 		(SectorsPerTrack * diskTracks)
 					// total # of sectors per disk
+#define DiskSyncWrites		256	// writes between syncs, with -dm
+
+extern int diskTracks;			// tracks on the disk; 0 until the
+					// disk is set up, unless -ds
+extern bool diskMapped;			// -dm: map the UNIX file in
+extern char *diskSnapshot;		// -snap: start from this snapshot
+extern bool diskCommit;			// -commit: keep what we write to it
 
 class Disk {
   public:
@@ -76,7 +109,19 @@ class Disk {
 					// (seek + rotational delay + transfer)
 
   private:
-    int fileno;				// UNIX file number for simulated disk 
+    int fileno;				// UNIX file number for simulated disk;
+					// -1 if it is a snapshot that
+					// doesn't exist
+    bool readOnly;			// a snapshot we don't commit to
+    int baseSectors;			// sectors the file has; the others
+					// read as zeroes
+    char *image;			// the file, mapped in; NULL if not
+    int unsynced;			// writes since the last sync
+    int deltaFile;			// with a snapshot, UNIX file number
+					// for the sectors we write
+    char *delta;			// it, mapped in; NULL if not
+    bool *changed;			// which sectors are in it; NULL
+					// without a snapshot
     VoidFunctionPtr handler;		// Interrupt handler, to be invoked 
 					// when any disk request finishes
     _int handlerArg;			// Argument to interrupt handler 
@@ -28,7 +28,8 @@
 
 static const char *intLevelNames[] = { "off", "on"};
 static const char *intTypeNames[] = { "timer", "disk", "console write", 
-			"console read", "network send", "network recv"};
+			"console read", "network send", "network recv",
+			"alarm"};
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -60,7 +61,6 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, _int param, int time,
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -69,13 +69,11 @@ Interrupt::Interrupt()
 //----------------------------------------------------------------------
 // Interrupt::~Interrupt
 // 	De-allocate the data structures needed by the interrupt simulation.
+//	The pending queue holds its interrupts by value, and frees itself.
 //----------------------------------------------------------------------
 
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty())
-	    delete (ListElement *)(pending->Remove());
-    delete pending;
 }
 
 //----------------------------------------------------------------------
@@ -146,20 +144,30 @@ Interrupt::Enable()
 //	Two things can cause OneTick to be called:
 //		interrupts are re-enabled
 //		a user instruction is executed
+//
+//	On a simulated multiprocessor (cpu.h), the time goes on the
+//	clock of the CPU taking its turn; afterwards, the CPU furthest 
+//	behind gets the next turn.  If every CPU is halted, we idle 
+//	until an interrupt wakes one up.
 //----------------------------------------------------------------------
 void
 Interrupt::OneTick()
 {
     MachineStatus old = status;
+    int ticks;
 
 // advance simulated time
     if (status == SystemMode) {
-        stats->totalTicks += SystemTick;
+        ticks = SystemTick;
 	stats->systemTicks += SystemTick;
     } else {					// USER_PROGRAM
-	stats->totalTicks += UserTick;
+	ticks = UserTick;
 	stats->userTicks += UserTick;
     }
+    if (numCPUs > 1)
+	currentCPU->Tick(ticks);
+    else
+	stats->totalTicks += ticks;
     DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
 
 // check any pending interrupts are now ready to fire
@@ -176,6 +184,13 @@ Interrupt::OneTick()
 	currentThread->Yield();
 	status = old;
     }
+    if (numCPUs > 1) {			// the next CPU's turn
+	ChangeLevel(IntOn, IntOff);
+	while (!NextCPU())
+	    Idle();
+	ChangeLevel(IntOff, IntOn);
+	status = old;			// ours again
+    }
 }
 
 //----------------------------------------------------------------------
@@ -265,13 +280,13 @@ void
 Interrupt::Schedule(VoidFunctionPtr handler, _int arg, int fromNow, IntType type)
 {
     int when = stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(handler, arg, when, type);
+    PendingInterrupt toOccur(handler, arg, when, type);
 
     DEBUG('i', "Scheduling interrupt handler the %s at time = %d\n", 
 					intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    pending.Insert(toOccur, when);
 }
 
 //----------------------------------------------------------------------
@@ -297,29 +312,30 @@ Interrupt::CheckIfDue(bool advanceClock)
 					// to invoke an interrupt handler
     if (DebugIsEnabled('i'))
 	DumpState();
-    PendingInterrupt *toOccur = 
-		(PendingInterrupt *)pending->SortedRemove(&when);
+    PendingInterrupt toOccur;
 
-    if (toOccur == NULL)		// no pending interrupts
+    if (!pending.Peek(&toOccur, &when))	// no pending interrupts
 	return FALSE;			
 
     if (advanceClock && when > stats->totalTicks) {	// advance the clock
 	stats->idleTicks += (when - stats->totalTicks);
 	stats->totalTicks = when;
-    } else if (when > stats->totalTicks) {	// not time yet, put it back
-	pending->SortedInsert(toOccur, when);
+    } else if (when > stats->totalTicks)	// not time yet, leave it
 	return FALSE;
-    }
+
+    // take it off the queue (by copying it out) before calling the
+    // handler, which may well schedule more interrupts
+    pending.Remove(&toOccur, &when);
 
 // Check if there is nothing more to do, and if so, quit
-    if ((status == IdleMode) && (toOccur->type == TimerInt) 
-				&& pending->IsEmpty()) {
-	 pending->SortedInsert(toOccur, when);
+    if ((status == IdleMode) && (toOccur.type == TimerInt) 
+				&& pending.IsEmpty()) {
+	 pending.Insert(toOccur, when);
 	 return FALSE;
     }
 
     DEBUG('i', "Invoking interrupt handler for the %s at time %d\n", 
-			intTypeNames[toOccur->type], toOccur->when);
+			intTypeNames[toOccur.type], toOccur.when);
 #ifdef USER_PROGRAM
     if (machine != NULL)
     	machine->DelayedLoad(0, 0);
@@ -328,10 +344,9 @@ Interrupt::CheckIfDue(bool advanceClock)
     status = SystemMode;			// whatever we were doing,
 						// we are now going to be
 						// running in the kernel
-    (*(toOccur->handler))(toOccur->arg);	// call the interrupt handler
+    (*(toOccur.handler))(toOccur.arg);	// call the interrupt handler
     status = old;				// restore the machine status
     inHandler = FALSE;
-    delete toOccur;
     return TRUE;
 }
 
@@ -342,10 +357,8 @@ Interrupt::CheckIfDue(bool advanceClock)
 //----------------------------------------------------------------------
 
 static void
-PrintPending(_int arg)
+PrintPending(PendingInterrupt *pend)
 {
-    PendingInterrupt *pend = (PendingInterrupt *)arg;
-
     printf("Interrupt handler %s, scheduled at %d\n", 
 	intTypeNames[pend->type], pend->when);
 }
@@ -363,7 +376,7 @@ Interrupt::DumpState()
 					intLevelNames[level]);
     printf("Pending interrupts:\n");
     fflush(stdout);
-    pending->Mapcar(PrintPending);
+    pending.Mapcar(PrintPending);
     printf("End of pending interrupts\n");
     fflush(stdout);
 }
@@ -37,6 +37,7 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "typedlist.h"
 
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
 enum IntStatus { IntOff, IntOn };
@@ -48,9 +49,11 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 
 // IntType records which hardware device generated an interrupt.
 // In Nachos, we support a hardware timer device, a disk, a console
-// display and keyboard, and a network.
+// display and keyboard, and a network.  AlarmInt is the alarm clock's
+// wakeup (threads/alarm.h); unlike the timer, it keeps Nachos from
+// halting while threads are asleep.
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-				NetworkSendInt, NetworkRecvInt};
+				NetworkSendInt, NetworkRecvInt, AlarmInt};
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
@@ -58,6 +61,7 @@ enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt,
 
 class PendingInterrupt {
   public:
+    PendingInterrupt() {}	// an empty slot, for SortedQueue
     PendingInterrupt(VoidFunctionPtr func, _int param, int time, IntType kind);
 				// initialize an interrupt that will
 				// occur in the future
@@ -114,8 +118,9 @@ class Interrupt {
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    List *pending;		// the list of interrupts scheduled
-				// to occur in the future
+    SortedQueue<PendingInterrupt> pending;
+				// the interrupts scheduled to occur in 
+				// the future, in order of when
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
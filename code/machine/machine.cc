@@ -44,6 +44,21 @@ void CheckEndian()
 #endif
 }
 
+// Size of user memory; may be changed from the command line, but only
+// before the Machine is created.
+int PageSize = SectorSize;
+int NumPhysPages = 32;
+
+// Size and associativity of the TLB; may be changed from the command
+// line.  Compiling with -DUSE_TLB turns the TLB on by default.
+#ifdef USE_TLB
+int TLBSize = 4;
+#else
+int TLBSize = 0;
+#endif
+int TLBWays = 0;			// 0 means fully associative
+bool useASIDs = TRUE;
+
 //----------------------------------------------------------------------
 // Machine::Machine
 // 	Initialize the simulation of user program execution.
@@ -61,15 +76,20 @@ Machine::Machine(bool debug)
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
-#ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-	tlb[i].valid = FALSE;
-    pageTable = NULL;
-#else	// use linear page table
-    tlb = NULL;
+    if (TLBSize > 0) {
+	if ((TLBWays <= 0) || (TLBWays > TLBSize))
+	    TLBWays = TLBSize;
+	ASSERT((TLBSize % TLBWays) == 0);
+	tlbSets = TLBSize / TLBWays;
+	tlb = new TranslationEntry[TLBSize];
+	for (i = 0; i < TLBSize; i++)
+	    tlb[i].valid = FALSE;
+    } else {			// use linear page table
+	tlbSets = 0;
+	tlb = NULL;
+    }
     pageTable = NULL;
-#endif
+    currentASID = 0;
 
     singleStep = debug;
     CheckEndian();
@@ -28,13 +28,24 @@
 
 // Definitions related to the size, and format of user memory
 
-#define PageSize 	SectorSize 	// set the page size equal to
-					// the disk sector size, for
-					// simplicity
+// The page size and the amount of physical memory are chosen at
+// startup (see the -ps and -np flags in system.cc), before the
+// Machine is created.  By default the page size is equal to the
+// disk sector size, for simplicity.
 
-#define NumPhysPages    32
+extern int PageSize;
+extern int NumPhysPages;
 #define MemorySize 	(NumPhysPages * PageSize)
-#define TLBSize		4		// if there is a TLB, make it small
+
+// Likewise the TLB: TLBSize entries (0 means there is no TLB, and a
+// linear page table is used instead), organized as sets of TLBWays
+// entries each.  A virtual page can only be cached in set
+// (vpn % number of sets); TLBWays == TLBSize is fully associative.
+
+extern int TLBSize;			// if there is a TLB, make it small
+extern int TLBWays;
+extern bool useASIDs;			// if FALSE, the kernel flushes the
+					// TLB on every address space switch
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -178,6 +189,9 @@ class Machine {
 
     TranslationEntry *tlb;		// this pointer should be considered 
 					// "read-only" to Nachos kernel code
+    int tlbSets;			// number of sets in the TLB
+    int currentASID;			// only TLB entries tagged with this
+					// address space ID are matched
 
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
@@ -18,6 +18,10 @@
 #include "copyright.h"
 #include "system.h"
 
+bool NetworkSwitched = FALSE;
+int NetworkTime = 100;
+int NetworkByteTime = 0;
+
 // Dummy functions because C++ can't call member functions indirectly 
 static void NetworkReadPoll(_int arg)
 { Network *net = (Network *)arg; net->CheckPktAvail(); }
@@ -45,7 +49,8 @@ Network::Network(NetworkAddress addr, double reliability, double orderability,
     readHandler = readAvail;
     handlerArg = callArg;
     sendBusy = FALSE;
-    inHdr.length = 0;
+    recvHead = recvFull = recvPosted = 0;
+    pollInterval = NetworkTime;
     delayBufFull = FALSE;
     
     sock = OpenSocket();
@@ -63,36 +68,46 @@ Network::~Network()
     DeAssignNameToSocket(sockName);
 }
 
-// if a packet is already buffered, we simply delay reading 
-// the incoming packet.  In real life, the incoming 
-// packet might be dropped if we can't read it in time.
+// read every packet that is waiting, as far as there are posted
+// buffers to put them in; those that don't fit stay on the wire until
+// the next poll.  In real life, they might be dropped if we can't read
+// them in time.
+//
+// The poll interval adapts: back to NetworkTime whenever packets show
+// up, and doubling (up to MaxPollInterval) each time none do.
 void
 Network::CheckPktAvail()
 {
-    // schedule the next time to poll for a packet
-    interrupt->Schedule(NetworkReadPoll, (_int)this, NetworkTime, NetworkRecvInt);
-
-    if (inHdr.length != 0) 	// do nothing if packet is already buffered
-	return;		
-    if (!PollSocket(sock)) 	// do nothing if no packet to be read
-	return;
-
-    // otherwise, read packet in
-    char *buffer = new char[MaxWireSize];
-    ReadFromSocket(sock, buffer, MaxWireSize);
-
-    // divide packet into header and data
-    inHdr = *(PacketHeader *)buffer;
-    ASSERT((inHdr.to == ident) && (inHdr.length <= MaxPacketSize));
-    bcopy(buffer + sizeof(PacketHeader), inbox, inHdr.length);
-    delete []buffer ;
-
-    DEBUG('n', "Network received packet from %d, length %d...\n",
-	  				(int) inHdr.from, inHdr.length);
-    stats->numPacketsRecvd++;
+    char *buffers[NumRecvSlots];
+    PacketHeader *hdr;
+    int room = recvPosted - recvFull, n = 0, i;
+
+    stats->numNetworkPolls++;
+    if ((room > 0) && PollSocket(sock)) {
+	for (i = 0; i < room; i++)
+	    buffers[i] = recvRing[(recvHead + recvFull + i) % NumRecvSlots];
+	n = ReadFromSocketBatch(sock, buffers, room, MaxWireSize);
+	for (i = 0; i < n; i++) {
+	    hdr = (PacketHeader *)buffers[i];
+	    ASSERT((hdr->to == ident) && (hdr->length <= MaxPacketSize));
+	    DEBUG('n', "Network received packet from %d, length %d...\n",
+	  				(int) hdr->from, hdr->length);
+	}
+	recvFull += n;
+	stats->numPacketsRecvd += n;
+    }
 
-    // tell post office that the packet has arrived
-    (*readHandler)(handlerArg);	
+    // schedule the next time to poll for a packet
+    if (n > 0)
+	pollInterval = NetworkTime;
+    else
+	pollInterval = min(2 * pollInterval, MaxPollInterval);
+    interrupt->Schedule(NetworkReadPoll, (_int)this, pollInterval, 
+							NetworkRecvInt);
+
+    // tell post office that packets have arrived
+    if (n > 0)
+	(*readHandler)(handlerArg);	
 }
 
 // notify user that another packet can be sent
@@ -106,20 +121,40 @@ Network::SendDone()
 
 // send a packet by concatenating hdr and data, and schedule
 // an interrupt to tell the user when the next packet can be sent 
+void
+Network::Send(PacketHeader hdr, char* data)
+{
+    ASSERT((hdr.length > 0) && (hdr.length <= MaxPacketSize));
+    *(PacketHeader *)outbox = hdr;
+    bcopy(data, outbox + sizeof(PacketHeader), hdr.length);
+    SendFrame(outbox);
+}
+
+// send a packet that is already in wire format, and schedule
+// an interrupt to tell the user when the next packet can be sent 
 //
 // Note we always pad out a packet to MaxWireSize before putting it into
 // the socket, because it's simpler at the receive end.
 void
-Network::Send(PacketHeader hdr, char* data)
+Network::SendFrame(char *frame)
 {
+    PacketHeader hdr = *(PacketHeader *)frame;
     char toName[32];
 
     ASSERT((sendBusy == FALSE) && (hdr.length > 0) 
 		&& (hdr.length <= MaxPacketSize) && (hdr.from == ident));
     DEBUG('n', "Sending to addr %d, %d bytes... ", hdr.to, hdr.length);
 
-    interrupt->Schedule(NetworkSendDone, (_int)this, NetworkTime, NetworkSendInt);
+    sendBusy = TRUE;
+    pollInterval = NetworkTime;		// expect a reply soon
+    interrupt->Schedule(NetworkSendDone, (_int)this, NetworkTime 
+		+ NetworkByteTime * (sizeof(PacketHeader) + hdr.length), 
+							NetworkSendInt);
 
+    if (NetworkSwitched) {		// the switch decides what happens
+	SendToSocket(sock, frame, MaxWireSize, (char *)"SOCKET_SWITCH");
+	return;
+    }
     if (Random() % 100 >= chanceToWork * 100) { // emulate a lost packet
 	DEBUG('n', "oops, lost it!\n");
 	return;
@@ -132,31 +167,36 @@ Network::Send(PacketHeader hdr, char* data)
 	SendToSocket(sock, delayBuf, MaxWireSize, delayToName);
       }
       sprintf(delayToName, "SOCKET_%d", (int)hdr.to);
-      *(PacketHeader *)delayBuf = hdr;
-      bcopy(data, delayBuf + sizeof(PacketHeader), hdr.length);
+      bcopy(frame, delayBuf, MaxWireSize);
       delayBufFull = TRUE;
       return;
     }
 
     // packet is neither lost nor delayed - send it now
-
     sprintf(toName, "SOCKET_%d", (int)hdr.to);
-    // concatenate hdr and data into a single buffer, and send it out
-    char *buffer = new char[MaxWireSize];
-    *(PacketHeader *)buffer = hdr;
-    bcopy(data, buffer + sizeof(PacketHeader), hdr.length);
-    SendToSocket(sock, buffer, MaxWireSize, toName);
-    delete []buffer;
+    SendToSocket(sock, frame, MaxWireSize, toName);
 }
 
-// read a packet, if one is buffered
-PacketHeader
-Network::Receive(char* data)
+// give the device a buffer for an incoming packet
+void
+Network::PostBuffer(char *buffer)
 {
-    PacketHeader hdr = inHdr;
+    ASSERT(recvPosted < NumRecvSlots);
+    recvRing[(recvHead + recvPosted++) % NumRecvSlots] = buffer;
+}
 
-    inHdr.length = 0;
-    if (hdr.length != 0)
-    	bcopy(inbox, data, hdr.length);
-    return hdr;
+// hand over the oldest arrived packet, if there is one, along with
+// the buffer it is in
+char *
+Network::Receive()
+{
+    char *packet;
+
+    if (recvFull == 0)
+	return NULL;
+    packet = recvRing[recvHead];
+    recvHead = (recvHead + 1) % NumRecvSlots;
+    recvFull--;
+    recvPosted--;
+    return packet;
 }
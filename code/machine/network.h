@@ -49,6 +49,20 @@ class PacketHeader {
 #define MaxPacketSize 	(MaxWireSize - sizeof(struct PacketHeader))	
 				// data "payload" of the largest packet
 
+#define NumRecvSlots	8	// receive buffers the device can hold
+
+// Timing of the network.  Sending a packet takes NetworkTime ticks,
+// plus NetworkByteTime ticks for each byte of it (header included), 
+// so 1/NetworkByteTime is the link bandwidth in bytes per tick.  
+// Both can be set on the command line.  The device polls for incoming
+// packets every NetworkTime ticks while they are arriving, backing off
+// to MaxPollInterval when the network is quiet.
+
+extern bool NetworkSwitched;	// Send everything through bin/netswitch?
+extern int NetworkTime;		// ticks to send a packet (default 100)
+extern int NetworkByteTime;	// and per byte (default 0)
+#define MaxPollInterval	(4 * NetworkTime)
+
 
 // The following class defines a physical network device.  The network
 // is capable of delivering fixed sized packets
@@ -72,6 +86,11 @@ class PacketHeader {
 // without delay.  There is a 10% chance it will be lost, and a 9%
 // chance that it will be delayed.
 //
+// When the machines are joined by the simulated switch (bin/netswitch),
+// every packet is sent to the switch instead, and the switch does all 
+// the dropping and delaying, link by link; "reliability" and 
+// "orderability" are then ignored.
+//
 // Note that you can change the seed for the random number 
 // generator, by changing the arguments to RandomInit() in Initialize().
 // The random number generator is used to choose which packets to drop
@@ -94,13 +113,27 @@ class Network {
 				// dropped, and note that the "from" field of 
 				// the PacketHeader is filled in automatically 
 				// by Send().
+    void SendFrame(char *frame);
+				// Like Send, but the packet is already laid
+				// out as on the wire: a PacketHeader (with
+				// "from" filled in) followed by the data, 
+				// MaxWireSize bytes in all.  The device 
+				// transmits straight out of "frame".
 
-    PacketHeader Receive(char* data);
-    				// Poll the network for incoming messages.  
-				// If there is a packet waiting, copy the 
-				// packet into "data" and return the header.
-				// If no packet is waiting, return a header 
-				// with length 0.
+    void PostBuffer(char *buffer);
+				// Give the device a MaxWireSize buffer to
+				// receive a packet into; it holds up to 
+				// NumRecvSlots.  Packets are only read off 
+				// the wire into posted buffers.
+    char *Receive();
+    				// Take the oldest packet that has arrived, 
+				// if there is one: return the buffer it was
+				// received into (PacketHeader followed by 
+				// the data), which now belongs to the 
+				// caller.  If no packet is waiting, return
+				// NULL.  "readHandler" is called once for 
+				// each batch of arrivals, so call this
+				// until it returns NULL.
 
     void SendDone();		// Interrupt handler, called when message is 
 				// sent
@@ -119,10 +152,12 @@ class Network {
     _int handlerArg;		// Argument to be passed to interrupt handler
 				//   (pointer to post office)
     bool sendBusy;		// Packet is being sent.
-    bool packetAvail;		// Packet has arrived, can be pulled off of
-				//   network
-    PacketHeader inHdr;		// Information about arrived packet
-    char inbox[MaxPacketSize];  // Data for arrived packet
+    char *recvRing[NumRecvSlots]; // Posted buffers: first "recvFull"
+				//   from recvHead hold arrived packets,
+				//   the rest of "recvPosted" are empty
+    int recvHead, recvFull, recvPosted;
+    int pollInterval;		// Ticks until the next poll
+    char outbox[MaxWireSize];	// Where Send lays out a packet
     char delayBuf[MaxWireSize];  // Place to save a delayed packet
     char delayToName[32];       // Place to send delayed packet, eventually
     bool delayBufFull;          // Is delayBuf in use?
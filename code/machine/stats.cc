@@ -19,9 +19,15 @@
 Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
+    numContextSwitches = 0;
+    numDeadlineMisses = numThrottles = 0;
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numNetworkPolls = 0;
+    numPageIns = numZeroFills = numPageOuts = 0;
+    numTLBHits = numTLBMisses = numTLBFlushes = 0;
+    numSyscalls = 0;
 }
 
 //----------------------------------------------------------------------
@@ -35,10 +41,23 @@ Statistics::Print()
 {
     printf("Ticks: total %d, idle %d, system %d, user %d\n", totalTicks, 
 	idleTicks, systemTicks, userTicks);
+    if (numContextSwitches > 0)
+	printf("Context switches: %d\n", numContextSwitches);
+    if (numDeadlineMisses + numThrottles > 0)
+	printf("Deadlines: missed %d, budgets used up %d\n", 
+	    numDeadlineMisses, numThrottles);
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
-    printf("Paging: faults %d\n", numPageFaults);
+    printf("Paging: faults %d, page-ins %d, zero-fills %d, page-outs %d\n", 
+	numPageFaults, numPageIns, numZeroFills, numPageOuts);
+    if (numTLBHits + numTLBMisses > 0)
+	printf("TLB: hits %d, misses %d, flushes %d\n", numTLBHits,
+	    numTLBMisses, numTLBFlushes);
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
+    if (numNetworkPolls > 0)
+	printf("Network polls: %d\n", numNetworkPolls);
+    if (numSyscalls > 0)
+	printf("System calls: %d\n", numSyscalls);
 }
@@ -27,14 +27,27 @@ class Statistics {
     int userTicks;       	// Time spent executing user code
 				// (this is also equal to # of
 				// user instructions executed)
+    int numContextSwitches;	// number of times the CPU changed threads
+    int numDeadlineMisses;	// periods in which a reserved thread
+				// did not get its budget in time
+    int numThrottles;		// times a reserved thread was held back
+				// for having used up its budget
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
+    int numPageIns;		// pages read in from executable or swap
+    int numZeroFills;		// pages zero-filled without any I/O
+    int numPageOuts;		// dirty pages written out to swap
+    int numTLBHits;		// translations found in the TLB
+    int numTLBMisses;		// translations not found in the TLB
+    int numTLBFlushes;		// times the TLB was (partly) invalidated
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numNetworkPolls;	// times the network checked for packets
+    int numSyscalls;		// number of system calls made by user programs
 
     Statistics(); 		// initialize everything to zero
 
@@ -54,7 +67,6 @@ class Statistics {
 #define RotationTime 	500 	// time disk takes to rotate one sector
 #define SeekTime 	500    	// time disk takes to seek past one track
 #define ConsoleTime 	100	// time to read or write one character
-#define NetworkTime 	100   	// time to send or receive one packet
 #define TimerTicks 	100    	// (average) time between timer interrupts
 
 #endif // STATS_H
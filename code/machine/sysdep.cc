@@ -88,6 +88,7 @@ unsigned sleep(unsigned);
 void abort();
 void exit(int);
 int getpagesize();
+int mkstemp(char *name);
 
 #ifndef HOST_ALPHA
 #ifndef HOST_LINUX
@@ -181,6 +182,23 @@ OpenForReadWrite(char *name, bool crashOnError)
     return fd;
 }
 
+//----------------------------------------------------------------------
+// OpenForRead
+// 	Open a file for reading only.
+//	Return the file descriptor, or error if it doesn't exist.
+//
+//	"name" -- file name
+//----------------------------------------------------------------------
+
+int
+OpenForRead(char *name, bool crashOnError)
+{
+    int fd = open(name, O_RDONLY, 0);
+
+    ASSERT(!crashOnError || fd >= 0);
+    return fd;
+}
+
 //----------------------------------------------------------------------
 // Read
 // 	Read characters from an open file.  Abort if read fails.
@@ -270,6 +288,82 @@ Unlink(char *name)
     return (bool)unlink(name);
 }
 
+//----------------------------------------------------------------------
+// OpenTemporary
+// 	Create and open a new file, named "prefix" and a suffix no other
+//	file has, and then delete the name, so that the file goes away
+//	once it is closed.  Return the file descriptor.
+//----------------------------------------------------------------------
+
+int
+OpenTemporary(char *prefix)
+{
+    char *name = new char[strlen(prefix) + 8];
+    int fd;
+
+    sprintf(name, "%s.XXXXXX", prefix);
+    fd = mkstemp(name);
+    ASSERT(fd >= 0);
+    unlink(name);
+    delete [] name;
+    return fd;
+}
+
+//----------------------------------------------------------------------
+// MapFile
+// 	Map the first "size" bytes of an open file into memory, shared,
+//	so that what we store there ends up in the file.  Abort on error.
+//----------------------------------------------------------------------
+
+char *
+MapFile(int fd, int size)
+{
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    ASSERT(addr != MAP_FAILED);
+    return (char *) addr;
+}
+
+//----------------------------------------------------------------------
+// MapFileReadOnly
+// 	Map the first "size" bytes of a file open only for reading into
+//	memory, to be read and not stored into.  Abort on error.
+//----------------------------------------------------------------------
+
+char *
+MapFileReadOnly(int fd, int size)
+{
+    void *addr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+
+    ASSERT(addr != MAP_FAILED);
+    return (char *) addr;
+}
+
+//----------------------------------------------------------------------
+// SyncMappedFile
+// 	Have the changes to a mapped file written back to it.  If "wait",
+//	return only once they have been; otherwise just start them off.
+//----------------------------------------------------------------------
+
+void
+SyncMappedFile(char *addr, int size, bool wait)
+{
+    int retVal = msync(addr, size, wait ? MS_SYNC : MS_ASYNC);
+    ASSERT(retVal == 0);
+}
+
+//----------------------------------------------------------------------
+// UnmapFile
+// 	Undo MapFile.
+//----------------------------------------------------------------------
+
+void
+UnmapFile(char *addr, int size)
+{
+    int retVal = munmap(addr, size);
+    ASSERT(retVal == 0);
+}
+
 //----------------------------------------------------------------------
 // OpenSocket
 // 	Open an interprocess communication (IPC) connection.  For now, 
@@ -378,6 +472,55 @@ ReadFromSocket(int sockID, char *buffer, int packetSize)
     ASSERT(retVal == packetSize);
 }
 
+//----------------------------------------------------------------------
+// ReadFromSocketBatch
+// 	Read up to "count" fixed size packets that are already waiting on 
+//	the IPC port into "buffers", without waiting for more.  Returns 
+//	the number read.  On Linux this is a single recvmmsg call, 
+//	rather than one system call per packet.  Abort on error.
+//----------------------------------------------------------------------
+
+#define MaxSocketBatch	64
+
+int
+ReadFromSocketBatch(int sockID, char **buffers, int count, int packetSize)
+{
+    int retVal, i;
+
+    ASSERT(count <= MaxSocketBatch);
+#ifdef HOST_LINUX
+    struct mmsghdr msgs[MaxSocketBatch];
+    struct iovec iovs[MaxSocketBatch];
+
+    memset(msgs, 0, count * sizeof(struct mmsghdr));
+    for (i = 0; i < count; i++) {
+	iovs[i].iov_base = buffers[i];
+	iovs[i].iov_len = packetSize;
+	msgs[i].msg_hdr.msg_iov = &iovs[i];
+	msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    retVal = recvmmsg(sockID, msgs, count, MSG_DONTWAIT, NULL);
+    if ((retVal < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+	return 0;				// nothing waiting
+    if (retVal < 0)
+	perror("in recvmmsg");
+    ASSERT(retVal >= 0);
+    for (i = 0; i < retVal; i++)
+	ASSERT((int) msgs[i].msg_len == packetSize);
+    return retVal;
+#else
+    for (i = 0; i < count; i++) {
+	retVal = recv(sockID, buffers[i], packetSize, MSG_DONTWAIT);
+	if ((retVal < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+	    break;				// nothing more waiting
+	if (retVal != packetSize)
+	    perror("in recv");
+	ASSERT(retVal == packetSize);
+    }
+    return i;
+#endif
+}
+
 //----------------------------------------------------------------------
 // SendToSocket
 // 	Transmit a fixed size packet to another Nachos' IPC port.
@@ -450,6 +593,21 @@ Delay(int seconds)
     (void) sleep((unsigned) seconds);
 }
 
+//----------------------------------------------------------------------
+// WallClock
+// 	Return the host's time of day, in seconds, to measure how long
+//	something takes in real time rather than in simulated ticks.
+//----------------------------------------------------------------------
+
+double 
+WallClock()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
 //----------------------------------------------------------------------
 // Abort
 // 	Quit and drop core.
@@ -21,6 +21,7 @@ extern bool PollFile(int fd);
 // For simulating the disk and the console devices.
 extern int OpenForWrite(char *name);
 extern int OpenForReadWrite(char *name, bool crashOnError);
+extern int OpenForRead(char *name, bool crashOnError);
 extern void Read(int fd, char *buffer, int nBytes);
 extern int ReadPartial(int fd, char *buffer, int nBytes);
 extern void WriteFile(int fd, char *buffer, int nBytes);
@@ -29,6 +30,13 @@ extern int Tell(int fd);
 extern void Close(int fd);
 //extern bool Unlink(char *name);
 extern int Unlink(char *name);
+extern int OpenTemporary(char *prefix);
+
+// Map an open file into memory, for simulating the disk
+extern char *MapFile(int fd, int size);
+extern char *MapFileReadOnly(int fd, int size);
+extern void SyncMappedFile(char *addr, int size, bool wait);
+extern void UnmapFile(char *addr, int size);
 
 // Interprocess communication operations, for simulating the network
 extern int OpenSocket();
@@ -37,12 +45,15 @@ extern void AssignNameToSocket(char *socketName, int sockID);
 extern void DeAssignNameToSocket(char *socketName);
 extern bool PollSocket(int sockID);
 extern void ReadFromSocket(int sockID, char *buffer, int packetSize);
+extern int ReadFromSocketBatch(int sockID, char **buffers, int count,
+				int packetSize);
 extern void SendToSocket(int sockID, char *buffer, int packetSize,char *toName);
 
 // Process control: abort, exit, and sleep
 extern void Abort();
 extern void Exit(int exitCode);
 extern void Delay(int seconds);
+extern double WallClock();		// host time of day, in seconds
 
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(VoidNoArgFunctionPtr cleanUp);
@@ -10,6 +10,11 @@
 //      In order to introduce some randomness into time-slicing, if "doRandom"
 //      is set, then the interrupt is comes after a random number of ticks.
 //
+//	Restarting the timer doesn't schedule another device interrupt if
+//	one is already due before the new expiry; that one is put off 
+//	until the expiry when it fires.  So only a couple of interrupts 
+//	are ever outstanding, however often the kernel restarts us.
+//
 //	Remember -- nothing in here is part of Nachos.  It is just
 //	an emulation for the hardware that Nachos is running on top of.
 //
@@ -46,24 +51,71 @@ Timer::Timer(VoidFunctionPtr timerHandler, _int callArg, bool doRandom)
     randomize = doRandom;
     handler = timerHandler;
     arg = callArg; 
+    running = FALSE;
 
     // schedule the first interrupt from the timer device
-    interrupt->Schedule(TimerHandler, (_int) this, TimeOfNextInterrupt(), 
-		TimerInt); 
+    Start(TimeOfNextInterrupt());
+}
+
+//----------------------------------------------------------------------
+// Timer::Start
+//      (Re)start the countdown: interrupt "fromNow" ticks from now, 
+//	instead of at whatever time we were going to.
+//----------------------------------------------------------------------
+
+void
+Timer::Start(int fromNow)
+{
+    int when = stats->totalTicks + fromNow, next;
+
+    ASSERT(fromNow > 0);
+    running = TRUE;
+    expiresAt = when;
+    if (scheduled.Peek(NULL, &next) && (next <= when))
+	return;				// that one will do, when it fires
+    interrupt->Schedule(TimerHandler, (_int) this, fromNow, TimerInt);
+    scheduled.Insert(when, when);
+}
+
+//----------------------------------------------------------------------
+// Timer::Stop
+//      Stop counting down.  Interrupts already scheduled are ignored 
+//	when they fire.
+//----------------------------------------------------------------------
+
+void
+Timer::Stop()
+{
+    running = FALSE;
 }
 
 //----------------------------------------------------------------------
 // Timer::TimerExpired
 //      Routine to simulate the interrupt generated by the hardware 
-//	timer device.  Schedule the next interrupt, and invoke the
-//	interrupt handler.
+//	timer device.  If the countdown has ended, schedule the next 
+//	interrupt, and invoke the interrupt handler.  If it was stopped,
+//	ignore the interrupt; if it was restarted later, wait some more.
 //----------------------------------------------------------------------
 void 
 Timer::TimerExpired() 
 {
+    int when, next;
+
+    scheduled.Remove(NULL, &when);	// the interrupt now firing
+    if (!running)
+	return;
+    if ((when < expiresAt) && (expiresAt > stats->totalTicks)) {
+					// restarted since it was scheduled
+	if (!scheduled.Peek(NULL, &next) || (next > expiresAt)) {
+	    interrupt->Schedule(TimerHandler, (_int) this, 
+				expiresAt - stats->totalTicks, TimerInt);
+	    scheduled.Insert(expiresAt, expiresAt);
+	}
+	return;
+    }
+
     // schedule the next timer device interrupt
-    interrupt->Schedule(TimerHandler, (_int) this, TimeOfNextInterrupt(), 
-		TimerInt);
+    Start(TimeOfNextInterrupt());
 
     // invoke the Nachos interrupt handler for this device
     (*handler)(arg);
@@ -11,6 +11,13 @@
 //	In order to introduce some randomness into time-slicing, if "doRandom"
 //	is set, then the interrupt comes after a random number of ticks.
 //
+//	The kernel can also stop the timer, and restart it with a countdown
+//	of its own choosing, so that it need not take interrupts while 
+//	there is no one to switch to ("tickless" operation), and can give 
+//	each thread a time slice of its own.  Each expiry then restarts
+//	the timer with the usual interval, unless the handler says
+//	otherwise.
+//
 //  DO NOT CHANGE -- part of the machine emulation
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
@@ -22,6 +29,7 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "typedlist.h"
 
 // The following class defines a hardware timer. 
 class Timer {
@@ -31,6 +39,11 @@ class Timer {
 				// handler "timerHandler" every time slice.
     ~Timer() {}
 
+    void Start(int fromNow);	// interrupt "fromNow" ticks from now,
+				// instead of whenever we were going to
+    void Stop();		// no more interrupts until Start
+    bool IsStopped() { return !running; }
+
 // Internal routines to the timer emulation -- DO NOT call these
 
     void TimerExpired();	// called internally when the hardware
@@ -44,6 +57,12 @@ class Timer {
     VoidFunctionPtr handler;	// timer interrupt handler 
     _int arg;			// argument to pass to interrupt handler
 
+    bool running;		// counting down?
+    int expiresAt;		// if so, when we interrupt
+    SortedQueue<int> scheduled;	// the device interrupts scheduled and 
+				// not yet fired, by time; interrupts 
+				// can't be cancelled, so a restart may
+				// leave one behind that has to be ignored
 };
 
 #endif // TIMER_H
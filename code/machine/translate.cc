@@ -219,18 +219,23 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	    return PageFaultException;
 	}
 	entry = &pageTable[vpn];
-    } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-    	    if (tlb[i].valid && ((unsigned int)tlb[i].virtualPage == vpn)) {
+    } else {			// only look in the set "vpn" maps to
+	int set = vpn % tlbSets;
+
+        for (entry = NULL, i = set * TLBWays; i < (set + 1) * TLBWays; i++)
+    	    if (tlb[i].valid && ((unsigned int)tlb[i].virtualPage == vpn)
+			&& (tlb[i].asid == currentASID)) {
 		entry = &tlb[i];			// FOUND!
 		break;
 	    }
 	if (entry == NULL) {				// not found
     	    DEBUG('a', "*** no valid TLB entry found for this virtual page!\n");
+	    stats->numTLBMisses++;
     	    return PageFaultException;		// really, this is a TLB fault,
 						// the page may be in memory,
 						// but not in the TLB
 	}
+	stats->numTLBHits++;
     }
 
     if (entry->readOnly && writing) {	// trying to write to a read-only page
@@ -241,7 +246,7 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 
     // if the pageFrame is too big, there is something really wrong! 
     // An invalid translation was loaded into the page table or TLB. 
-    if (pageFrame >= NumPhysPages) { 
+    if (pageFrame >= (unsigned) NumPhysPages) { 
 	DEBUG('a', "*** frame %d > %d!\n", pageFrame, NumPhysPages);
 	return BusErrorException;
     }
@@ -250,6 +255,8 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	entry->dirty = TRUE;
     *physAddr = pageFrame * PageSize + offset;
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
+    if (pageTrace != NULL)
+	pageTrace->Reference(currentASID, vpn);
     DEBUG('a', "phys addr = 0x%x\n", *physAddr);
     return NoException;
 }
@@ -40,6 +40,9 @@ class TranslationEntry {
 			// page is referenced or modified.
     bool dirty;         // This bit is set by the hardware every time the
 			// page is modified.
+    int asid;		// Address space the entry belongs to; only 
+			// used in the TLB, so that entries of several
+			// address spaces can be cached at once.
 };
 
 #endif
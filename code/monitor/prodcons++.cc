@@ -31,6 +31,8 @@
 #define N_CONS    2  // the number of consumers
 #define N_MESSG   3  // the number of messages produced by each producer
 #define MAX_NAME  16 // the maximum lengh of a name
+#define WORK_TICKS 100 // the most simulated time it takes to make or
+                       // record a message
 
 #define MAXLEN	48 
 #define LINELEN	24
@@ -81,7 +83,9 @@ Producer(_int which)
 
       ring->Put(message);
 
-      currentThread->Yield();
+      // take a while over the next message, sleeping rather than
+      // spinning on Yield, so the other threads get the CPU
+      alarmClock->WaitFor(1 + Random() % WORK_TICKS);
     }
 }
 
@@ -127,7 +131,7 @@ Consumer(_int which)
 	    perror("write: write failed");
 	    exit(1);
 	  }
-      currentThread->Yield();
+      alarmClock->WaitFor(1 + Random() % WORK_TICKS);
     }
 }
 
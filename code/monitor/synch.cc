@@ -111,6 +111,7 @@ Lock::Lock(const char* debugName)
     name = (char*)debugName;
     owner = NULL;
     lock = new Semaphore(name,1);
+    nextHeld = NULL;
 }
 
 
@@ -78,6 +78,12 @@ class Lock {
 					// checking in Release, and in
 					// Condition variable ops below.
 
+    // These locks lend no priority to their owner, and never go on
+    // its heldLocks list; these are just for Thread::UpdatePriority.
+    Thread *getOwner() { return owner; }
+    int Demand() { return 99; }		// the lowest priority
+    Lock *nextHeld;
+
   private:
     char* name;				// for debugging
     Thread *owner;                      // remember who acquired the lock
@@ -0,0 +1,63 @@
+#!/bin/sh
+# cluster.sh
+#	Run a benchmark on a cluster of Nachos machines joined by the
+#	simulated switch.  Run it in the network directory, once nachos 
+#	and ../bin/netswitch are built:
+#
+#		./cluster.sh [-n machines] [switch options] all2all|ring|rpc
+#
+#	The switch options (-b, -l, -p, -r, -f, -s) set the link 
+#	bandwidth, latency, loss and reordering; see bin/netswitch.c.
+#	Each machine's output is kept in node<n>.log, the switch's in
+#	switch.log, and all of it is printed at the end.
+#
+# Copyright (c) 1992-1993 The Regents of the University of California.
+# All rights reserved.  See copyright.h for copyright notice and limitation 
+# of liability and disclaimer of warranty provisions.
+
+nodes=4
+switchargs=""
+while [ $# -gt 2 ]; do
+    case "$1" in
+    -n)			nodes=$2 ;;
+    -b|-l|-p|-r|-f|-s)	switchargs="$switchargs $1 $2" ;;
+    *)			break ;;
+    esac
+    shift 2
+done
+if [ $# -ne 1 ]; then
+    echo "usage: $0 [-n machines] [-b bytes/sec] [-l latency ms] [-p loss]" >&2
+    echo "          [-r reorder] [-f link file] [-s seed] all2all|ring|rpc" >&2
+    exit 1
+fi
+test=$1
+
+rm -f SOCKET_*
+../bin/netswitch $switchargs > switch.log 2>&1 &
+switch=$!
+sleep 1
+
+pids=""
+i=0
+while [ $i -lt $nodes ]; do
+    ./nachos -m $i -sw -oc $test $nodes > node$i.log 2>&1 &
+    pids="$pids $!"
+    i=`expr $i + 1`
+done
+
+status=0
+for pid in $pids; do
+    wait $pid || status=1
+done
+kill $switch
+wait $switch
+
+i=0
+while [ $i -lt $nodes ]; do
+    echo "=== machine $i"
+    cat node$i.log
+    i=`expr $i + 1`
+done
+echo "=== switch"
+cat switch.log
+exit $status
@@ -0,0 +1,571 @@
+// fileserver.cc 
+//	Routines for the distributed file service: the server, which 
+//	carries out requests on its own file system, and the client, 
+//	which turns RemoteFile operations into requests and caches the
+//	blocks that come back.
+//
+//	Each request is a FileRequest (followed by the data, for a write)
+//	and each reply a FileReply (followed by the data, for a read), 
+//	sent over the reliable connection between client and server.  
+//	Transfers bigger than MaxTransfer are split into several calls.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "fileserver.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// ServeClientHelper
+// 	Dummy function because C++ can't indirectly invoke member 
+//	functions.  Forked as the thread serving one client.
+//----------------------------------------------------------------------
+
+static FileServer *theServer;
+
+static void ServeClientHelper(_int client)
+{ theServer->ServeClient(client); }
+
+//----------------------------------------------------------------------
+// FileServer::FileServer
+// 	Get ready to serve every other machine in the cluster: open a 
+//	connection to each, and start a thread to handle its requests.
+//
+//	"numMachines" -- machines 0 .. numMachines-1 are in the cluster
+//----------------------------------------------------------------------
+
+FileServer::FileServer(int numMachines)
+{
+    int i, me = postOffice->Address();
+
+    ASSERT(numMachines <= MaxFileClients);
+    lock = new Lock("file server lock");
+    clientDone = new Semaphore("file client done", 0);
+    for (i = 0; i < MaxServerFiles; i++)
+	files[i] = NULL;
+    numClients = 0;
+    theServer = this;
+    for (i = 0; i < numMachines; i++) {
+	clients[i] = NULL;
+	if (i == me)
+	    continue;
+	clients[i] = new Connection(FileServerBox + i, i, FileClientBox);
+	numClients++;
+	(new Thread("file server"))->Fork(ServeClientHelper, i);
+    }
+}
+
+//----------------------------------------------------------------------
+// FileServer::Serve
+// 	Wait until every client has closed its connection.
+//----------------------------------------------------------------------
+
+void
+FileServer::Serve()
+{
+    int i;
+
+    for (i = 0; i < numClients; i++)
+	clientDone->P();
+}
+
+//----------------------------------------------------------------------
+// FileServer::Lookup
+// 	Return the handle for file "name", opening it if no client has
+//	yet; -1 if there is no such file.  Files stay open, and keep their
+//	handles, for as long as the server runs, so that all clients 
+//	agree on them.  Called with the lock held.
+//----------------------------------------------------------------------
+
+int
+FileServer::Lookup(char *name)
+{
+    int i, free = -1;
+
+    for (i = 0; i < MaxServerFiles; i++) {
+	if ((files[i] != NULL) && !strcmp(names[i], name))
+	    return i;
+	if ((files[i] == NULL) && (free < 0))
+	    free = i;
+    }
+    if (free < 0)
+	return -1;
+    files[free] = fileSystem->Open(name);
+    if (files[free] == NULL)
+	return -1;
+    strcpy(names[free], name);
+    versions[free] = 0;
+    return free;
+}
+
+//----------------------------------------------------------------------
+// FileServer::ServeClient
+// 	Carry out the requests of machine "client", one at a time, until
+//	it closes its connection.  Every reply carries the file's current
+//	version and length, which is what the client's leases go by.
+//
+//	The requests come off the network, so check them: a bad file
+//	handle, offset, length or operation gets a reply with status -1.
+//----------------------------------------------------------------------
+
+void
+FileServer::ServeClient(int client)
+{
+    Connection *conn = clients[client];
+    FileRequest request;
+    FileReply reply;
+    char data[MaxTransfer];
+    int id, left, n;
+    bool bad;
+
+    while (conn->ReceiveFully((char *) &request, sizeof(FileRequest))) {
+	bad = (request.op < FsOpen) || (request.op > FsClose)
+		|| (request.offset < 0) || (request.length < 0) 
+		|| (request.length > MaxTransfer);
+	if (request.op == FsWrite) {	// even if bad, take all its data
+	    for (left = max(request.length, 0); left > 0; left -= n) {
+		n = min(left, MaxTransfer);
+		if (!conn->ReceiveFully(data, n))
+		    break;
+	    }
+	    if (left > 0)
+		break;
+	}
+
+	lock->Acquire();
+	id = request.fileId;
+	if (!bad && (request.op == FsOpen)) {
+	    request.name[FileNameMaxLen] = '\0';
+	    id = Lookup(request.name);
+	}
+	if (bad || (id < 0) || (id >= MaxServerFiles) || (files[id] == NULL)) {
+	    reply.status = -1;
+	    reply.version = reply.fileLength = 0;
+	} else {
+	    switch (request.op) {
+	      case FsOpen:
+		reply.status = id;
+		break;
+	      case FsRead:
+		reply.status = files[id]->ReadAt(data, request.length, 
+							request.offset);
+		break;
+	      case FsWrite:
+		reply.status = files[id]->WriteAt(data, request.length, 
+							request.offset);
+		if (reply.status > 0)
+		    versions[id]++;
+		break;
+	      case FsVersion:
+	      case FsClose:
+		reply.status = 0;
+		break;
+	    }
+	    reply.version = versions[id];
+	    reply.fileLength = files[id]->Length();
+	}
+	lock->Release();
+
+	DEBUG('n', "File server: op %d on file %d for %d, status %d\n",
+			request.op, id, client, reply.status);
+	conn->Send((char *) &reply, sizeof(FileReply));
+	if ((request.op == FsRead) && (reply.status > 0))
+	    conn->Send(data, reply.status);
+    }
+    conn->Close();
+    clientDone->V();
+}
+
+//----------------------------------------------------------------------
+// FileClient::FileClient
+// 	Connect to the file server on machine "serverAddr".  The cache 
+//	starts out empty, and on.
+//----------------------------------------------------------------------
+
+FileClient::FileClient(NetworkAddress serverAddr)
+{
+    int i;
+
+    server = new Connection(FileClientBox, serverAddr, 
+				FileServerBox + postOffice->Address());
+    lock = new Lock("file client lock");
+    caching = TRUE;
+    for (i = 0; i < MaxServerFiles; i++) {
+	version[i] = -1;
+	length[i] = 0;
+	leaseExpires[i] = 0;
+    }
+    for (i = 0; i < NumCacheBlocks; i++)
+	blockFile[i] = -1;
+    useClock = 0;
+    calls = hits = misses = revalidations = 0;
+}
+
+//----------------------------------------------------------------------
+// FileClient::~FileClient
+// 	Close the connection, which tells the server we are done.
+//----------------------------------------------------------------------
+
+FileClient::~FileClient()
+{
+    server->Close();
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// FileClient::SetCaching
+// 	Turn the block cache on or off.  Either way, start with it empty.
+//----------------------------------------------------------------------
+
+void
+FileClient::SetCaching(bool on)
+{
+    int i;
+
+    lock->Acquire();
+    caching = on;
+    for (i = 0; i < MaxServerFiles; i++)
+	Forget(i);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// FileClient::Call
+// 	Send "request" (and, for a write, its "data") to the server, and
+//	wait for the reply (and, for a read, the data, into "result").
+//	Returns the reply's status.  Called with the lock held.
+//----------------------------------------------------------------------
+
+int
+FileClient::Call(FileRequest *request, char *data, FileReply *reply,
+			char *result)
+{
+    bool ok;
+
+    calls++;
+    server->Send((char *) request, sizeof(FileRequest));
+    if (request->op == FsWrite)
+	server->Send(data, request->length);
+    ok = server->ReceiveFully((char *) reply, sizeof(FileReply));
+    if (ok && (request->op == FsRead) && (reply->status > 0))
+	ok = server->ReceiveFully(result, reply->status);
+    ASSERT(ok);				// the server went away
+    return reply->status;
+}
+
+//----------------------------------------------------------------------
+// FileClient::Open
+// 	Open file "name" on the server.  Returns NULL if it does not
+//	exist.
+//----------------------------------------------------------------------
+
+RemoteFile *
+FileClient::Open(char *name)
+{
+    FileRequest request;
+    FileReply reply;
+    int id;
+
+    request.op = FsOpen;
+    request.fileId = -1;
+    request.offset = request.length = 0;
+    strncpy(request.name, name, FileNameMaxLen);
+    request.name[FileNameMaxLen] = '\0';
+
+    lock->Acquire();
+    id = Call(&request, NULL, &reply, NULL);
+    if (id >= 0)
+	Learn(id, &reply);
+    lock->Release();
+    if (id < 0)
+	return NULL;
+    return new RemoteFile(this, id);
+}
+
+//----------------------------------------------------------------------
+// FileClient::Learn
+// 	The server says file "fileId" is now at "reply->version".  If 
+//	that is not the version our cached blocks came from, someone 
+//	else has written the file: drop them.  Either way, start a new
+//	lease.  Called with the lock held.
+//----------------------------------------------------------------------
+
+void
+FileClient::Learn(int fileId, FileReply *reply)
+{
+    if (reply->version != version[fileId])
+	Forget(fileId);
+    version[fileId] = reply->version;
+    length[fileId] = reply->fileLength;
+    leaseExpires[fileId] = stats->totalTicks + LeaseTime;
+}
+
+//----------------------------------------------------------------------
+// FileClient::Validate
+// 	If our lease on file "fileId" has run out, ask the server for its
+//	version.  Called with the lock held.
+//----------------------------------------------------------------------
+
+void
+FileClient::Validate(int fileId)
+{
+    FileRequest request;
+    FileReply reply;
+
+    if (stats->totalTicks < leaseExpires[fileId])
+	return;
+    request.op = FsVersion;
+    request.fileId = fileId;
+    request.offset = request.length = 0;
+    revalidations++;
+    Call(&request, NULL, &reply, NULL);
+    Learn(fileId, &reply);
+}
+
+//----------------------------------------------------------------------
+// FileClient::Forget
+// 	Drop every cached block of file "fileId".  Called with the lock
+//	held.
+//----------------------------------------------------------------------
+
+void
+FileClient::Forget(int fileId)
+{
+    int i;
+
+    for (i = 0; i < NumCacheBlocks; i++)
+	if (blockFile[i] == fileId)
+	    blockFile[i] = -1;
+}
+
+//----------------------------------------------------------------------
+// FileClient::ReadBlock
+// 	Make sure block "block" of file "fileId" is in the cache, reading
+//	it from the server into the least recently used slot if not.  
+//	Returns the slot.  Called with the lock held.
+//----------------------------------------------------------------------
+
+int
+FileClient::ReadBlock(int fileId, int block)
+{
+    FileRequest request;
+    FileReply reply;
+    int i, victim = 0;
+
+    for (i = 0; i < NumCacheBlocks; i++) {
+	if ((blockFile[i] == fileId) && (blockNum[i] == block)) {
+	    hits++;
+	    lastUsed[i] = ++useClock;
+	    return i;
+	}
+	if ((blockFile[i] < 0) 
+		|| ((blockFile[victim] >= 0) && (lastUsed[i] < lastUsed[victim])))
+	    victim = i;
+    }
+
+    misses++;
+    request.op = FsRead;
+    request.fileId = fileId;
+    request.offset = block * CacheBlockSize;
+    request.length = CacheBlockSize;
+    blockLength[victim] = max(Call(&request, NULL, &reply, blocks[victim]), 0);
+    blockFile[victim] = fileId;
+    blockNum[victim] = block;
+    lastUsed[victim] = ++useClock;
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// FileClient::Update
+// 	We have written "numBytes" from "from" at "position" in file 
+//	"fileId": change any cached copies of those bytes to match.  A
+//	write that runs on past the end of a short block (the last one 
+//	of the file, say) makes the block that much longer; one that 
+//	starts past its end would leave a gap we know nothing about, so
+//	the block is dropped instead.  Called with the lock held.
+//----------------------------------------------------------------------
+
+void
+FileClient::Update(int fileId, char *from, int numBytes, int position)
+{
+    int i, base, start, end;
+
+    for (i = 0; i < NumCacheBlocks; i++) {
+	if (blockFile[i] != fileId)
+	    continue;
+	base = blockNum[i] * CacheBlockSize;
+	start = max(position, base);
+	end = min(position + numBytes, base + CacheBlockSize);
+	if (start >= end)
+	    continue;
+	if (start > base + blockLength[i]) {
+	    blockFile[i] = -1;
+	    continue;
+	}
+	bcopy(from + start - position, &blocks[i][start - base], end - start);
+	blockLength[i] = max(blockLength[i], end - base);
+    }
+}
+
+//----------------------------------------------------------------------
+// FileClient::Print
+// 	Print how many calls the client made, and how the cache did.
+//----------------------------------------------------------------------
+
+void
+FileClient::Print()
+{
+    printf("File client: calls %d, cache hits %d, misses %d, "
+	   "revalidations %d\n", calls, hits, misses, revalidations);
+}
+
+//----------------------------------------------------------------------
+// RemoteFile::RemoteFile, RemoteFile::~RemoteFile
+// 	A file opened on the server, with handle "id".
+//----------------------------------------------------------------------
+
+RemoteFile::RemoteFile(FileClient *fileClient, int id)
+{
+    client = fileClient;
+    fileId = id;
+    seekPosition = 0;
+}
+
+RemoteFile::~RemoteFile()
+{
+    FileRequest request;
+    FileReply reply;
+
+    request.op = FsClose;
+    request.fileId = fileId;
+    request.offset = request.length = 0;
+    client->lock->Acquire();
+    client->Call(&request, NULL, &reply, NULL);
+    client->lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RemoteFile::ReadAt
+// 	Read up to "numBytes" bytes at "position" into "into", and 
+//	return how many were read (fewer at the end of the file).  With
+//	the cache on, the bytes come from cached blocks; otherwise
+//	straight from the server.
+//----------------------------------------------------------------------
+
+int
+RemoteFile::ReadAt(char *into, int numBytes, int position)
+{
+    FileRequest request;
+    FileReply reply;
+    int done = 0, n, slot, offset;
+
+    client->lock->Acquire();
+    if (!client->caching) {
+	request.op = FsRead;
+	request.fileId = fileId;
+	while (done < numBytes) {
+	    request.offset = position + done;
+	    request.length = min(numBytes - done, MaxTransfer);
+	    n = client->Call(&request, NULL, &reply, into + done);
+	    if (n <= 0)
+		break;
+	    done += n;
+	}
+	client->lock->Release();
+	return done;
+    }
+
+    client->Validate(fileId);
+    numBytes = min(numBytes, client->length[fileId] - position);
+    while (done < numBytes) {
+	slot = client->ReadBlock(fileId, (position + done) / CacheBlockSize);
+	offset = (position + done) % CacheBlockSize;
+	n = min(numBytes - done, client->blockLength[slot] - offset);
+	if (n <= 0)
+	    break;
+	bcopy(&client->blocks[slot][offset], into + done, n);
+	done += n;
+    }
+    client->lock->Release();
+    return done;
+}
+
+//----------------------------------------------------------------------
+// RemoteFile::WriteAt
+// 	Write "numBytes" bytes from "from" at "position", straight 
+//	through to the server, and return how many were written.  Our 
+//	own cached copies are updated -- unless the version shows someone
+//	else wrote the file meanwhile, in which case they are dropped.
+//----------------------------------------------------------------------
+
+int
+RemoteFile::WriteAt(char *from, int numBytes, int position)
+{
+    FileRequest request;
+    FileReply reply;
+    int done = 0, n;
+
+    client->lock->Acquire();
+    request.op = FsWrite;
+    request.fileId = fileId;
+    while (done < numBytes) {
+	request.offset = position + done;
+	request.length = min(numBytes - done, MaxTransfer);
+	n = client->Call(&request, from + done, &reply, NULL);
+	if (n <= 0)
+	    break;
+	if (client->caching) {
+	    if (reply.version == client->version[fileId] + 1) {
+		client->Update(fileId, from + done, n, position + done);
+		client->version[fileId] = reply.version;
+	    }
+	    client->Learn(fileId, &reply);
+	}
+	done += n;
+    }
+    client->lock->Release();
+    return done;
+}
+
+//----------------------------------------------------------------------
+// RemoteFile::Read, RemoteFile::Write
+// 	Read or write at the current position, and move past the bytes
+//	transferred.
+//----------------------------------------------------------------------
+
+int
+RemoteFile::Read(char *into, int numBytes)
+{
+    int n = ReadAt(into, numBytes, seekPosition);
+
+    seekPosition += n;
+    return n;
+}
+
+int
+RemoteFile::Write(char *from, int numBytes)
+{
+    int n = WriteAt(from, numBytes, seekPosition);
+
+    seekPosition += n;
+    return n;
+}
+
+//----------------------------------------------------------------------
+// RemoteFile::Length
+// 	Return the file's length, as of our lease.
+//----------------------------------------------------------------------
+
+int
+RemoteFile::Length()
+{
+    int n;
+
+    client->lock->Acquire();
+    client->Validate(fileId);
+    n = client->length[fileId];
+    client->lock->Release();
+    return n;
+}
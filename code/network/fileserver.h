@@ -0,0 +1,161 @@
+// fileserver.h 
+//	Data structures for a distributed file service: one machine 
+//	exports its Nachos file system, and others use its files over the
+//	network.
+//
+//	The server keeps a reliable connection (see transport.h) to each
+//	client machine, and a thread per client that carries out its 
+//	requests.  On the client, a RemoteFile has the same ReadAt/WriteAt
+//	interface as an OpenFile; each call turns into remote procedure 
+//	calls to the server, unless the data is in the client's cache.
+//
+//	The cache holds whole blocks.  Writes go straight through to the
+//	server.  Every file has a version number, bumped by each write; a
+//	client holds a lease on each file for LeaseTime ticks, during 
+//	which it trusts its cached blocks.  Once the lease runs out, the
+//	next access asks the server for the version, and drops the file's
+//	cached blocks if another machine has written it since.  So a 
+//	client sees other machines' writes at most LeaseTime late, and its
+//	own at once.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FILESERVER_H
+#define FILESERVER_H
+
+#include "copyright.h"
+#include "transport.h"
+#include "openfile.h"
+#include "directory.h"
+
+#define FileServerBox	16	// server's box for client n is this + n
+#define FileClientBox	15	// client's box for the server
+#define MaxFileClients	(NumMailBoxes - FileServerBox)
+#define MaxServerFiles	32	// files the server can have open at once
+#define MaxTransfer	128	// most data in one request or reply
+#define CacheBlockSize	128	// bytes in a cached block
+#define NumCacheBlocks	32	// blocks in a client's cache
+#define LeaseTime	(200 * NetworkTime)	// ticks a client trusts
+						// its cache without asking
+
+// Requests from client to server
+enum FileOp { FsOpen, FsRead, FsWrite, FsVersion, FsClose };
+
+// The following class defines a request.  A write's data follows it.
+
+class FileRequest {
+  public:
+    int op;			// FileOp
+    int fileId;			// Server's handle for the file
+    int offset, length;		// Byte range to read or write
+    char name[FileNameMaxLen + 1];	// File to open
+};
+
+// The following class defines a reply.  A read's data follows it.
+
+class FileReply {
+  public:
+    int status;			// Bytes read or written, or for an
+				// open, the file's handle (-1 on error)
+    int version;		// File's version now
+    int fileLength;		// File's length now
+};
+
+// The following class defines the file server.  Each client is 
+// served by its own thread; Serve returns once every client has 
+// closed its connection.
+
+class FileServer {
+  public:
+    FileServer(int numMachines);	// Serve machines 0 .. numMachines-1,
+				// except this one
+    void Serve();		// Wait until every client is done
+
+    void ServeClient(int client);	// Internal routine: a client's
+				// thread
+
+  private:
+    int Lookup(char *name);	// Find or open "name"; return its handle
+
+    Connection *clients[MaxFileClients];
+    OpenFile *files[MaxServerFiles];	// Open files, by handle
+    char names[MaxServerFiles][FileNameMaxLen + 1];
+    int versions[MaxServerFiles];
+    Lock *lock;			// One file system operation at a time
+    Semaphore *clientDone;	// V'ed as each client leaves
+    int numClients;
+};
+
+// The following class defines a client's view of the service: its 
+// connection to the server, and its block cache.
+
+class RemoteFile;
+
+class FileClient {
+  public:
+    FileClient(NetworkAddress server);
+    ~FileClient();		// Close the connection to the server
+
+    RemoteFile *Open(char *name);	// Open a file on the server; NULL
+				// if it does not exist
+    void SetCaching(bool on);	// Turn the cache on or off (default on)
+
+    void Print();		// Print RPC and cache statistics
+
+  private:
+    friend class RemoteFile;
+
+    int Call(FileRequest *request, char *data, FileReply *reply,
+		char *result);	// Make one remote procedure call
+    void Validate(int fileId);	// Renew the lease on a file if need be
+    void Learn(int fileId, FileReply *reply);	// Note the version and
+				// length the server reported
+    void Forget(int fileId);	// Drop the file's cached blocks
+    int ReadBlock(int fileId, int block);	// Get a block into the 
+				// cache; returns its slot
+    void Update(int fileId, char *from, int numBytes, int position);
+				// Apply our own write to cached blocks
+
+    Connection *server;
+    Lock *lock;			// One call at a time
+    bool caching;		// Use the cache at all?
+
+    int version[MaxServerFiles];	// Version of each file our
+				// cached blocks are from
+    int length[MaxServerFiles];	// Length of each file, last we heard
+    int leaseExpires[MaxServerFiles];	// When to ask again
+
+    char blocks[NumCacheBlocks][CacheBlockSize];	// The cache
+    int blockFile[NumCacheBlocks];	// File of each block, -1 if empty
+    int blockNum[NumCacheBlocks];	// Which block of the file
+    int blockLength[NumCacheBlocks];	// Valid bytes in it
+    int lastUsed[NumCacheBlocks];	// For LRU replacement
+    int useClock;
+
+    int calls, hits, misses, revalidations;	// statistics
+};
+
+// The following class defines a file on the server, as seen by a
+// client.  The interface matches OpenFile.
+
+class RemoteFile {
+  public:
+    RemoteFile(FileClient *client, int fileId);
+    ~RemoteFile();		// Tell the server we are done with it
+
+    int ReadAt(char *into, int numBytes, int position);
+    int WriteAt(char *from, int numBytes, int position);
+    int Read(char *into, int numBytes);
+    int Write(char *from, int numBytes);
+    void Seek(int position) { seekPosition = position; }
+    int Length();
+
+  private:
+    FileClient *client;
+    int fileId;			// Server's handle
+    int seekPosition;
+};
+
+#endif // FILESERVER_H
@@ -7,15 +7,38 @@
 //		./nachos -m 0 -o 1 &
 //		./nachos -m 1 -o 0 &
 //
+//	StreamTest measures the reliable transport the same way, and is
+//	meant to be run over a lossy network:
+//		./nachos -n 0.9 -e 0.9 -m 0 -ot 1 &
+//		./nachos -n 0.9 -e 0.9 -m 1 -ot 0 &
+//
+//	RateTest measures raw message rate through the post office, and 
+//	needs a network that does not lose packets (no -n):
+//		./nachos -m 0 -om 1 &
+//		./nachos -m 1 -om 0 &
+//
+//	ClusterTest runs one of a set of benchmarks on N machines joined by
+//	the simulated switch; cluster.sh starts the switch and the machines.
+//
+//	FileServerTest and FileClientTest measure the distributed file 
+//	service.  Put a file on the server's disk, then start the server
+//	and a client or two:
+//		./nachos -m 0 -f -cp ../test/halt.c halt.c -fsrv 3 &
+//		./nachos -m 1 -fcli 0 halt.c &
+//		./nachos -m 2 -fcli 0 halt.c &
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
 
 #include "copyright.h"
+#include <stdlib.h>
 
 #include "system.h"
 #include "network.h"
 #include "post.h"
+#include "transport.h"
+#include "fileserver.h"
 #include "interrupt.h"
 
 // Test out message delivery, by doing the following:
@@ -65,3 +88,458 @@ MailTest(int farAddr)
     // Then we're done!
     interrupt->Halt();
 }
+
+// Parameters of the stream test
+#define StreamBox	2		// mailbox used at both ends
+#define StreamBytes	8192		// bytes sent each way
+#define ExchangeRounds	50		// round trips timed for latency
+
+static Semaphore *senderDone;
+
+//----------------------------------------------------------------------
+// StreamSender
+// 	Send StreamBytes of a known pattern down the connection, so the
+//	other end can check that nothing was lost, repeated or reordered.
+//----------------------------------------------------------------------
+
+static void
+StreamSender(_int arg)
+{
+    Connection *conn = (Connection *) arg;
+    char buffer[256];
+    int sent, i;
+
+    for (sent = 0; sent < StreamBytes; sent += sizeof(buffer)) {
+	for (i = 0; i < (int) sizeof(buffer); i++)
+	    buffer[i] = (char) ((sent + i) % 251);
+	conn->Send(buffer, sizeof(buffer));
+    }
+    senderDone->V();
+}
+
+//----------------------------------------------------------------------
+// ReceiveFully
+// 	Read exactly "size" bytes from the connection.
+//----------------------------------------------------------------------
+
+static void
+ReceiveFully(Connection *conn, char *data, int size)
+{
+    bool ok = conn->ReceiveFully(data, size);
+
+    ASSERT(ok);				// the other end closed early
+}
+
+//----------------------------------------------------------------------
+// StreamTest
+// 	Benchmark the reliable transport against the machine "farAddr",
+//	which must be running StreamTest too:
+//	  1. both ends send StreamBytes at once, and check what arrives;
+//	  2. the two ends pass a counter back and forth ExchangeRounds 
+//	     times, to time a round trip;
+//	  3. both ends close the connection.
+//	Times are in ticks of this machine's simulated clock.
+//----------------------------------------------------------------------
+
+void
+StreamTest(int farAddr)
+{
+    Connection *conn = new Connection(StreamBox, farAddr, StreamBox);
+    char buffer[256];
+    int received, start, i, n, ticks;
+
+    senderDone = new Semaphore("stream sender done", 0);
+
+    // 1. throughput
+    start = stats->totalTicks;
+    (new Thread("stream sender"))->Fork(StreamSender, (_int) conn);
+    for (received = 0; received < StreamBytes; received += n) {
+	n = conn->Receive(buffer, sizeof(buffer));
+	ASSERT(n > 0);
+	for (i = 0; i < n; i++)
+	    ASSERT(buffer[i] == (char) ((received + i) % 251));
+    }
+    senderDone->P();
+    ticks = stats->totalTicks - start;
+    printf("Stream: %d bytes each way in %d ticks, %d bytes per 1000 ticks\n",
+		StreamBytes, ticks, (int) (StreamBytes * 1000.0 / ticks));
+
+    // 2. latency
+    start = stats->totalTicks;
+    for (i = 0; i < ExchangeRounds; i++) {
+	conn->Send((char *) &i, sizeof(int));
+	ReceiveFully(conn, (char *) &n, sizeof(int));
+	ASSERT(n == i);
+    }
+    ticks = stats->totalTicks - start;
+    printf("Exchange: %d round trips, %d ticks each\n", ExchangeRounds,
+						ticks / ExchangeRounds);
+
+    // 3. shut down cleanly
+    conn->Close();
+    conn->Print();
+    fflush(stdout);
+    interrupt->Halt();
+}
+
+// Parameters of the message rate test
+#define RateBox		3		// mailbox the messages go to
+#define RateDoneBox	4		// mailbox for the final reply
+#define RateMessages	5000		// messages sent
+
+//----------------------------------------------------------------------
+// RateTest
+// 	Benchmark message rate against the machine "farAddr", which must
+//	be running RateTest too.  The machine with the lower ID sends 
+//	RateMessages full-size messages as fast as it can; the other 
+//	takes each one in place (no copy) and releases it, then replies
+//	once it has them all.  Both print the rate on their own clock, 
+//	and how many mail buffers were ever in use -- the pools are 
+//	fixed, so the steady state does no allocation.
+//----------------------------------------------------------------------
+
+void
+RateTest(int farAddr)
+{
+    PacketHeader outPktHdr, inPktHdr;
+    MailHeader outMailHdr, inMailHdr;
+    char buffer[MaxMailSize];
+    Mail *mail;
+    int i, start = 0, ticks;
+
+    outPktHdr.to = farAddr;
+    if (postOffice->Address() < farAddr) {	// sender
+	outMailHdr.to = RateBox;
+	outMailHdr.from = RateDoneBox;
+	outMailHdr.length = MaxMailSize;
+	start = stats->totalTicks;
+	for (i = 0; i < RateMessages; i++) {
+	    *(int *) buffer = i;
+	    postOffice->Send(outPktHdr, outMailHdr, buffer);
+	}
+	postOffice->Receive(RateDoneBox, &inPktHdr, &inMailHdr, buffer);
+	ticks = stats->totalTicks - start;
+	printf("Sent %d messages in %d ticks\n", RateMessages, ticks);
+    } else {					// receiver
+	for (i = 0; i < RateMessages; i++) {
+	    mail = postOffice->Receive(RateBox);
+	    if (i == 0)
+		start = stats->totalTicks;
+	    ASSERT(*(int *) mail->data == i);	// no loss, no reordering
+	    postOffice->Release(mail);
+	}
+	ticks = stats->totalTicks - start;
+	outMailHdr.to = RateDoneBox;
+	outMailHdr.from = RateBox;
+	outMailHdr.length = 1;
+	postOffice->Send(outPktHdr, outMailHdr, buffer);
+	printf("Received %d messages in %d ticks\n", RateMessages, ticks);
+    }
+    printf("Rate: %d messages per 1000 ticks\n", 
+		(int) (RateMessages * 1000.0 / ticks));
+    postOffice->PrintPools();
+    fflush(stdout);
+    interrupt->Halt();
+}
+
+// Parameters of the cluster benchmarks
+#define ClusterBox	8		// mailbox for the connection to 
+					// machine n is ClusterBox + n
+#define MaxClusterNodes	(NumMailBoxes - ClusterBox)
+#define ClusterMsgSize	16		// bytes in each message
+#define AllToAllMessages 100		// messages to each other machine
+#define RingLaps	100		// times round the ring
+#define RpcCalls	200		// calls by each client
+
+static Connection *peers[MaxClusterNodes];	// to each other machine
+static int myId, numNodes;
+static int *latencies, numLatencies;	// in ticks
+static Semaphore *peerDone;
+
+//----------------------------------------------------------------------
+// AllToAllReceiver
+// 	Take AllToAllMessages messages from machine "peer", checking that
+//	they are in order.
+//----------------------------------------------------------------------
+
+static void
+AllToAllReceiver(_int peer)
+{
+    char msg[ClusterMsgSize];
+    int i;
+
+    for (i = 0; i < AllToAllMessages; i++) {
+	ReceiveFully(peers[peer], msg, ClusterMsgSize);
+	ASSERT(*(int *) msg == i);
+    }
+    peerDone->V();
+}
+
+//----------------------------------------------------------------------
+// AllToAll
+// 	Every machine sends AllToAllMessages messages to every other one,
+//	round robin, while a thread per peer takes in what arrives.
+//	Returns the number of messages received.
+//----------------------------------------------------------------------
+
+static int
+AllToAll()
+{
+    char msg[ClusterMsgSize];
+    int i, j;
+
+    for (j = 0; j < numNodes; j++)
+	if (j != myId)
+	    (new Thread("all to all receiver"))->Fork(AllToAllReceiver, j);
+    for (i = 0; i < AllToAllMessages; i++) {
+	*(int *) msg = i;
+	for (j = 0; j < numNodes; j++)
+	    if (j != myId)
+		peers[j]->Send(msg, ClusterMsgSize);
+    }
+    for (j = 1; j < numNodes; j++)
+	peerDone->P();
+    return AllToAllMessages * (numNodes - 1);
+}
+
+//----------------------------------------------------------------------
+// Ring
+// 	Pass a token round the ring RingLaps times.  Machine 0 starts 
+//	each lap and times it.  Returns the number of messages received.
+//----------------------------------------------------------------------
+
+static int
+Ring()
+{
+    Connection *next = peers[(myId + 1) % numNodes];
+    Connection *prev = peers[(myId + numNodes - 1) % numNodes];
+    char msg[ClusterMsgSize];
+    int lap, start;
+
+    for (lap = 0; lap < RingLaps; lap++) {
+	if (myId == 0) {
+	    start = stats->totalTicks;
+	    *(int *) msg = lap;
+	    next->Send(msg, ClusterMsgSize);
+	    ReceiveFully(prev, msg, ClusterMsgSize);
+	    latencies[numLatencies++] = stats->totalTicks - start;
+	} else {
+	    ReceiveFully(prev, msg, ClusterMsgSize);
+	    next->Send(msg, ClusterMsgSize);
+	}
+	ASSERT(*(int *) msg == lap);
+    }
+    return RingLaps;
+}
+
+//----------------------------------------------------------------------
+// RpcServer
+// 	Answer RpcCalls requests from machine "client".
+//----------------------------------------------------------------------
+
+static void
+RpcServer(_int client)
+{
+    char msg[ClusterMsgSize];
+    int i;
+
+    for (i = 0; i < RpcCalls; i++) {
+	ReceiveFully(peers[client], msg, ClusterMsgSize);
+	(*(int *) msg)++;
+	peers[client]->Send(msg, ClusterMsgSize);
+    }
+    peerDone->V();
+}
+
+//----------------------------------------------------------------------
+// Rpc
+// 	Machine 0 is a server, with a thread per client; every other 
+//	machine makes RpcCalls calls to it, one at a time, and times each
+//	one.  Returns the number of messages received.
+//----------------------------------------------------------------------
+
+static int
+Rpc()
+{
+    char msg[ClusterMsgSize];
+    int i, start;
+
+    if (myId == 0) {
+	for (i = 1; i < numNodes; i++)
+	    (new Thread("rpc server"))->Fork(RpcServer, i);
+	for (i = 1; i < numNodes; i++)
+	    peerDone->P();
+	return RpcCalls * (numNodes - 1);
+    }
+    for (i = 0; i < RpcCalls; i++) {
+	start = stats->totalTicks;
+	*(int *) msg = i;
+	peers[0]->Send(msg, ClusterMsgSize);
+	ReceiveFully(peers[0], msg, ClusterMsgSize);
+	ASSERT(*(int *) msg == i + 1);
+	latencies[numLatencies++] = stats->totalTicks - start;
+    }
+    return RpcCalls;
+}
+
+//----------------------------------------------------------------------
+// CompareInts
+// 	Order integers, for qsort.
+//----------------------------------------------------------------------
+
+static int
+CompareInts(const void *a, const void *b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+//----------------------------------------------------------------------
+// ClusterTest
+// 	Run benchmark "test" -- "all2all", "ring" or "rpc" -- as machine
+//	"myId" of "nodes", all of them joined by the switch.  Each machine
+//	opens a connection to every other (so the benchmarks see a 
+//	reliable network however lossy the links), runs the benchmark,
+//	and prints its message rate, per 1000 simulated ticks and per 
+//	second of real time, and the spread of its latencies.
+//----------------------------------------------------------------------
+
+void
+ClusterTest(char *test, int nodes)
+{
+    int j, messages, start, ticks;
+    double wallStart, seconds;
+
+    myId = postOffice->Address();
+    numNodes = nodes;
+    ASSERT((numNodes >= 2) && (numNodes <= MaxClusterNodes) 
+				&& (myId < numNodes));
+    for (j = 0; j < numNodes; j++)
+	if (j != myId)
+	    peers[j] = new Connection(ClusterBox + j, j, ClusterBox + myId);
+    peerDone = new Semaphore("peer done", 0);
+    latencies = new int[RpcCalls + RingLaps];
+    numLatencies = 0;
+
+    start = stats->totalTicks;
+    wallStart = WallClock();
+    if (!strcmp(test, "all2all"))
+	messages = AllToAll();
+    else if (!strcmp(test, "ring"))
+	messages = Ring();
+    else if (!strcmp(test, "rpc"))
+	messages = Rpc();
+    else {
+	printf("Unknown cluster test %s: use all2all, ring or rpc\n", test);
+	messages = 0;
+    }
+    ticks = stats->totalTicks - start;
+    seconds = WallClock() - wallStart;
+
+    printf("%s on %d machines, machine %d: %d messages in %d ticks, "
+	   "%.2f seconds\n", test, numNodes, myId, messages, ticks, seconds);
+    if (messages > 0)
+	printf("Rate: %d messages per 1000 ticks, %d messages per second\n", 
+		(int) (messages * 1000.0 / ticks), (int) (messages / seconds));
+    if (numLatencies > 0) {
+	qsort(latencies, numLatencies, sizeof(int), CompareInts);
+	printf("Latency (ticks): median %d, 90%% %d, 99%% %d, max %d\n",
+		latencies[numLatencies / 2], latencies[numLatencies * 9 / 10],
+		latencies[numLatencies * 99 / 100], 
+		latencies[numLatencies - 1]);
+    }
+
+    // close in a fixed order everywhere, so no two machines wait on
+    // each other
+    for (j = 0; j < numNodes; j++)
+	if (j != myId)
+	    peers[j]->Close();
+    fflush(stdout);
+    interrupt->Halt();
+}
+
+//----------------------------------------------------------------------
+// FileServerTest
+// 	Serve this machine's files to machines 0 .. numMachines-1, and
+//	halt once they are all done.
+//----------------------------------------------------------------------
+
+void
+FileServerTest(int numMachines)
+{
+    FileServer *server = new FileServer(numMachines);
+
+    server->Serve();
+    printf("File server: all clients done\n");
+    fflush(stdout);
+    interrupt->Halt();
+}
+
+//----------------------------------------------------------------------
+// ReadWhole
+// 	Read all of "file", "chunk" bytes at a time, and print how fast.
+//----------------------------------------------------------------------
+
+static void
+ReadWhole(RemoteFile *file, int chunk, const char *what)
+{
+    char buffer[MaxTransfer];
+    int n, total = 0, start = stats->totalTicks, ticks;
+
+    file->Seek(0);
+    while ((n = file->Read(buffer, chunk)) > 0)
+	total += n;
+    ticks = stats->totalTicks - start;
+    printf("%s: %d bytes in %d ticks, %d bytes per 1000 ticks\n", what, 
+		total, ticks, (ticks > 0) ? (int) (total * 1000.0 / ticks) : 0);
+}
+
+//----------------------------------------------------------------------
+// FileClientTest
+// 	Read file "name" from the server on machine "serverAddr", a 
+//	little at a time the way a program would: first with the cache
+//	off, so every read is a call, then with it on, cold and then 
+//	warm.  Then write a byte back, through to the server, and check 
+//	that it reads back the same; and append a few bytes, which land
+//	in the file's last (cached, short) block, and check that they
+//	read back too.
+//----------------------------------------------------------------------
+
+void
+FileClientTest(int serverAddr, char *name)
+{
+    FileClient *client = new FileClient(serverAddr);
+    RemoteFile *file = client->Open(name);
+    char ch, check, tail[] = "tail", tailCheck[sizeof(tail)];
+    int length, n;
+
+    if (file == NULL) {
+	printf("File server has no file %s\n", name);
+	delete client;
+	interrupt->Halt();
+    }
+
+    client->SetCaching(FALSE);
+    ReadWhole(file, 16, "Uncached");
+    client->Print();
+    client->SetCaching(TRUE);
+    ReadWhole(file, 16, "Cached, cold");
+    ReadWhole(file, 16, "Cached, warm");
+    client->Print();
+
+    if (file->Length() > 0) {
+	file->ReadAt(&ch, 1, 0);
+	file->WriteAt(&ch, 1, 0);
+	file->ReadAt(&check, 1, 0);
+	ASSERT(check == ch);
+    }
+
+    length = file->Length();
+    n = file->WriteAt(tail, sizeof(tail), length);
+    ASSERT(file->ReadAt(tailCheck, sizeof(tail), length) == n);
+    ASSERT(!strncmp(tail, tailCheck, n));
+
+    delete file;
+    delete client;
+    fflush(stdout);
+    interrupt->Halt();
+}
@@ -18,51 +18,121 @@
 
 #include "copyright.h"
 #include "post.h"
+#include "system.h"
 
 //----------------------------------------------------------------------
-// Mail::Mail
-//      Initialize a single mail message, by concatenating the headers to
-//	the data.
-//
-//	"pktH" -- source, destination machine ID's
-//	"mailH" -- source, destination mailbox ID's
-//	"data" -- payload data
+// MailPool::MailPool
+//      Allocate a pool of "size" mail buffers, all free.
+//----------------------------------------------------------------------
+
+MailPool::MailPool(const char *debugName, int size)
+{
+    int i;
+
+    buffers = new Mail[size];
+    freeList = new Mail *[size];
+    for (i = 0; i < size; i++)
+	freeList[i] = &buffers[i];
+    numFree = lowWater = size;
+    available = new Semaphore(debugName, size);
+}
+
+//----------------------------------------------------------------------
+// MailPool::~MailPool
+//      De-allocate the pool, and every buffer in it.
+//----------------------------------------------------------------------
+
+MailPool::~MailPool()
+{
+    delete available;
+    delete [] freeList;
+    delete [] buffers;
+}
+
+//----------------------------------------------------------------------
+// MailPool::Get
+//      Take a free buffer, waiting for one to be given back if there
+//	are none.
+//----------------------------------------------------------------------
+
+Mail *
+MailPool::Get()
+{
+    IntStatus oldLevel;
+    Mail *mail;
+
+    available->P();
+    oldLevel = interrupt->SetLevel(IntOff);
+    mail = freeList[--numFree];
+    if (numFree < lowWater)
+	lowWater = numFree;
+    (void) interrupt->SetLevel(oldLevel);
+    return mail;
+}
+
+//----------------------------------------------------------------------
+// MailPool::TryGet
+//      Take a free buffer, if there is one; otherwise return NULL
+//	rather than wait.
+//----------------------------------------------------------------------
+
+Mail *
+MailPool::TryGet()
+{
+    IntStatus oldLevel;
+    Mail *mail;
+
+    if (!available->TryP())
+	return NULL;
+    oldLevel = interrupt->SetLevel(IntOff);
+    mail = freeList[--numFree];
+    if (numFree < lowWater)
+	lowWater = numFree;
+    (void) interrupt->SetLevel(oldLevel);
+    return mail;
+}
+
+//----------------------------------------------------------------------
+// MailPool::Put
+//      Give a buffer back to the pool.  Can be called from an interrupt
+//	handler.
 //----------------------------------------------------------------------
 
-Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
+void
+MailPool::Put(Mail *mail)
 {
-    ASSERT(mailH.length <= MaxMailSize);
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-    pktHdr = pktH;
-    mailHdr = mailH;
-    bcopy(msgData, data, mailHdr.length);
+    freeList[numFree++] = mail;
+    (void) interrupt->SetLevel(oldLevel);
+    available->V();
 }
 
 //----------------------------------------------------------------------
 // MailBox::MailBox
 //      Initialize a single mail box within the post office, so that it
 //	can receive incoming messages.
-//
-//	Just initialize a list of messages, representing the mailbox.
 //----------------------------------------------------------------------
 
-
 MailBox::MailBox()
 { 
-    messages = new SynchList(); 
+    head = count = 0;
+    lock = new Lock("mailbox lock");
+    notEmpty = new Condition("mailbox not empty");
 }
 
 //----------------------------------------------------------------------
 // MailBox::~MailBox
 //      De-allocate a single mail box within the post office.
 //
-//	Just delete the mailbox, and throw away all the queued messages 
-//	in the mailbox.
+//	Any queued messages belong to the post office's pool, which 
+//	frees them.
 //----------------------------------------------------------------------
 
 MailBox::~MailBox()
 { 
-    delete messages; 
+    delete notEmpty;
+    delete lock;
 }
 
 //----------------------------------------------------------------------
@@ -86,54 +156,46 @@ PrintHeader(PacketHeader pktHdr, MailHeader mailHdr)
 // 	Add a message to the mailbox.  If anyone is waiting for message
 //	arrival, wake them up!
 //
-//	We need to reconstruct the Mail message (by concatenating the headers
-//	to the data), to simplify queueing the message on the SynchList.
-//
-//	"pktHdr" -- source, destination machine ID's
-//	"mailHdr" -- source, destination mailbox ID's
-//	"data" -- payload message data
+//	"mail" -- the message, which now belongs to the mailbox
 //----------------------------------------------------------------------
 
 void 
-MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data)
+MailBox::Put(Mail *mail)
 { 
-    Mail *mail = new Mail(pktHdr, mailHdr, data); 
-
-    messages->Append((void *)mail);	// put on the end of the list of 
-					// arrived messages, and wake up 
-					// any waiters
+    lock->Acquire();
+    ASSERT(count < NumRecvBuffers);
+    queue[(head + count++) % NumRecvBuffers] = mail;
+    notEmpty->Signal(lock);		// wake up any waiter
+    lock->Release();
 }
 
 //----------------------------------------------------------------------
 // MailBox::Get
-// 	Get a message from a mailbox, parsing it into the packet header,
-//	mailbox header, and data. 
+// 	Take the oldest message out of the mailbox; it now belongs to the
+//	caller.
 //
 //	The calling thread waits if there are no messages in the mailbox.
-//
-//	"pktHdr" -- address to put: source, destination machine ID's
-//	"mailHdr" -- address to put: source, destination mailbox ID's
-//	"data" -- address to put: payload message data
 //----------------------------------------------------------------------
 
-void 
-MailBox::Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data) 
+Mail *
+MailBox::Get() 
 { 
+    Mail *mail;
+
     DEBUG('n', "Waiting for mail in mailbox\n");
-    Mail *mail = (Mail *) messages->Remove();	// remove message from list;
-						// will wait if list is empty
+    lock->Acquire();
+    while (count == 0)
+	notEmpty->Wait(lock);
+    mail = queue[head];
+    head = (head + 1) % NumRecvBuffers;
+    count--;
+    lock->Release();
 
-    *pktHdr = mail->pktHdr;
-    *mailHdr = mail->mailHdr;
     if (DebugIsEnabled('n')) {
 	printf("Got mail from mailbox: ");
-	PrintHeader(*pktHdr, *mailHdr);
+	PrintHeader(mail->pktHdr, mail->mailHdr);
     }
-    bcopy(mail->data, data, mail->mailHdr.length);
-					// copy the message data into
-					// the caller's buffer
-    delete mail;			// we've copied out the stuff we
-					// need, we can now discard the message
+    return mail;
 }
 
 //----------------------------------------------------------------------
@@ -172,15 +234,26 @@ static void WriteDone(_int arg)
 //        is delivered is delivered without delay (e.g., orderability = 1
 //        means that delivered packets are never delayed)
 //	"nBoxes" is the number of mail boxes in this Post Office
+//	"workerPeriod" and "workerBudget", if not 0, reserve the postal
+//	  worker that much CPU time (Scheduler::Reserve), so that mail
+//	  is delivered promptly however busy the machine is
 //----------------------------------------------------------------------
 
 PostOffice::PostOffice(NetworkAddress addr, double reliability,
-		       double orderability, int nBoxes)
+		       double orderability, int nBoxes,
+		       int workerPeriod, int workerBudget)
 {
+    int i;
+
+    ASSERT(sizeof(Mail) == MaxWireSize);	// a Mail is a whole packet
+
 // First, initialize the synchronization with the interrupt handlers
     messageAvailable = new Semaphore("message available", 0);
-    messageSent = new Semaphore("message sent", 0);
-    sendLock = new Lock("message send lock");
+    sendPool = new MailPool("send buffers", SendQueueSize);
+    recvPool = new MailPool("receive buffers", NumRecvBuffers);
+    recvShort = 0;
+    outHead = outCount = 0;
+    sendBusy = FALSE;
 
 // Second, initialize the mailboxes
     netAddr = addr; 
@@ -190,12 +263,18 @@ PostOffice::PostOffice(NetworkAddress addr, double reliability,
 // Third, initialize the network; tell it which interrupt handlers to call
     network = new Network(addr, reliability, orderability,
 			  ReadAvail, WriteDone, (_int) this);
+    for (i = 0; i < NumRecvSlots; i++)
+	network->PostBuffer((char *) recvPool->Get());
 
 
 // Finally, create a thread whose sole job is to wait for incoming messages,
 //   and put them in the right mailbox. 
     Thread *t = new Thread("postal worker");
 
+    if ((workerPeriod > 0)
+	    && !scheduler->Reserve(t, workerPeriod, workerBudget))
+	printf("No room to reserve the postal worker %d of every %d ticks\n",
+	       workerBudget, workerPeriod);
     t->Fork(PostalHelper, (_int) this);
 }
 
@@ -209,64 +288,113 @@ PostOffice::~PostOffice()
     delete network;
     delete [] boxes;
     delete messageAvailable;
-    delete messageSent;
-    delete sendLock;
+    delete sendPool;
+    delete recvPool;
 }
 
 //----------------------------------------------------------------------
 // PostOffice::PostalDelivery
 // 	Wait for incoming messages, and put them in the right mailbox.
 //
-//      Incoming messages have had the PacketHeader stripped off,
-//	but the MailHeader is still tacked on the front of the data.
+//      The network reads each packet straight into a buffer from the
+//	receive pool, which is already laid out as a Mail; the buffer 
+//	itself goes into the mailbox, and the network is given a fresh 
+//	one.  If all the buffers are in use -- held in mailboxes nobody
+//	is reading, say -- the network is left a slot short, and we go
+//	on delivering the packets it already has; Release hands the next
+//	buffers given back straight to the network, and until then new
+//	packets wait on the wire.  We never wait for a buffer here: that
+//	would hold up the packets already read, for every mailbox, until
+//	someone read the full one.
+//
+//	Packets arrive in batches, with one interrupt per batch, so take
+//	every one the network has each time we wake up.
 //----------------------------------------------------------------------
 
 void
 PostOffice::PostalDelivery()
 {
-    PacketHeader pktHdr;
-    MailHeader mailHdr;
-    char *buffer = new char[MaxPacketSize];
+    Mail *mail, *fresh;
+    IntStatus oldLevel;
 
     for (;;) {
-        // first, wait for a message
+        // first, wait for messages
         messageAvailable->P();	
-        pktHdr = network->Receive(buffer);
+	while ((mail = (Mail *) network->Receive()) != NULL) {
+	    oldLevel = interrupt->SetLevel(IntOff);	// vs. Release
+	    if ((fresh = recvPool->TryGet()) != NULL)
+		network->PostBuffer((char *) fresh);
+	    else {
+		DEBUG('n', "No receive buffers, network left short\n");
+		recvShort++;
+	    }
+	    (void) interrupt->SetLevel(oldLevel);
+
+	    if (DebugIsEnabled('n')) {
+		printf("Putting mail into mailbox: ");
+		PrintHeader(mail->pktHdr, mail->mailHdr);
+	    }
+
+	    // check that arriving message is legal!
+	    ASSERT(0 <= mail->mailHdr.to && mail->mailHdr.to < numBoxes);
+	    ASSERT(mail->mailHdr.length <= MaxMailSize);
+
+	    // put into mailbox
+	    boxes[mail->mailHdr.to].Put(mail);
+	}
+    }
+}
 
-        mailHdr = *(MailHeader *)buffer;
-        if (DebugIsEnabled('n')) {
-	    printf("Putting mail into mailbox: ");
-	    PrintHeader(pktHdr, mailHdr);
-        }
+//----------------------------------------------------------------------
+// PostOffice::Send
+// 	Send a message whose data is in one piece.
+//
+//	"pktHdr" -- source, destination machine ID's
+//	"mailHdr" -- source, destination mailbox ID's
+//	"data" -- payload message data
+//----------------------------------------------------------------------
 
-	// check that arriving message is legal!
-	ASSERT(0 <= mailHdr.to && mailHdr.to < numBoxes);
-	ASSERT(mailHdr.length <= MaxMailSize);
+void
+PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
+{
+    MailFragment fragment;
 
-	// put into mailbox
-        boxes[mailHdr.to].Put(pktHdr, mailHdr, buffer + sizeof(MailHeader));
-    }
+    fragment.data = data;
+    fragment.length = mailHdr.length;
+    SendGather(pktHdr, mailHdr, &fragment, 1);
 }
 
 //----------------------------------------------------------------------
-// PostOffice::Send
-// 	Concatenate the MailHeader to the front of the data, and pass 
-//	the result to the Network for delivery to the destination machine.
+// PostOffice::SendGather
+// 	Lay out the headers and the data fragments, one after another, in
+//	a send buffer -- the packet exactly as it goes on the wire -- and 
+//	pass it to the Network for delivery to the destination machine.
 //
 //	Note that the MailHeader + data looks just like normal payload
 //	data to the Network.
 //
+//	The network can only take one packet at a time, so packets are
+//	queued, in order, while it is busy; the send interrupt handler
+//	starts the next one.  The caller only waits when all 
+//	SendQueueSize buffers are queued, which lets a protocol keep 
+//	several packets in flight.
+//
 //	"pktHdr" -- source, destination machine ID's
 //	"mailHdr" -- source, destination mailbox ID's
-//	"data" -- payload message data
+//	"fragments" -- pieces of the payload message data
 //----------------------------------------------------------------------
 
 void
-PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
+PostOffice::SendGather(PacketHeader pktHdr, MailHeader mailHdr, 
+			MailFragment *fragments, int numFragments)
 {
-    char* buffer = new char[MaxPacketSize];	// space to hold concatenated
-						// mailHdr + data
+    Mail *mail;
+    IntStatus oldLevel;
+    int i, offset;
 
+    mailHdr.length = 0;
+    for (i = 0; i < numFragments; i++)
+	mailHdr.length += fragments[i].length;
     if (DebugIsEnabled('n')) {
 	printf("Post send: ");
 	PrintHeader(pktHdr, mailHdr);
@@ -278,34 +406,43 @@ PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
     pktHdr.from = netAddr;
     pktHdr.length = mailHdr.length + sizeof(MailHeader);
 
-    // concatenate MailHeader and data
-#ifdef HOST_ALPHA
-    bcopy((const char *)&mailHdr, buffer, sizeof(MailHeader));
-#else
-    bcopy(&mailHdr, buffer, sizeof(MailHeader));
-#endif
-    bcopy(data, buffer + sizeof(MailHeader), mailHdr.length);
-
-    sendLock->Acquire();   		// only one message can be sent
-					// to the network at any one time
-    network->Send(pktHdr, buffer);
-    messageSent->P();			// wait for interrupt to tell us
-					// ok to send the next message
-    sendLock->Release();
-
-    delete [] buffer;			// we've sent the message, so
-					// we can delete our buffer
+    // lay out the packet
+    mail = sendPool->Get();		// wait for room in the queue
+    mail->pktHdr = pktHdr;
+    mail->mailHdr = mailHdr;
+    for (i = 0, offset = 0; i < numFragments; i++) {
+	bcopy(fragments[i].data, mail->data + offset, fragments[i].length);
+	offset += fragments[i].length;
+    }
+
+    oldLevel = interrupt->SetLevel(IntOff);
+    if (sendBusy) {
+	outgoing[(outHead + outCount++) % SendQueueSize] = mail;
+    } else
+	StartSend(mail);
+    (void) interrupt->SetLevel(oldLevel);
 }
 
 //----------------------------------------------------------------------
-// PostOffice::Send
+// PostOffice::StartSend
+// 	Give a packet to the network.  The network is done with the 
+//	buffer once it has been sent, so it goes straight back to the
+//	pool.  Called with interrupts off.
+//----------------------------------------------------------------------
+
+void
+PostOffice::StartSend(Mail *mail)
+{
+    network->SendFrame((char *) mail);
+    sendBusy = TRUE;
+    sendPool->Put(mail);
+}
+
+//----------------------------------------------------------------------
+// PostOffice::Receive
 // 	Retrieve a message from a specific box if one is available, 
 //	otherwise wait for a message to arrive in the box.
 //
-//	Note that the MailHeader + data looks just like normal payload
-//	data to the Network.
-//
-//
 //	"box" -- mailbox ID in which to look for message
 //	"pktHdr" -- address to put: source, destination machine ID's
 //	"mailHdr" -- address to put: source, destination mailbox ID's
@@ -316,10 +453,68 @@ void
 PostOffice::Receive(int box, PacketHeader *pktHdr, 
 				MailHeader *mailHdr, char* data)
 {
+    Mail *mail = Receive(box);
+
+    *pktHdr = mail->pktHdr;
+    *mailHdr = mail->mailHdr;
+    bcopy(mail->data, data, mail->mailHdr.length);
+					// copy the message data into
+					// the caller's buffer
+    Release(mail);
+}
+
+//----------------------------------------------------------------------
+// PostOffice::Receive
+// 	Retrieve a message from a specific box, waiting for one if need
+//	be, without copying it.  The caller reads the headers and data
+//	in place, and must then give the buffer back with Release.
+//
+//	"box" -- mailbox ID in which to look for message
+//----------------------------------------------------------------------
+
+Mail *
+PostOffice::Receive(int box)
+{
+    Mail *mail;
+
     ASSERT((box >= 0) && (box < numBoxes));
 
-    boxes[box].Get(pktHdr, mailHdr, data);
-    ASSERT(mailHdr->length <= MaxMailSize);
+    mail = boxes[box].Get();
+    ASSERT(mail->mailHdr.length <= MaxMailSize);
+    return mail;
+}
+
+//----------------------------------------------------------------------
+// PostOffice::Release
+// 	Give back a message buffer returned by Receive(box).  If the
+//	network was left short of buffers (see PostalDelivery), it gets
+//	this one directly.
+//----------------------------------------------------------------------
+
+void
+PostOffice::Release(Mail *mail)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (recvShort > 0) {
+	recvShort--;
+	network->PostBuffer((char *) mail);
+    } else
+	recvPool->Put(mail);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// PostOffice::PrintPools
+// 	Print the most buffers that were ever in use at once.
+//----------------------------------------------------------------------
+
+void
+PostOffice::PrintPools()
+{
+    printf("Mail buffers: send %d of %d used, receive %d of %d used\n",
+		SendQueueSize - sendPool->LowWater(), SendQueueSize,
+		NumRecvBuffers - recvPool->LowWater(), NumRecvBuffers);
 }
 
 //----------------------------------------------------------------------
@@ -343,11 +538,21 @@ PostOffice::IncomingPacket()
 //	The name of this routine is a misnomer; if "reliability < 1",
 //	the packet could have been dropped by the network, so it won't get
 //	through.
+//
+//	Start the next queued packet, if there is one.
 //----------------------------------------------------------------------
 
 void 
 PostOffice::PacketSent()
 { 
-    messageSent->V();
+    Mail *mail;
+
+    sendBusy = FALSE;
+    if (outCount > 0) {
+	mail = outgoing[outHead];
+	outHead = (outHead + 1) % SendQueueSize;
+	outCount--;
+	StartSend(mail);
+    }
 }
 
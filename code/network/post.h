@@ -29,7 +29,13 @@
 #define POST_H
 
 #include "network.h"
-#include "synchlist.h"
+#include "synch.h"
+
+#define SendQueueSize	16	// outgoing packets the post office will
+				// hold while the network is busy
+#define NumRecvBuffers	48	// incoming packets it will hold before
+				// leaving them on the wire
+#define NumMailBoxes	32	// mailboxes on each machine
 
 // Mailbox address -- uniquely identifies a mailbox on a given machine.
 // A mailbox is just a place for temporary storage for messages.
@@ -58,36 +64,75 @@ class MailHeader {
 //	network header (PacketHeader) 
 //	post office header (MailHeader) 
 //	data
+//
+// This is exactly the layout of a packet on the wire, so a Mail is
+// also the buffer the network reads a packet into or sends it from:
+// an incoming message is handed from the network to the mailbox to
+// the receiving thread without being copied.
 
 class Mail {
   public:
-     Mail(PacketHeader pktH, MailHeader mailH, char *msgData);
-				// Initialize a mail message by
-				// concatenating the headers to the data
-
      PacketHeader pktHdr;	// Header appended by Network
      MailHeader mailHdr;	// Header appended by PostOffice
      char data[MaxMailSize];	// Payload -- message data
 };
 
+// The following class defines a fixed pool of Mail buffers.  All the
+// buffers are allocated up front, so sending and receiving messages
+// does no memory allocation.  Threads that want a buffer wait until
+// one is free, unless they use TryGet; buffers can be given back by
+// interrupt handlers.
+
+class MailPool {
+  public:
+    MailPool(const char *debugName, int size);	// Allocate "size" buffers
+    ~MailPool();
+
+    Mail *Get();		// Take a buffer, waiting if need be
+    Mail *TryGet();		// Take a buffer; NULL if none is free
+    void Put(Mail *mail);	// Give a buffer back
+    int LowWater() { return lowWater; }	// Fewest ever free
+
+  private:
+    Mail *buffers;		// The buffers themselves
+    Mail **freeList;		// Stack of free buffers
+    int numFree;
+    int lowWater;
+    Semaphore *available;	// Counts the free buffers
+};
+
+// A piece of a message, for sending one that is gathered from several
+// places.
+
+class MailFragment {
+  public:
+    char *data;
+    int length;
+};
+
 // The following class defines a single mailbox, or temporary storage
 // for messages.   Incoming messages are put by the PostOffice into the 
 // appropriate mailbox, and these messages can then be retrieved by
 // threads on this machine.
+//
+// A mailbox never holds more than the NumRecvBuffers messages that 
+// exist, so it keeps them in a fixed ring.
 
 class MailBox {
   public: 
     MailBox();			// Allocate and initialize mail box
     ~MailBox();			// De-allocate mail box
 
-    void Put(PacketHeader pktHdr, MailHeader mailHdr, char *data);
-   				// Atomically put a message into the mailbox
-    void Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data); 
-   				// Atomically get a message out of the 
+    void Put(Mail *mail);	// Atomically put a message into the 
+				// mailbox; the mailbox now owns "mail"
+    Mail *Get();		// Atomically get a message out of the 
 				// mailbox (and wait if there is no message 
-				// to get!)
+				// to get!); the caller now owns it
   private:
-    SynchList *messages;	// A mailbox is just a list of arrived messages
+    Mail *queue[NumRecvBuffers];	// Arrived messages, oldest first
+    int head, count;
+    Lock *lock;			// Protects the queue
+    Condition *notEmpty;	// Signalled when a message arrives
 };
 
 // The following class defines a "Post Office", or a collection of 
@@ -102,21 +147,36 @@ class MailBox {
 class PostOffice {
   public:
     PostOffice(NetworkAddress addr, double reliability,
-	       double orderability, int nBoxes);
+	       double orderability, int nBoxes,
+	       int workerPeriod = 0, int workerBudget = 0);
 				// Allocate and initialize Post Office
 				//   "reliability" is how many packets
 				//   get dropped by the underlying network
+				//   The postal worker gets an EDF 
+				//   reservation, if "workerPeriod" > 0
     ~PostOffice();		// De-allocate Post Office data
     
     void Send(PacketHeader pktHdr, MailHeader mailHdr, char *data);
     				// Send a message to a mailbox on a remote 
 				// machine.  The fromBox in the MailHeader is 
-				// the return box for ack's.
+				// the return box for ack's.  Returns once
+				// the message is queued for the network.
+    void SendGather(PacketHeader pktHdr, MailHeader mailHdr,
+		MailFragment *fragments, int numFragments);
+				// Same, but the data is the concatenation
+				// of "fragments"; mailHdr.length is set
+				// from them
     
     void Receive(int box, PacketHeader *pktHdr, 
 		MailHeader *mailHdr, char *data);
     				// Retrieve a message from "box".  Wait if
 				// there is no message in the box.
+    Mail *Receive(int box);	// Same, but hand over the message buffer 
+				// itself rather than copying it out
+    void Release(Mail *mail);	// Give back a buffer from Receive(box)
+
+    NetworkAddress Address() { return netAddr; }	// Our machine ID
+    void PrintPools();		// Print buffer use
 
     void PostalDelivery();	// Wait for incoming messages, 
 				// and then put them in the correct mailbox
@@ -130,13 +190,20 @@ class PostOffice {
 				// PostalDelivery)
 
   private:
+    void StartSend(Mail *mail);		// Put a queued packet on the network
+
     Network *network;		// Physical network connection
     NetworkAddress netAddr;	// Network address of this machine
     MailBox *boxes;		// Table of mail boxes to hold incoming mail
     int numBoxes;		// Number of mail boxes
     Semaphore *messageAvailable;// V'ed when message has arrived from network
-    Semaphore *messageSent;	// V'ed when next message can be sent to network
-    Lock *sendLock;		// Only one outgoing message at a time
+    MailPool *sendPool;		// Buffers for outgoing packets
+    MailPool *recvPool;		// Buffers for incoming packets
+    int recvShort;		// Buffers the network is missing, because
+				// recvPool was empty when it needed them
+    Mail *outgoing[SendQueueSize];	// Packets waiting for the network
+    int outHead, outCount;
+    bool sendBusy;		// Is a packet on its way out?
 };
 
 #endif
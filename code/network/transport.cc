@@ -0,0 +1,433 @@
+// transport.cc 
+//	Routines for a reliable, ordered byte stream over the post office.
+//
+//	Each connection has two threads of its own: a receiver, which
+//	waits in the connection's mailbox and handles both data and 
+//	acknowledgements, and a retransmitter, which wakes up when the 
+//	retransmit timer goes off.  The timer is a scheduled interrupt,
+//	and the interrupt handler can't send messages (that needs a 
+//	Lock), so it just wakes the retransmitter.
+//
+//	Sequence numbers count segments, not bytes, and a FIN takes up a
+//	sequence number of its own so that it is delivered reliably and
+//	in order like any data.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "transport.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// ReceiveHelper, RetransmitHelper, TimerHelper, LingerDone
+// 	Dummy functions because C++ can't indirectly invoke member 
+//	functions.  The first two are forked as the connection's threads;
+//	the others are called by the interrupt handler.
+//----------------------------------------------------------------------
+
+static void ReceiveHelper(_int arg)
+{ Connection *conn = (Connection *) arg; conn->ReceiveLoop(); }
+static void RetransmitHelper(_int arg)
+{ Connection *conn = (Connection *) arg; conn->RetransmitLoop(); }
+static void TimerHelper(_int arg)
+{ Connection *conn = (Connection *) arg; conn->TimerExpired(); }
+static void LingerDone(_int arg)
+{ Semaphore *done = (Semaphore *) arg; done->V(); }
+
+//----------------------------------------------------------------------
+// Connection::Connection
+// 	Set up one end of a connection, and start its threads.  There is
+//	no handshake: the other end must open the matching connection
+//	(with the two mailboxes swapped) before any data arrives.
+//
+//	"localBox" -- our mailbox, used only by this connection
+//	"farAddr", "farBox" -- the other end's machine and mailbox
+//----------------------------------------------------------------------
+
+Connection::Connection(int local, NetworkAddress addr, int box)
+{
+    int i;
+
+    localBox = local;
+    farAddr = addr;
+    farBox = box;
+
+    lock = new Lock("connection lock");
+    windowOpen = new Condition("send window open");
+    dataAvail = new Condition("data available");
+    timeout = new Semaphore("retransmit timeout", 0);
+    timerPending = FALSE;
+
+    for (i = 0; i < WindowSize; i++) {
+	sendWindow[i].valid = FALSE;
+	recvWindow[i].valid = FALSE;
+    }
+    sendBase = nextSeq = 0;
+    dupAcks = 0;
+    recvRead = recvNext = 0;
+    recvOffset = 0;
+    finReceived = FALSE;
+    segmentsSent = retransmits = duplicates = acksSent = 0;
+
+    (new Thread("connection receiver"))->Fork(ReceiveHelper, (_int) this);
+    (new Thread("connection retransmit"))->Fork(RetransmitHelper, 
+							(_int) this);
+}
+
+//----------------------------------------------------------------------
+// Connection::Send
+// 	Cut "size" bytes of "data" into segments and send them.  Returns
+//	as soon as the last one is in the send window; it will be resent
+//	until it is acknowledged.
+//----------------------------------------------------------------------
+
+void
+Connection::Send(char *data, int size)
+{
+    int n;
+
+    lock->Acquire();
+    while (size > 0) {
+	n = min(size, (int) MaxSegmentSize);
+	Queue(data, n, 0);
+	data += n;
+	size -= n;
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Connection::Queue
+// 	Wait for room in the send window, then put a segment of "size"
+//	bytes there and send it.  Called with the lock held.
+//----------------------------------------------------------------------
+
+void
+Connection::Queue(char *data, int size, int flags)
+{
+    SegmentSlot *seg;
+
+    while (nextSeq - sendBase >= WindowSize)
+	windowOpen->Wait(lock);
+
+    seg = &sendWindow[nextSeq % WindowSize];
+    seg->hdr.seq = nextSeq;
+    seg->hdr.flags = flags;
+    seg->hdr.length = size;
+    bcopy(data, seg->data, size);
+    seg->valid = TRUE;
+    Transmit(nextSeq++);
+    StartTimer();
+}
+
+//----------------------------------------------------------------------
+// Connection::Transmit
+// 	Send segment "seq" from the send window, with an up to date 
+//	acknowledgement piggybacked on it.  Called with the lock held.
+//----------------------------------------------------------------------
+
+void
+Connection::Transmit(int seq)
+{
+    SegmentSlot *seg = &sendWindow[seq % WindowSize];
+    MailFragment fragments[2];
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+
+    ASSERT(seg->valid && (seg->hdr.seq == seq));
+    seg->hdr.ack = recvNext;
+    seg->hdr.flags |= SegAck;
+    seg->sentAt = stats->totalTicks;
+
+    pktHdr.to = farAddr;
+    mailHdr.to = farBox;
+    mailHdr.from = localBox;
+    fragments[0].data = (char *) &seg->hdr;	// header and data go
+    fragments[0].length = sizeof(SegmentHeader);	// straight into
+    fragments[1].data = seg->data;		// the packet
+    fragments[1].length = seg->hdr.length;
+
+    DEBUG('n', "Connection sending segment %d, %d bytes\n", seq,
+							seg->hdr.length);
+    segmentsSent++;
+    postOffice->SendGather(pktHdr, mailHdr, fragments, 2);
+}
+
+//----------------------------------------------------------------------
+// Connection::SendAck
+// 	Send a bare acknowledgement of everything received in order so
+//	far.  It carries no data, so it has no sequence number of its
+//	own and is never resent.  Called with the lock held.
+//----------------------------------------------------------------------
+
+void
+Connection::SendAck()
+{
+    SegmentHeader hdr;
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+
+    hdr.seq = nextSeq;
+    hdr.ack = recvNext;
+    hdr.flags = SegAck;
+    hdr.length = 0;
+
+    pktHdr.to = farAddr;
+    mailHdr.to = farBox;
+    mailHdr.from = localBox;
+    mailHdr.length = sizeof(SegmentHeader);
+    acksSent++;
+    postOffice->Send(pktHdr, mailHdr, (char *)&hdr);
+}
+
+//----------------------------------------------------------------------
+// Connection::Receive
+// 	Wait until there is data in order, then copy up to "size" bytes
+//	of it into "data".  Returns the number of bytes copied, or 0 if
+//	the other end has closed and everything it sent has been read.
+//----------------------------------------------------------------------
+
+int
+Connection::Receive(char *data, int size)
+{
+    SegmentSlot *seg;
+    int n = 0, k;
+
+    lock->Acquire();
+    while (recvRead == recvNext)
+	dataAvail->Wait(lock);
+
+    while ((n < size) && (recvRead < recvNext)) {
+	seg = &recvWindow[recvRead % WindowSize];
+	if (seg->hdr.flags & SegFin)
+	    break;			// left in place: all reads now see EOF
+	k = min(size - n, seg->hdr.length - recvOffset);
+	bcopy(seg->data + recvOffset, data + n, k);
+	n += k;
+	recvOffset += k;
+	if (recvOffset == seg->hdr.length) {
+	    seg->valid = FALSE;
+	    recvRead++;
+	    recvOffset = 0;
+	}
+    }
+    lock->Release();
+    return n;
+}
+
+//----------------------------------------------------------------------
+// Connection::ReceiveFully
+// 	Read exactly "size" bytes into "data", over as many Receives as 
+//	it takes.  Returns FALSE if the other end closes first.
+//----------------------------------------------------------------------
+
+bool
+Connection::ReceiveFully(char *data, int size)
+{
+    int n;
+
+    for (; size > 0; size -= n, data += n) {
+	n = Receive(data, size);
+	if (n == 0)
+	    return FALSE;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Connection::Close
+// 	Send a FIN after any data still queued, and wait until it has 
+//	been acknowledged and the other end has closed as well.  Then 
+//	linger for LingerTime, so that if our last acknowledgement was 
+//	lost the other end's resends still get answered.
+//----------------------------------------------------------------------
+
+void
+Connection::Close()
+{
+    Semaphore *lingered = new Semaphore("linger", 0);
+
+    lock->Acquire();
+    Queue(NULL, 0, SegFin);
+    while ((sendBase < nextSeq) || !finReceived)
+	windowOpen->Wait(lock);
+    lock->Release();
+
+    interrupt->Schedule(LingerDone, (_int) lingered, LingerTime, TimerInt);
+    lingered->P();
+    delete lingered;
+}
+
+//----------------------------------------------------------------------
+// Connection::ReceiveLoop
+// 	The receiver thread: take each message out of our mailbox, and
+//	handle the acknowledgement and the data in it, in place.  A 
+//	message too short to be the segment it claims is dropped.
+//----------------------------------------------------------------------
+
+void
+Connection::ReceiveLoop()
+{
+    Mail *mail;
+    SegmentHeader *hdr;
+
+    for (;;) {
+	mail = postOffice->Receive(localBox);
+	hdr = (SegmentHeader *) mail->data;
+	if ((mail->mailHdr.length < sizeof(SegmentHeader)) 
+		|| (hdr->length < 0) || (hdr->length > (int) 
+			(mail->mailHdr.length - sizeof(SegmentHeader)))) {
+	    DEBUG('n', "Connection dropping a malformed segment\n");
+	    postOffice->Release(mail);
+	    continue;
+	}
+	lock->Acquire();
+	if (hdr->flags & SegAck)
+	    Acknowledge(hdr->ack, 
+			(hdr->length == 0) && !(hdr->flags & SegFin));
+	if ((hdr->length > 0) || (hdr->flags & SegFin))
+	    Accept(hdr, mail->data + sizeof(SegmentHeader));
+	lock->Release();
+	postOffice->Release(mail);
+    }
+}
+
+//----------------------------------------------------------------------
+// Connection::Acknowledge
+// 	The other end has everything before segment "ack".  Slide the 
+//	send window forward.  A third repeat of the ack we already had,
+//	while data is outstanding, means a segment was lost, so resend
+//	it without waiting for the timer.  Only "pure" acks -- ones that
+//	carry no data or FIN -- count as repeats: every segment the other
+//	end sends repeats its ack, whether or not anything was lost.  An 
+//	ack for segments we haven't sent is stale or garbled; ignore it.
+//	Called with the lock held.
+//----------------------------------------------------------------------
+
+void
+Connection::Acknowledge(int ack, bool pure)
+{
+    if (ack > nextSeq)
+	DEBUG('n', "Connection ignoring ack %d beyond %d\n", ack, nextSeq);
+    else if (ack > sendBase) {
+	while (sendBase < ack)
+	    sendWindow[sendBase++ % WindowSize].valid = FALSE;
+	dupAcks = 0;
+	windowOpen->Broadcast(lock);
+    } else if (pure && (ack == sendBase) && (sendBase < nextSeq)) {
+	if (++dupAcks == 3) {
+	    DEBUG('n', "Connection fast retransmit of %d\n", sendBase);
+	    retransmits++;
+	    Transmit(sendBase);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// Connection::Accept
+// 	Handle an arriving segment that carries data (or a FIN).  Keep
+//	it if it is new and fits in the receive window, deliver whatever
+//	is now in order, and acknowledge.  Segments beyond the window are
+//	dropped unacknowledged: the reader is behind, and the sender 
+//	will resend them later.  Called with the lock held.
+//----------------------------------------------------------------------
+
+void
+Connection::Accept(SegmentHeader *hdr, char *data)
+{
+    SegmentSlot *seg;
+
+    if (hdr->seq >= recvRead + WindowSize)
+	return;
+    if (hdr->seq < recvNext || recvWindow[hdr->seq % WindowSize].valid)
+	duplicates++;
+    else {
+	seg = &recvWindow[hdr->seq % WindowSize];
+	seg->hdr = *hdr;
+	bcopy(data, seg->data, hdr->length);
+	seg->valid = TRUE;
+	if (hdr->seq == recvNext) {
+	    while (recvWindow[recvNext % WindowSize].valid
+		   && (recvWindow[recvNext % WindowSize].hdr.seq == recvNext)) {
+		if (recvWindow[recvNext % WindowSize].hdr.flags & SegFin) {
+		    finReceived = TRUE;
+		    windowOpen->Broadcast(lock);	// Close may be waiting
+		}
+		recvNext++;
+	    }
+	    dataAvail->Broadcast(lock);
+	}
+    }
+    SendAck();
+}
+
+//----------------------------------------------------------------------
+// Connection::StartTimer
+// 	Make sure the retransmit timer is running.  Called with the lock
+//	held.
+//----------------------------------------------------------------------
+
+void
+Connection::StartTimer()
+{
+    if (timerPending)
+	return;
+    timerPending = TRUE;
+    interrupt->Schedule(TimerHelper, (_int) this, RetransmitTime, TimerInt);
+}
+
+//----------------------------------------------------------------------
+// Connection::TimerExpired
+// 	Interrupt handler for the retransmit timer: wake the 
+//	retransmitter.
+//----------------------------------------------------------------------
+
+void
+Connection::TimerExpired()
+{
+    timerPending = FALSE;
+    timeout->V();
+}
+
+//----------------------------------------------------------------------
+// Connection::RetransmitLoop
+// 	The retransmit thread.  Each time the timer goes off, resend the
+//	oldest unacknowledged segment if it has been waiting a full 
+//	RetransmitTime, and keep the timer going while anything is
+//	outstanding.
+//----------------------------------------------------------------------
+
+void
+Connection::RetransmitLoop()
+{
+    SegmentSlot *oldest;
+
+    for (;;) {
+	timeout->P();
+	lock->Acquire();
+	if (sendBase < nextSeq) {
+	    oldest = &sendWindow[sendBase % WindowSize];
+	    if (stats->totalTicks - oldest->sentAt >= RetransmitTime) {
+		DEBUG('n', "Connection timeout, resending %d\n", sendBase);
+		retransmits++;
+		Transmit(sendBase);
+	    }
+	    StartTimer();
+	}
+	lock->Release();
+    }
+}
+
+//----------------------------------------------------------------------
+// Connection::Print
+// 	Print how much work the protocol has done.
+//----------------------------------------------------------------------
+
+void
+Connection::Print()
+{
+    printf("Connection: segments %d, retransmits %d, duplicates %d, "
+	   "acks %d\n", segmentsSent, retransmits, duplicates, acksSent);
+}
@@ -0,0 +1,127 @@
+// transport.h 
+//	Data structures for a reliable, ordered byte stream between two
+//	mailboxes, built on top of the post office's unreliable, 
+//	unordered message delivery.
+//
+//	The protocol is a sliding window.  Each message (a "segment")
+//	carries a sequence number; the receiver answers every segment
+//	with a cumulative acknowledgement -- the sequence number of the 
+//	next segment it is waiting for.  The sender keeps up to 
+//	WindowSize unacknowledged segments in flight, and resends the 
+//	oldest when its retransmit timer goes off or when three 
+//	duplicate acknowledgements arrive.  The receiver holds segments
+//	that arrive early, and throws away ones it already has.
+//
+//	Both ends of a connection receive data and acknowledgements in
+//	the same local mailbox, so a mailbox can only be used by one
+//	connection.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include "copyright.h"
+#include "post.h"
+#include "synch.h"
+
+#define WindowSize	8		// segments in flight, each way
+#define RetransmitTime	(10 * NetworkTime)	// ticks before a resend
+#define LingerTime	(10 * RetransmitTime)	// ticks to stay around
+					// after closing, to ack resends
+
+// Segment flags
+#define SegAck		0x1		// "ack" field is valid
+#define SegFin		0x2		// sender has no more data
+
+// The following class defines the transport header, which is put in 
+// front of the data of every message the connection sends.
+
+class SegmentHeader {
+  public:
+    int seq;			// Sequence number of this segment
+    int ack;			// Next sequence number we expect
+    short flags;		// SegAck, SegFin
+    short length;		// Bytes of data that follow
+};
+
+#define MaxSegmentSize	(MaxMailSize - sizeof(SegmentHeader))
+
+// A segment that is in flight (on the sending side) or has arrived 
+// but not yet been read (on the receiving side).
+
+class SegmentSlot {
+  public:
+    SegmentHeader hdr;
+    char data[MaxSegmentSize];
+    bool valid;			// Is this window slot in use?
+    int sentAt;			// When we last sent it (sending side)
+};
+
+// The following class defines one end of a connection.  Send and
+// Receive may be called by different threads at the same time.
+// A connection lasts until Nachos halts, since its receiver thread
+// waits in the mailbox for good.
+
+class Connection {
+  public:
+    Connection(int localBox, NetworkAddress farAddr, int farBox);
+				// Open a connection from our mailbox
+				// "localBox" to "farBox" on "farAddr"
+
+    void Send(char *data, int size);	// Send "size" bytes; waits only
+				// while the send window is full
+    int Receive(char *data, int size);	// Wait for data, and return up
+				// to "size" bytes; 0 once the other end
+				// has closed
+    bool ReceiveFully(char *data, int size);	// Wait for exactly 
+				// "size" bytes; FALSE if the other end 
+				// closes first
+    void Close();		// Finish sending, wait for the other end
+				// to close too, then linger a while
+
+    void Print();		// Print the protocol statistics
+
+    void ReceiveLoop();		// Internal routines: the receiver and 
+    void RetransmitLoop();	// retransmit threads, and the timer
+    void TimerExpired();	// interrupt handler
+
+  private:
+    void Queue(char *data, int size, int flags);	// Add a segment
+				// to the send window, and send it
+    void Transmit(int seq);	// (Re)send segment "seq"
+    void SendAck();		// Send a bare acknowledgement
+    void Acknowledge(int ack, bool pure);	// Handle an incoming 
+				// acknowledgement; "pure" if it came
+				// without data
+    void Accept(SegmentHeader *hdr, char *data);	// Handle incoming
+				// data
+    void StartTimer();		// Schedule the retransmit timer
+
+    int localBox;		// Our mailbox
+    NetworkAddress farAddr;	// Where the other end is
+    int farBox;
+
+    Lock *lock;			// Protects everything below
+    Condition *windowOpen;	// Signalled when sendBase advances
+    Condition *dataAvail;	// Signalled when recvNext advances
+    Semaphore *timeout;		// V'ed by the retransmit timer
+    bool timerPending;		// Is the timer scheduled?
+
+    SegmentSlot sendWindow[WindowSize];	// Indexed by seq % WindowSize
+    int sendBase;		// Oldest unacknowledged segment
+    int nextSeq;		// Next segment to send
+    int dupAcks;		// Repeats of the ack for sendBase
+
+    SegmentSlot recvWindow[WindowSize];	// Indexed by seq % WindowSize
+    int recvRead;		// Next segment the reader will take
+    int recvOffset;		// Bytes of it already taken
+    int recvNext;		// Next segment expected from the network
+    bool finReceived;		// Other end has closed
+
+    int segmentsSent, retransmits, duplicates, acksSent; // statistics
+};
+
+#endif // TRANSPORT_H
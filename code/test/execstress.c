@@ -0,0 +1,36 @@
+/* execstress.c 
+ *    Test program to stress process creation and termination.
+ *
+ *    Like the shell, starts programs with Exec and waits for them
+ *    with Join -- but starts all of them before waiting for any, so
+ *    that hundreds of processes exist at once.  Each child exits
+ *    with status 7.
+ *
+ *    Prints the sum of the exit statuses (7 * NUMPROCS if all went
+ *    well), then the number of Execs that failed.
+ */
+
+#include "syscall.h"
+
+#define NUMPROCS	200
+
+SpaceId kids[NUMPROCS];		/* global: too big for the user stack */
+
+int
+main()
+{
+    int i, sum = 0, failed = 0;
+
+    for (i = 0; i < NUMPROCS; i++)
+        kids[i] = Exec("../test/exitcode.noff");
+
+    for (i = 0; i < NUMPROCS; i++)
+        if (kids[i] < 0)
+            failed++;
+        else
+            sum += Join(kids[i]);
+
+    PrintInt(sum);	/* should be 1400 */
+    PrintInt(failed);	/* should be 0 */
+    Exit(0);
+}
@@ -0,0 +1,13 @@
+/* exitcode.c
+ *	Very short program that does nothing but exit with a known
+ *	status, to be run many times over by execstress.
+ */
+
+#include "syscall.h"
+
+int
+main()
+{
+    Exit(7);
+    /* not reached */
+}
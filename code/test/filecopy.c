@@ -0,0 +1,46 @@
+/* filecopy.c 
+ *    Benchmark for file I/O through the system calls: writes a file,
+ *    then copies it one byte at a time with Read and Write, the way
+ *    naive programs (like the shell) do it.
+ *
+ *    Thanks to the buffering in runtime.c, the copy should only cost
+ *    about two system calls per BUFSIZE bytes; compare the "System
+ *    calls" line of the statistics with the number of bytes copied.
+ */
+
+#include "syscall.h"
+
+#define FILESIZE	16384
+#define CHUNK		64
+
+char chunk[CHUNK];
+
+int
+main()
+{
+    OpenFileId in, out;
+    int i, copied = 0;
+    char ch;
+
+    for (i = 0; i < CHUNK; i++)
+        chunk[i] = 'a' + (i % 26);
+
+    Create("copyin");
+    out = Open("copyin");
+    for (i = 0; i < FILESIZE; i += CHUNK)
+        Write(chunk, CHUNK, out);
+    Close(out);
+
+    in = Open("copyin");
+    Create("copyout");
+    out = Open("copyout");
+    while (Read(&ch, 1, in) == 1) {
+        Write(&ch, 1, out);
+        copied++;
+    }
+    Close(in);
+    Close(out);
+
+    PrintInt(copied);		/* should be FILESIZE */
+    Halt();
+}
@@ -0,0 +1,160 @@
+/* runtime.c 
+ *	User-level buffering for the Nachos system calls, linked into
+ *	every user program right after start.o.
+ *
+ *	Read and Write on descriptors below NUMBUFFERED go through a
+ *	buffer in the program's own memory, so that a loop reading or
+ *	writing a byte at a time only traps into the kernel once per
+ *	buffer full.  Console output is flushed at every newline; other
+ *	output when the buffer fills, on Close, and before the program 
+ *	exits or waits for (or starts) another program.  All output is
+ *	flushed before reading the console, so that prompts show up.
+ *
+ *	A descriptor should be used either for reading or for writing:
+ *	read-ahead moves the kernel's file position past what the
+ *	program has seen.  So each descriptor has just one buffer, for
+ *	whichever it is doing; switching flushes the output, or drops
+ *	the input read ahead.
+ *
+ *	The buffers are a page each (at the default page size), and
+ *	are uninitialized data, so they cost a program nothing -- no
+ *	memory, no I/O -- until it uses them: pages are zero-filled
+ *	only when first touched.
+ */
+
+#include "syscall.h"
+
+#define NUMBUFFERED	4	/* descriptors 0..3 are buffered: the
+				 * console, and two files */
+#define BUFSIZE		128	/* bytes per buffer; larger transfers go
+				 * straight to the kernel */
+
+/* The raw system call stubs, in start.s */
+extern void SysHalt();
+extern void SysExit(int status);
+extern SpaceId SysExec(char *name);
+extern int SysJoin(SpaceId id);
+extern int SysRead(char *buffer, int size, OpenFileId id);
+extern void SysWrite(char *buffer, int size, OpenFileId id);
+extern void SysClose(OpenFileId id);
+extern void SysPrintInt(int value);
+
+static char buf[NUMBUFFERED][BUFSIZE];
+static int inPos[NUMBUFFERED], inLen[NUMBUFFERED];	/* read ahead */
+static int outLen[NUMBUFFERED];				/* to be written */
+
+/* Write out whatever is buffered for "id" */
+static void
+Flush(OpenFileId id)
+{
+    if (outLen[id] > 0)
+	SysWrite(buf[id], outLen[id], id);
+    outLen[id] = 0;
+}
+
+static void
+FlushAll()
+{
+    int id;
+
+    for (id = 0; id < NUMBUFFERED; id++)
+	Flush(id);
+}
+
+void
+Write(char *buffer, int size, OpenFileId id)
+{
+    int i;
+
+    if ((id < 0) || (id >= NUMBUFFERED)) {
+	SysWrite(buffer, size, id);
+	return;
+    }
+    inPos[id] = inLen[id] = 0;		/* drop any read-ahead */
+    if (size >= BUFSIZE) {		/* no point in copying it */
+	Flush(id);
+	SysWrite(buffer, size, id);
+	return;
+    }
+    for (i = 0; i < size; i++) {
+	buf[id][outLen[id]++] = buffer[i];
+	if ((outLen[id] == BUFSIZE) || 
+			((id == ConsoleOutput) && (buffer[i] == '\n')))
+	    Flush(id);
+    }
+}
+
+int
+Read(char *buffer, int size, OpenFileId id)
+{
+    int i, n;
+
+    if ((id < 0) || (id >= NUMBUFFERED))
+	return SysRead(buffer, size, id);
+    if (id == ConsoleInput)
+	FlushAll();
+    else
+	Flush(id);			/* the buffer is for reading now */
+    if (inPos[id] == inLen[id]) {	/* buffer empty */
+	if (size >= BUFSIZE)
+	    return SysRead(buffer, size, id);
+	inPos[id] = 0;
+	inLen[id] = SysRead(buf[id], BUFSIZE, id);
+	if (inLen[id] <= 0) {		/* end of file, or error */
+	    n = inLen[id];
+	    inLen[id] = 0;
+	    return n;
+	}
+    }
+    n = inLen[id] - inPos[id];
+    if (n > size)
+	n = size;
+    for (i = 0; i < n; i++)
+	buffer[i] = buf[id][inPos[id]++];
+    return n;
+}
+
+void
+Close(OpenFileId id)
+{
+    if ((id >= 0) && (id < NUMBUFFERED)) {
+	Flush(id);
+	inPos[id] = inLen[id] = 0;
+    }
+    SysClose(id);
+}
+
+void
+Halt()
+{
+    FlushAll();
+    SysHalt();
+}
+
+void
+Exit(int status)
+{
+    FlushAll();
+    SysExit(status);
+}
+
+SpaceId
+Exec(char *name)
+{
+    FlushAll();
+    return SysExec(name);
+}
+
+int
+Join(SpaceId id)
+{
+    FlushAll();
+    return SysJoin(id);
+}
+
+void
+PrintInt(int value)
+{
+    Flush(ConsoleOutput);
+    SysPrintInt(value);
+}
@@ -0,0 +1,43 @@
+/* rwbench.c 
+ *    Benchmark for the system call data path: moves data through
+ *    Write and Read in 4KB chunks, so that nearly all of the time is
+ *    spent copying between user and kernel memory.
+ *
+ *    Run with the output thrown away and an endless input, and time
+ *    it on the host:
+ *
+ *	time ./nachos -x ../test/rwbench.noff < /dev/zero > /dev/null
+ *
+ *    The total number of bytes read is printed at the end (on stdout,
+ *    so leave out "> /dev/null" to see it, or look at the console
+ *    statistics).
+ */
+
+#include "syscall.h"
+
+#define BUFSIZE		4096
+#define ROUNDS		1000
+
+char buffer[BUFSIZE];		/* global: too big for the user stack */
+
+int
+main()
+{
+    int i, n, total = 0;
+
+    for (i = 0; i < BUFSIZE; i++)
+        buffer[i] = 'a' + (i % 26);
+
+    for (i = 0; i < ROUNDS; i++)
+        Write(buffer, BUFSIZE, ConsoleOutput);
+
+    for (i = 0; i < ROUNDS; i++) {
+        n = Read(buffer, BUFSIZE, ConsoleInput);
+        if (n <= 0)
+            break;
+        total += n;
+    }
+
+    PrintInt(total);
+    Halt();
+}
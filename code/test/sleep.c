@@ -0,0 +1,33 @@
+/* sleep.c
+ *    Test program for the Sleep system call.
+ *
+ *    Starts matmult, then sleeps SLEEPS times for TICKS ticks each
+ *    while it computes, and waits for it.  The sleeps should cost
+ *    almost no CPU: run with
+ *
+ *	./nachos -x ../test/sleep.noff
+ *
+ *    and compare the user and idle ticks in the statistics with a run
+ *    of matmult alone.  Prints the number of sleeps, then matmult's
+ *    exit status.
+ */
+
+#include "syscall.h"
+
+#define SLEEPS		10
+#define TICKS		1000
+
+int
+main()
+{
+    SpaceId kid;
+    int i;
+
+    kid = Exec("../test/matmult.noff");
+    for (i = 0; i < SLEEPS; i++)
+        Sleep(TICKS);
+
+    PrintInt(i);		/* should be SLEEPS */
+    PrintInt(Join(kid));
+    Exit(0);
+}
@@ -0,0 +1,32 @@
+/* sparse.c 
+ *    Test program with an address space much larger than physical
+ *    memory, of which only a little is ever touched.
+ *
+ *    Intended to measure the cost of starting a large program: with
+ *    demand paging, only the pages that are used get loaded, and the
+ *    big uninitialized array costs nothing until it is written.
+ *    Compare the "Paging:" statistics for different values of STRIDE.
+ *    (With the stub file system, loading a page takes no simulated
+ *    time, so the cost shows up as page-ins, not as ticks.)
+ */
+
+#include "syscall.h"
+
+#define ARRAYSIZE	16384	/* 64KB -- 512 pages of 128 bytes */
+#define STRIDE		1024	/* touch one int out of every STRIDE */
+
+int A[ARRAYSIZE];
+
+int
+main()
+{
+    int i, sum = 0;
+
+    for (i = 0; i < ARRAYSIZE; i += STRIDE)
+        A[i] = i;
+    for (i = 0; i < ARRAYSIZE; i += STRIDE)
+        sum += A[i];
+
+    PrintInt(sum);	/* should be 122880 */
+    Halt();
+}
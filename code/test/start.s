@@ -3,7 +3,7 @@
  *
  *	Since we don't want to pull in the entire C library, we define
  *	what we need for a user program here, namely Start and the system
- *	calls.
+ *	calls.  Buffered I/O on top of the system calls is in runtime.c.
  */
 
 #define IN_ASM
@@ -26,7 +26,8 @@
 __start:
 	jal	main
 	move	$4,$0		
-	jal	Exit	 /* if we return from main, exit(0) */
+	jal	Exit	 /* if we return from main, exit(0) -- this is
+			  * the Exit in runtime.c, which flushes output */
 	.end __start
 
 /* -------------------------------------------------------------
@@ -39,40 +40,44 @@ __start:
  *
  * 	The return value is in r2. This follows the standard C calling
  * 	convention on the MIPS.
+ *
+ *	The stubs for the calls that take part in I/O buffering are
+ *	named Sys<call>; the C routines of the same name without the
+ *	"Sys", in runtime.c, buffer the data and call these.
  * -------------------------------------------------------------
  */
 
-	.globl Halt
-	.ent	Halt
-Halt:
+	.globl SysHalt
+	.ent	SysHalt
+SysHalt:
 	addiu $2,$0,SC_Halt
 	syscall
 	j	$31
-	.end Halt
+	.end SysHalt
 
-	.globl Exit
-	.ent	Exit
-Exit:
+	.globl SysExit
+	.ent	SysExit
+SysExit:
 	addiu $2,$0,SC_Exit
 	syscall
 	j	$31
-	.end Exit
+	.end SysExit
 
-	.globl Exec
-	.ent	Exec
-Exec:
+	.globl SysExec
+	.ent	SysExec
+SysExec:
 	addiu $2,$0,SC_Exec
 	syscall
 	j	$31
-	.end Exec
+	.end SysExec
 
-	.globl Join
-	.ent	Join
-Join:
+	.globl SysJoin
+	.ent	SysJoin
+SysJoin:
 	addiu $2,$0,SC_Join
 	syscall
 	j	$31
-	.end Join
+	.end SysJoin
 
 	.globl Create
 	.ent	Create
@@ -90,29 +95,29 @@ Open:
 	j	$31
 	.end Open
 
-	.globl Read
-	.ent	Read
-Read:
+	.globl SysRead
+	.ent	SysRead
+SysRead:
 	addiu $2,$0,SC_Read
 	syscall
 	j	$31
-	.end Read
+	.end SysRead
 
-	.globl Write
-	.ent	Write
-Write:
+	.globl SysWrite
+	.ent	SysWrite
+SysWrite:
 	addiu $2,$0,SC_Write
 	syscall
 	j	$31
-	.end Write
+	.end SysWrite
 
-	.globl Close
-	.ent	Close
-Close:
+	.globl SysClose
+	.ent	SysClose
+SysClose:
 	addiu $2,$0,SC_Close
 	syscall
 	j	$31
-	.end Close
+	.end SysClose
 
 	.globl Fork
 	.ent	Fork
@@ -130,13 +135,21 @@ Yield:
 	j	$31
 	.end Yield
 
-	.globl PrintInt
-	.ent	PrintInt
-PrintInt:
+	.globl SysPrintInt
+	.ent	SysPrintInt
+SysPrintInt:
 	addiu $2,$0,SC_PrintInt
 	syscall
 	j	$31
-	.end PrintInt
+	.end SysPrintInt
+
+	.globl Sleep
+	.ent	Sleep
+Sleep:
+	addiu $2,$0,SC_Sleep
+	syscall
+	j	$31
+	.end Sleep
 
 /* dummy function to keep gcc happy */
         .globl  __main
@@ -0,0 +1,134 @@
+// alarm.cc
+//	Routines to put threads to sleep for a given amount of simulated
+//	time.
+//
+//	Interrupts can't be cancelled once scheduled, so we keep track of
+//	the alarm interrupts we have asked for, and only ask for another
+//	when a thread needs to be woken before all of them.  Each one
+//	is then always for some sleeper's wakeup time.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "alarm.h"
+#include "system.h"
+
+// dummy function because C++ does not allow pointers to member functions
+static void AlarmHandler(_int arg)
+{ Alarm *p = (Alarm *)arg; p->CallBack(); }
+
+//----------------------------------------------------------------------
+// Alarm::Alarm
+// 	Initialize the alarm clock.  Nothing is scheduled until some
+//	thread goes to sleep.
+//----------------------------------------------------------------------
+
+Alarm::Alarm()
+{
+}
+
+//----------------------------------------------------------------------
+// Alarm::WaitUntil
+// 	Put the current thread to sleep until simulated time "when".
+//	Return at once if that time has already come.
+//----------------------------------------------------------------------
+
+void
+Alarm::WaitUntil(int when)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (when > stats->totalTicks) {
+	DEBUG('t', "Thread \"%s\" sleeping until %d\n",
+	      currentThread->getName(), when);
+	sleepers.Insert(currentThread, when);
+	Arm();
+	currentThread->Sleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::WaitFor
+// 	Put the current thread to sleep for "howLong" ticks.
+//----------------------------------------------------------------------
+
+void
+Alarm::WaitFor(int howLong)
+{
+    WaitUntil(stats->totalTicks + howLong);
+}
+
+//----------------------------------------------------------------------
+// Alarm::ReadyAt
+// 	Have the alarm put "thread", which must be blocked and not
+//	waiting for anything else, on the ready list at time "when".
+//	The scheduler uses this to hold back a thread until its next 
+//	EDF period.
+//
+//	Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+Alarm::ReadyAt(Thread *thread, int when)
+{
+    ASSERT(thread->getStatus() == BLOCKED);
+    sleepers.Insert(thread, when);
+    Arm();
+}
+
+//----------------------------------------------------------------------
+// Alarm::Arm
+// 	If the first sleeper must be woken before every alarm interrupt
+//	already scheduled, schedule one for it.
+//
+//	Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+Alarm::Arm()
+{
+    int wakeup, next;
+
+    if (!sleepers.Peek(NULL, &wakeup))
+	return;
+    if (armed.Peek(NULL, &next) && (next <= wakeup))
+	return;
+    interrupt->Schedule(AlarmHandler, (_int) this,
+			wakeup - stats->totalTicks, AlarmInt);
+    armed.Insert(wakeup, wakeup);
+}
+
+//----------------------------------------------------------------------
+// Alarm::CallBack
+// 	The alarm interrupt handler.  Put every thread whose time has
+//	come back on the ready list, in the order they were due, and
+//	schedule the next interrupt if anyone is still asleep.
+//
+//	If one of them is more urgent than the thread that was
+//	interrupted (Scheduler::MoreUrgent), switch to it as soon as 
+//	the handler returns, as the timer does.
+//----------------------------------------------------------------------
+
+void
+Alarm::CallBack()
+{
+    Thread *thread;
+    int wakeup;
+
+    armed.Remove(NULL, NULL);
+    while (sleepers.Peek(&thread, &wakeup)
+				&& (wakeup <= stats->totalTicks)) {
+	sleepers.Remove(NULL, NULL);
+	DEBUG('t', "Waking thread \"%s\", due at %d, at %d\n",
+	      thread->getName(), wakeup, stats->totalTicks);
+	scheduler->ReadyToRun(thread);
+	if ((interrupt->getStatus() != IdleMode)
+		&& (thread->getStatus() == READY)
+		&& scheduler->MoreUrgent(thread, currentThread))
+	    interrupt->YieldOnReturn();
+    }
+    Arm();
+}
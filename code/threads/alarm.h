@@ -0,0 +1,50 @@
+// alarm.h
+//	Data structures for a software alarm clock.
+//
+//	A kernel thread that needs to wait for some amount of simulated
+//	time calls Alarm::WaitUntil, and is put to sleep until then,
+//	instead of spinning on Thread::Yield.  Sleeping threads are
+//	kept in a queue ordered by wakeup time; an alarm interrupt is
+//	scheduled for the earliest of them, and its handler puts every
+//	thread that is due back on the ready list.  While every thread
+//	is asleep, the CPU idles in Interrupt::Idle, which skips the
+//	clock straight ahead to the next interrupt.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ALARM_H
+#define ALARM_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "thread.h"
+#include "typedlist.h"
+
+// The following class defines the alarm clock.  There is one,
+// "alarmClock" (system.h), shared by every thread.
+
+class Alarm {
+  public:
+    Alarm();			// no one asleep, no interrupt scheduled
+    ~Alarm() {}
+
+    void WaitUntil(int when);	// sleep until stats->totalTicks >= when
+    void WaitFor(int howLong);	// sleep for "howLong" ticks
+    void ReadyAt(Thread *thread, int when);
+				// put a blocked thread on the ready
+				// list at time "when"
+
+    void CallBack();		// called from the alarm interrupt;
+				// wake up every thread that is due
+
+  private:
+    void Arm();			// make sure an interrupt is scheduled
+				// for the first sleeper
+
+    SortedQueue<Thread *> sleepers;	// sleeping threads, by wakeup time
+    SortedQueue<int> armed;	// alarm interrupts scheduled, by time
+};
+
+#endif // ALARM_H
@@ -0,0 +1,104 @@
+// alarmtest.cc
+//	Test and benchmark for the alarm clock.
+//
+//	A number of threads each wait AlarmWaits times for a different
+//	number of ticks, either by sleeping on the alarm clock or, as
+//	kernel threads used to, by calling Yield until the time has come.
+//	For each, we print the simulated time taken, how much of it the
+//	CPU was busy and how much idle, the context switches, and how
+//	late the latest wakeup was.  Sleeping should leave the CPU idle
+//	for nearly all of the time, and never wake a thread early.
+//
+//	Output is comma-separated:
+//	    ./nachos -at > alarm.csv
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "synch.h"
+
+#define AlarmWaits	20	// waits per thread
+#define AlarmTicks	500	// thread i waits (i + 1) * AlarmTicks
+
+static int sleepers[] = { 1, 4, 16 };
+
+// The run in progress
+static bool spin;		// Yield until the time comes, don't sleep
+static int latest;		// latest wakeup, in ticks past its time
+static Semaphore *done;
+
+//----------------------------------------------------------------------
+// Waiter
+// 	Wait AlarmWaits times, each for (which + 1) * AlarmTicks, and
+//	check that we were never woken early.
+//----------------------------------------------------------------------
+
+static void
+Waiter(_int which)
+{
+    int i, when;
+
+    for (i = 0; i < AlarmWaits; i++) {
+	when = stats->totalTicks + (which + 1) * AlarmTicks;
+	if (spin)
+	    while (stats->totalTicks < when)
+		currentThread->Yield();
+	else
+	    alarmClock->WaitUntil(when);
+	ASSERT(stats->totalTicks >= when);
+	latest = max(latest, stats->totalTicks - when);
+    }
+    done->V();
+}
+
+//----------------------------------------------------------------------
+// AlarmRun
+// 	Do one run, and print its line.
+//----------------------------------------------------------------------
+
+static void
+AlarmRun(bool yieldLoop, int threads)
+{
+    int i, startTicks, startIdle, startSwitches, ticks, idle;
+
+    spin = yieldLoop;
+    latest = 0;
+    done = new Semaphore("waiters done", 0);
+
+    startTicks = stats->totalTicks;
+    startIdle = stats->idleTicks;
+    startSwitches = stats->numContextSwitches;
+    for (i = 0; i < threads; i++)
+	(new Thread("waiter"))->Fork(Waiter, i);
+    for (i = 0; i < threads; i++)
+	done->P();
+    ticks = stats->totalTicks - startTicks;
+    idle = stats->idleTicks - startIdle;
+
+    printf("%s,%d,%d,%d,%d,%d,%d\n", spin ? "yield loop" : "alarm",
+	   threads, ticks, ticks - idle, idle,
+	   stats->numContextSwitches - startSwitches, latest);
+
+    delete done;
+}
+
+//----------------------------------------------------------------------
+// AlarmTest
+// 	Run the whole benchmark.
+//----------------------------------------------------------------------
+
+void
+AlarmTest()
+{
+    int s;
+
+    printf("wait,threads,ticks,busy ticks,idle ticks,switches,"
+	   "latest wakeup\n");
+    for (s = 0; s < (int) (sizeof(sleepers) / sizeof(int)); s++) {
+	AlarmRun(TRUE, sleepers[s]);
+	AlarmRun(FALSE, sleepers[s]);
+    }
+}
@@ -0,0 +1,124 @@
+// boundedqueue.cc 
+//	Routines for a bounded queue shared by producers and consumers.
+//
+//	The waits are in "while" loops, as Mesa signaling needs; under 
+//	Hoare signaling the condition is already true when a waiter
+//	wakes, and the loop test simply passes.
+//
+//	A batch of k items can satisfy at most k waiters, so that is the
+//	most we signal -- waking the rest would only put them back to 
+//	sleep.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "boundedqueue.h"
+
+//----------------------------------------------------------------------
+// BoundedQueue::BoundedQueue
+// 	Initialize an empty queue.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"capacity" is the most items the queue can hold.
+//	"signalStyle" chooses Mesa or Hoare signaling.
+//----------------------------------------------------------------------
+
+BoundedQueue::BoundedQueue(const char* debugName, int capacity, 
+			   SignalStyle signalStyle)
+{
+    ASSERT(capacity > 0);
+    mon = new Monitor(debugName, signalStyle);
+    notFull = new MonitorCondition("queue not full", mon);
+    notEmpty = new MonitorCondition("queue not empty", mon);
+    ring = new void *[capacity];
+    size = capacity;
+    head = count = 0;
+}
+
+//----------------------------------------------------------------------
+// BoundedQueue::~BoundedQueue
+// 	De-allocate the queue, when no one is using it any more.
+//----------------------------------------------------------------------
+
+BoundedQueue::~BoundedQueue()
+{
+    delete notFull;
+    delete notEmpty;
+    delete mon;
+    delete [] ring;
+}
+
+//----------------------------------------------------------------------
+// BoundedQueue::PutN
+// 	Append "n" items to the queue, waiting whenever it is full.  If 
+//	there is not room for them all, the items go in as room appears,
+//	so other producers' items may come between them.
+//----------------------------------------------------------------------
+
+void
+BoundedQueue::PutN(void **items, int n)
+{
+    int done = 0, k, i;
+
+    mon->Enter();
+    while (done < n) {
+	while (count == size)
+	    notFull->Wait();
+	k = min(n - done, size - count);
+	for (i = 0; i < k; i++)
+	    ring[(head + count + i) % size] = items[done + i];
+	count += k;
+	done += k;
+	for (i = 0; (i < k) && (count > 0) && notEmpty->HasWaiters(); i++)
+	    notEmpty->Signal();
+    }
+    mon->Exit();
+}
+
+//----------------------------------------------------------------------
+// BoundedQueue::GetN
+// 	Wait until the queue is not empty, then remove up to "maxItems"
+//	items into "items".  Returns the number removed.
+//----------------------------------------------------------------------
+
+int
+BoundedQueue::GetN(void **items, int maxItems)
+{
+    int k, i;
+
+    ASSERT(maxItems > 0);
+    mon->Enter();
+    while (count == 0)
+	notEmpty->Wait();
+    k = min(maxItems, count);
+    for (i = 0; i < k; i++)
+	items[i] = ring[(head + i) % size];
+    head = (head + k) % size;
+    count -= k;
+    for (i = 0; (i < k) && (count < size) && notFull->HasWaiters(); i++)
+	notFull->Signal();
+    mon->Exit();
+    return k;
+}
+
+//----------------------------------------------------------------------
+// BoundedQueue::Put, BoundedQueue::Get
+// 	Append or remove a single item.
+//----------------------------------------------------------------------
+
+void
+BoundedQueue::Put(void *item)
+{
+    PutN(&item, 1);
+}
+
+void *
+BoundedQueue::Get()
+{
+    void *item;
+
+    (void) GetN(&item, 1);
+    return item;
+}
@@ -0,0 +1,46 @@
+// boundedqueue.h 
+//	Data structures for a bounded queue shared by any number of 
+//	producer and consumer threads.
+//
+//	The queue is a monitor: a ring of "capacity" slots, with one 
+//	condition for producers waiting for room and one for consumers
+//	waiting for items.  PutN and GetN move a batch of items at a time,
+//	which is both one trip into the monitor instead of many, and 
+//	(more important) fewer threads woken up and put back to sleep.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include "copyright.h"
+#include "monitor.h"
+
+class BoundedQueue {
+  public:
+    BoundedQueue(const char* debugName, int capacity, 
+		 SignalStyle signalStyle);
+    ~BoundedQueue();
+
+    void Put(void *item);	// wait for room, then append item
+    void *Get();		// wait for an item, then remove it
+
+    void PutN(void **items, int n);	// append all n items, waiting for
+				// room as need be
+    int GetN(void **items, int maxItems);	// wait for an item, then remove
+				// as many as are there, up to maxItems;
+				// returns how many
+
+  private:
+    Monitor *mon;
+    MonitorCondition *notFull;	// producers wait here for room
+    MonitorCondition *notEmpty;	// consumers wait here for items
+    void **ring;		// the items, in slots head .. head+count-1
+    int size;			// number of slots
+    int head;			// slot of the oldest item
+    int count;			// number of items in the queue
+};
+
+#endif // BOUNDEDQUEUE_H
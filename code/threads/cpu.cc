@@ -0,0 +1,206 @@
+// cpu.cc
+//	Routines to simulate a shared-memory multiprocessor: the CPUs
+//	taking turns, their idle threads, and waking a halted CPU.
+//
+//	See cpu.h for how the simulation works.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cpu.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// IdleLoop
+// 	What a CPU runs when it has no thread to: look for one, on its
+//	own ready lists or on another CPU's, and halt if there is none.
+//	The loop picks up again once the CPU has been woken.
+//
+//	The idle thread is never on a ready list.  It gets the CPU back
+//	when the thread running there blocks, and nothing else can run
+//	(Thread::Sleep).
+//----------------------------------------------------------------------
+
+static void
+IdleLoop(_int dummy)
+{
+    Thread *nextThread;
+
+    for (;;) {
+	(void) interrupt->SetLevel(IntOff);
+	if ((nextThread = scheduler->FindNextToRun()) != NULL) {
+	    currentThread->setStatus(BLOCKED);
+	    scheduler->Run(nextThread);
+	} else
+	    currentCPU->Halt();
+	(void) interrupt->SetLevel(IntOn);	// if we halted, the other
+    }						// CPUs take their turns
+}
+
+//----------------------------------------------------------------------
+// CPU::CPU
+// 	Initialize CPU "which".  CPU 0 is the one Nachos starts on; the
+//	others are halted, and start out running their idle threads.
+//
+//	The others also get an empty TLB of their own, if there is a
+//	TLB; CPU 0 uses the one the machine starts with.
+//----------------------------------------------------------------------
+
+CPU::CPU(int which)
+{
+    id = which;
+    halted = (which != 0);
+    ticks = 0;
+    steals = ipis = 0;
+
+    idleThread = NULL;
+    thread = NULL;
+    if (numCPUs > 1) {
+	idleThread = new Thread("idle", NUM_PRIORITY_LEVELS - 1);
+	idleThread->StackAllocate(IdleLoop, 0);
+	idleThread->setStatus((which == 0) ? BLOCKED : RUNNING);
+	thread = idleThread;
+    }
+
+#ifdef USER_PROGRAM
+    for (int i = 0; i < NumTotalRegs; i++)
+	registers[i] = 0;
+    tlb = NULL;
+    if ((which != 0) && (TLBSize > 0)) {
+	tlb = new TranslationEntry[TLBSize];
+	for (int i = 0; i < TLBSize; i++)
+	    tlb[i].valid = FALSE;
+    }
+    pageTable = NULL;
+    pageTableSize = 0;
+    currentASID = 0;
+#endif
+}
+
+//----------------------------------------------------------------------
+// CPU::Wake
+// 	Send this CPU an IPI, to tell it there may be a thread for it to
+//	run.  If it was halted, it starts taking turns again, its clock
+//	caught up with the sender's.
+//----------------------------------------------------------------------
+
+void
+CPU::Wake()
+{
+    if (!halted)
+	return;
+    DEBUG('t', "Waking CPU %d\n", id);
+    halted = FALSE;
+    ticks = max(ticks, max(currentCPU->ticks, stats->totalTicks));
+    ipis++;
+}
+
+//----------------------------------------------------------------------
+// Earliest
+// 	Return the running (not halted) CPU whose clock is furthest
+//	behind, the lowest numbered one if there is a tie; NULL if all
+//	of them are halted.
+//----------------------------------------------------------------------
+
+static CPU *
+Earliest()
+{
+    CPU *first = NULL;
+
+    for (int i = 0; i < numCPUs; i++)
+	if (!cpus[i]->IsHalted()
+		&& ((first == NULL) || (cpus[i]->ticks < first->ticks)))
+	    first = cpus[i];
+    return first;
+}
+
+//----------------------------------------------------------------------
+// CPU::Tick
+// 	Advance this CPU's clock by "n" ticks.  The global clock moves
+//	up to that of the CPU furthest behind.
+//----------------------------------------------------------------------
+
+void
+CPU::Tick(int n)
+{
+    CPU *first;
+
+    ticks += n;
+    first = Earliest();
+    if ((first != NULL) && (first->ticks > stats->totalTicks))
+	stats->totalTicks = first->ticks;
+}
+
+//----------------------------------------------------------------------
+// NextCPU
+// 	Give the turn to the CPU furthest behind, if that isn't the one
+//	running now.  Called with interrupts off, by Interrupt::OneTick;
+//	returns, with interrupts still off, once it is our turn again.
+//
+//	Returns FALSE if every CPU is halted; the machine is idle.
+//----------------------------------------------------------------------
+
+bool
+NextCPU()
+{
+    CPU *next = Earliest();
+
+    if (next == NULL)
+	return FALSE;
+    if (next->ticks > stats->totalTicks)
+	stats->totalTicks = next->ticks;
+    if (next != currentCPU)
+	currentCPU->SwitchTo(next);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// CPU::SwitchTo
+// 	Stop running this CPU, and run "next" instead: save our machine
+//	state, and load next's, then switch to the thread that is running
+//	on it.  Neither thread changes status -- each is still running,
+//	on its own CPU.  Returns when we get our turn back.
+//----------------------------------------------------------------------
+
+void
+CPU::SwitchTo(CPU *next)
+{
+    Thread *oldThread = currentThread;
+
+#ifdef USER_PROGRAM
+    if (machine != NULL) {
+	for (int i = 0; i < NumTotalRegs; i++) {
+	    registers[i] = machine->registers[i];
+	    machine->registers[i] = next->registers[i];
+	}
+	tlb = machine->tlb;
+	pageTable = machine->pageTable;
+	pageTableSize = machine->pageTableSize;
+	currentASID = machine->currentASID;
+	machine->tlb = next->tlb;
+	machine->pageTable = next->pageTable;
+	machine->pageTableSize = next->pageTableSize;
+	machine->currentASID = next->currentASID;
+    }
+#endif
+
+    thread = oldThread;
+    currentCPU = next;
+    currentThread = next->thread;
+    SWITCH(oldThread, currentThread);
+}
+
+#ifdef USER_PROGRAM
+//----------------------------------------------------------------------
+// CPU::GetTLB
+// 	Return this CPU's TLB: the machine's, if it is our turn.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+CPU::GetTLB()
+{
+    return (this == currentCPU) ? machine->tlb : tlb;
+}
+#endif
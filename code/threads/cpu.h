@@ -0,0 +1,85 @@
+// cpu.h
+//	Data structures for simulating a shared-memory multiprocessor.
+//
+//	With -cpus, Nachos runs on several CPUs at once.  Each has its
+//	own current thread, its own registers and TLB, and its own clock;
+//	they take turns, a tick at a time, the CPU whose clock is furthest
+//	behind going next, so that runs are still deterministic.  The
+//	global clock, stats->totalTicks, is the clock of that CPU.
+//
+//	CPUs only take turns where a CPU could take an interrupt
+//	(Interrupt::OneTick), so turning interrupts off is still enough
+//	for mutual exclusion in the kernel: it keeps the other CPUs from
+//	running at all.
+//
+//	Each CPU has ready lists of its own (Scheduler).  A CPU that has
+//	nothing on them takes a thread from the busiest other CPU; if
+//	there is none, it halts until an inter-processor interrupt (IPI)
+//	-- sent when a thread is made ready -- says there is work again.
+//	TLB entries that are invalidated on one CPU are shot down on the
+//	others (AddrSpace), each of which takes an IPI too.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CPU_H
+#define CPU_H
+
+#include "copyright.h"
+#include "thread.h"
+
+#ifdef USER_PROGRAM
+#include "machine.h"
+#endif
+
+#define MaxCPUs		8	// most CPUs we can simulate
+
+// The following class defines one CPU.  CPUs last as long as Nachos
+// does.
+
+class CPU {
+  public:
+    CPU(int which);			// with multiple CPUs, also sets
+					// up its idle thread
+
+    int getId() { return id; }
+    bool IsHalted() { return halted; }
+    void Halt() { halted = TRUE; }	// nothing to run: stop taking
+					// turns until woken
+    void Wake();			// IPI: there may be work for us
+    void Tick(int ticks);		// advance our clock, and with it
+					// the global one
+    void SwitchTo(CPU *next);		// give "next" its turn
+
+    Thread *idleThread;			// runs when there is nothing else
+					// to; NULL on a uniprocessor
+    int ticks;				// our clock
+    int steals;				// threads taken from other CPUs
+    int ipis;				// IPIs received
+
+#ifdef USER_PROGRAM
+    TranslationEntry *GetTLB();		// our TLB, NULL if none
+#endif
+
+  private:
+    int id;
+    bool halted;
+    Thread *thread;			// running here, while we wait for
+					// our turn
+
+#ifdef USER_PROGRAM
+// The machine state of a CPU waiting for its turn; the machine has
+// only one set, for the CPU whose turn it is.
+    int registers[NumTotalRegs];
+    TranslationEntry *tlb;
+    TranslationEntry *pageTable;
+    unsigned int pageTableSize;
+    int currentASID;
+#endif
+};
+
+extern bool NextCPU();			// let the CPU furthest behind take
+					// its turn; FALSE if all are halted
+
+#endif // CPU_H
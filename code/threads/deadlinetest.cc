@@ -0,0 +1,153 @@
+// deadlinetest.cc
+//	Test and benchmark for EDF reservations (Scheduler::Reserve).
+//
+//	A few periodic threads each have a job to do every period, due
+//	by the end of it, while some CPU-bound "hog" threads of a higher
+//	priority keep the CPU busy.  Each run is scheduled one way:
+//	  - priority: the periodic threads just have a (lower) priority
+//	  - EDF: each reserves a little more CPU per period than its job
+//	    takes; one more reservation, which would take the total over
+//	    EdfUtilization, must be refused
+//	  - EDF, one overrunning: as EDF, but the first thread's jobs
+//	    take twice its budget, and it is held back, so that the
+//	    others still meet their deadlines
+//
+//	For each, we print the number of jobs that finished late (and of
+//	those, how many were the overrunning thread's), the worst
+//	response time as a percentage of the period, and the deadline
+//	misses and used-up budgets counted by the scheduler.
+//
+//	Output is comma-separated:
+//	    ./nachos -dl > deadline.csv
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "synch.h"
+
+#define DeadlineJobs	20	// jobs per periodic thread
+#define DeadlineHogs	2	// CPU-bound threads
+#define HogPriority	5
+#define TaskPriority	10	// periodic threads, when not reserved
+
+static int periods[] = { 1000, 1500, 2500 };
+static int budgets[] = { 200, 300, 500 };
+static int work[] = { 150, 200, 350 };	// ticks of CPU per job
+#define NumTasks ((int) (sizeof(periods) / sizeof(int)))
+
+// The run in progress
+static int start;		// when the first jobs are released
+static bool overrun;		// task 0's jobs take twice its budget
+static int late, lateOverrun;	// jobs finished after their deadline
+static int worst;		// worst response, in percent of the period
+static Semaphore *done;
+
+//----------------------------------------------------------------------
+// Work
+// 	Keep the CPU busy for "ticks" ticks.
+//----------------------------------------------------------------------
+
+static void
+Work(int ticks)
+{
+    for (int i = 0; i < ticks / SystemTick; i++) {
+	(void) interrupt->SetLevel(IntOff);
+	(void) interrupt->SetLevel(IntOn);	// advances the clock
+    }
+}
+
+//----------------------------------------------------------------------
+// Periodic, Hog
+// 	The two kinds of thread in a run.
+//----------------------------------------------------------------------
+
+static void
+Periodic(_int which)
+{
+    int job, release, finish;
+    int ticks = (overrun && (which == 0)) ? 2 * budgets[0] : work[which];
+
+    for (job = 0; job < DeadlineJobs; job++) {
+	release = start + job * periods[which];
+	alarmClock->WaitUntil(release);
+	Work(ticks);
+	finish = stats->totalTicks;
+	if (finish > release + periods[which]) {
+	    late++;
+	    if (overrun && (which == 0))
+		lateOverrun++;
+	}
+	worst = max(worst, (finish - release) * 100 / periods[which]);
+    }
+    done->V();
+}
+
+static void
+Hog(_int ticks)
+{
+    Work(ticks);
+    done->V();
+}
+
+//----------------------------------------------------------------------
+// DeadlineRun
+// 	Do one run, and print its line.
+//----------------------------------------------------------------------
+
+static void
+DeadlineRun(const char *what, bool reserve, bool overrunning)
+{
+    int i, refused = 0;
+    int startMisses = stats->numDeadlineMisses;
+    int startThrottles = stats->numThrottles;
+    Thread *t, *extra;
+
+    overrun = overrunning;
+    late = lateOverrun = worst = 0;
+    done = new Semaphore("deadline run done", 0);
+    start = stats->totalTicks;
+
+    for (i = 0; i < NumTasks; i++) {
+	t = new Thread("periodic", TaskPriority);
+	if (reserve && !scheduler->Reserve(t, periods[i], budgets[i]))
+	    refused++;
+	t->Fork(Periodic, i);
+    }
+    if (reserve) {			// 40% more is more than is left
+	extra = new Thread("extra");
+	if (!scheduler->Reserve(extra, 1000, 400))
+	    refused++;
+	delete extra;
+    }
+    for (i = 0; i < DeadlineHogs; i++) {
+	t = new Thread("hog", HogPriority);
+	t->Fork(Hog, DeadlineJobs * periods[NumTasks - 1] / DeadlineHogs);
+    }
+    for (i = 0; i < NumTasks + DeadlineHogs; i++)
+	done->P();
+
+    printf("%s,%d,%d,%d,%d,%d,%d,%d,%d\n", what, NumTasks,
+	   NumTasks * DeadlineJobs, refused, late, lateOverrun, worst,
+	   stats->numDeadlineMisses - startMisses,
+	   stats->numThrottles - startThrottles);
+
+    delete done;
+}
+
+//----------------------------------------------------------------------
+// DeadlineTest
+// 	Run the whole benchmark.
+//----------------------------------------------------------------------
+
+void
+DeadlineTest()
+{
+    printf("scheduling,threads,jobs,refused,late jobs,late overrunning,"
+	   "worst response %%,deadline misses,budgets used up\n");
+    DeadlineRun("priority", FALSE, FALSE);
+    DeadlineRun("EDF", TRUE, FALSE);
+    DeadlineRun("EDF one overrunning", TRUE, TRUE);
+}
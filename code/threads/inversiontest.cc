@@ -0,0 +1,140 @@
+// inversiontest.cc
+//	Test and benchmark for priority inversion on locks.
+//
+//	Each round, a low-priority thread (priority 90) takes a lock and
+//	holds it for a while; then a high-priority thread (priority 0)
+//	tries to take it, while some medium-priority threads (priority
+//	10) have work of their own to do.  Without priority inheritance,
+//	the medium threads keep the lock holder, and so the high-priority
+//	thread, waiting until all their work is done; with it, or with a
+//	priority ceiling, the holder runs at the high priority until it
+//	lets go of the lock.
+//
+//	For each protocol (synch.h) and number of medium threads, we
+//	print the worst and the mean time, in ticks, the high-priority
+//	thread waited in Acquire.
+//
+//	Output is comma-separated:
+//	    ./nachos -pi > inversion.csv
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "synch.h"
+
+#define InversionRounds	10	// rounds per run
+#define InversionHold	20	// round r holds the lock for
+				// (r % 4 + 1) * InversionHold yields
+#define InversionWork	200	// yields each medium thread does
+
+#define LowPriority	90
+#define MediumPriority	10
+#define HighPriority	0
+
+static int mediums[] = { 1, 4 };
+
+// The round in progress
+static Lock *lock;
+static Semaphore *held;		// the low-priority thread has the lock
+static Semaphore *done;
+static int waited;		// ticks the high-priority thread waited
+
+//----------------------------------------------------------------------
+// Low, Medium, High
+// 	The three kinds of thread in a round.
+//----------------------------------------------------------------------
+
+static void
+Low(_int hold)
+{
+    lock->Acquire();
+    held->V();
+    for (int i = 0; i < hold; i++)
+	currentThread->Yield();
+    lock->Release();
+    done->V();
+}
+
+static void
+Medium(_int work)
+{
+    for (int i = 0; i < work; i++)
+	currentThread->Yield();
+    done->V();
+}
+
+static void
+High(_int dummy)
+{
+    int start = stats->totalTicks;
+
+    lock->Acquire();
+    waited = stats->totalTicks - start;
+    lock->Release();
+    done->V();
+}
+
+//----------------------------------------------------------------------
+// InversionRun
+// 	Do one run of InversionRounds rounds, and print its line.
+//----------------------------------------------------------------------
+
+static void
+InversionRun(const char *what, LockProtocol protocol, int threads)
+{
+    int oldPriority = currentThread->getBasePriority();
+    int round, i, worst = 0, total = 0;
+    Thread *t;
+
+    // we stay at the high priority, so that the round is set up
+    // before any of it runs
+    currentThread->setPriority(HighPriority);
+    for (round = 0; round < InversionRounds; round++) {
+	lock = new Lock("inversion lock", protocol, HighPriority);
+	held = new Semaphore("lock held", 0);
+	done = new Semaphore("round done", 0);
+
+	t = new Thread("low", LowPriority);
+	t->Fork(Low, (round % 4 + 1) * InversionHold);
+	held->P();
+	for (i = 0; i < threads; i++) {
+	    t = new Thread("medium", MediumPriority);
+	    t->Fork(Medium, InversionWork);
+	}
+	t = new Thread("high", HighPriority);
+	t->Fork(High, 0);
+	for (i = 0; i < threads + 2; i++)
+	    done->P();
+
+	worst = max(worst, waited);
+	total += waited;
+	delete lock;
+	delete held;
+	delete done;
+    }
+    currentThread->setPriority(oldPriority);
+
+    printf("%s,%d,%d,%d,%d\n", what, threads, InversionRounds, worst,
+	   total / InversionRounds);
+}
+
+//----------------------------------------------------------------------
+// InversionTest
+// 	Run the whole benchmark.
+//----------------------------------------------------------------------
+
+void
+InversionTest()
+{
+    int m;
+
+    printf("protocol,medium threads,rounds,worst wait,mean wait\n");
+    for (m = 0; m < (int) (sizeof(mediums) / sizeof(int)); m++) {
+	InversionRun("none", NoInheritance, mediums[m]);
+	InversionRun("inheritance", InheritPriority, mediums[m]);
+	InversionRun("ceiling", PriorityCeiling, mediums[m]);
+    }
+}
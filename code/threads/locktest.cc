@@ -0,0 +1,281 @@
+// locktest.cc 
+//	Benchmark of Lock, RWLock and SeqLock on a read-mostly record.
+//
+//	A set of threads each does a run of operations on a shared 
+//	table; each operation is a read with the given probability, and
+//	otherwise a write.  A writer stores the same value in every
+//	entry, so a reader can tell a torn read: the entries differ.  
+//	Both readers and writers give up the CPU halfway through, as if 
+//	preempted or waiting for a page, which is when a mutex makes 
+//	everyone else wait.
+//
+//	Schemes are: "lock", a plain Lock; "rwlock", an RWLock; 
+//	"upgrade", an RWLock whose writers first read, then Upgrade; and
+//	"seqlock", a SeqLock.  A last run, "seqlock preempted writer",
+//	switches a low-priority writer out half way through its write, 
+//	then has a high-priority thread read: the reader must wait for 
+//	the writer, and lend it its priority, rather than spin.  Output 
+//	is comma-separated:
+//	    ./nachos -lt > lock.csv
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "synch.h"
+
+#define LockThreads	8	// threads in each run
+#define LockOps		500	// operations per thread
+#define TableSize	16	// entries in the record
+
+#define WriterPriority	90	// the preempted writer's priority
+#define ReaderPriority	0	// and the reader's
+
+enum LockScheme { PlainLock, ReadersWriter, UpgradeWriter, Sequence };
+static const char *schemeNames[] = { "lock", "rwlock", "upgrade", "seqlock" };
+static int readPercents[] = { 90, 99 };
+
+static int table[TableSize];
+static LockScheme scheme;
+static int readPercent;
+static Lock *mutex;
+static RWLock *rwLock;
+static SeqLock *seqLock;
+static Semaphore *threadsDone;
+static Semaphore *writing;		// the preempted writer has started
+
+//----------------------------------------------------------------------
+// ReadTable
+// 	Copy the record, yielding halfway.  Returns TRUE if the copy is
+//	consistent.
+//----------------------------------------------------------------------
+
+static bool
+ReadTable()
+{
+    int copy[TableSize], i;
+
+    for (i = 0; i < TableSize; i++) {
+	if (i == TableSize / 2)
+	    currentThread->Yield();
+	copy[i] = table[i];
+    }
+    for (i = 1; i < TableSize; i++)
+	if (copy[i] != copy[0])
+	    return FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// WriteTable
+// 	Store "value" in every entry, yielding halfway.
+//----------------------------------------------------------------------
+
+static void
+WriteTable(int value)
+{
+    int i;
+
+    for (i = 0; i < TableSize; i++) {
+	if (i == TableSize / 2)
+	    currentThread->Yield();
+	table[i] = value;
+    }
+}
+
+//----------------------------------------------------------------------
+// LockThread
+// 	Do this thread's share of the operations under the scheme being
+//	measured, checking that every read is consistent.
+//----------------------------------------------------------------------
+
+static void
+LockThread(_int which)
+{
+    int op, value = which * LockOps;
+    bool ok;
+    unsigned seq;
+
+    for (op = 0; op < LockOps; op++) {
+	value++;
+	if ((Random() % 100) < readPercent) {
+	    switch (scheme) {
+	      case PlainLock:
+		mutex->Acquire();
+		ok = ReadTable();
+		mutex->Release();
+		break;
+	      case ReadersWriter:
+	      case UpgradeWriter:
+		rwLock->AcquireRead();
+		ok = ReadTable();
+		rwLock->ReleaseRead();
+		break;
+	      case Sequence:
+		do {
+		    seq = seqLock->ReadBegin();
+		    ok = ReadTable();
+		} while (seqLock->ReadRetry(seq));
+		break;
+	    }
+	    ASSERT(ok);
+	    continue;
+	}
+
+	switch (scheme) {
+	  case PlainLock:
+	    mutex->Acquire();
+	    WriteTable(value);
+	    mutex->Release();
+	    break;
+	  case ReadersWriter:
+	    rwLock->AcquireWrite();
+	    WriteTable(value);
+	    rwLock->ReleaseWrite();
+	    break;
+	  case UpgradeWriter:
+	    rwLock->AcquireRead();
+	    ok = ReadTable();
+	    ASSERT(ok);
+	    if (!rwLock->Upgrade()) {	// someone else is upgrading
+		rwLock->ReleaseRead();
+		rwLock->AcquireWrite();
+	    }
+	    WriteTable(value);
+	    rwLock->ReleaseWrite();
+	    break;
+	  case Sequence:
+	    seqLock->WriteBegin();
+	    WriteTable(value);
+	    seqLock->WriteEnd();
+	    break;
+	}
+    }
+    threadsDone->V();
+}
+
+//----------------------------------------------------------------------
+// LockRun
+// 	Do one run, and print its line.
+//----------------------------------------------------------------------
+
+static void
+LockRun(LockScheme which, int percent)
+{
+    int i, startTicks, startSwitches, ticks, switches, ops;
+
+    scheme = which;
+    readPercent = percent;
+    mutex = new Lock("bench lock");
+    rwLock = new RWLock("bench rwlock");
+    seqLock = new SeqLock("bench seqlock");
+    threadsDone = new Semaphore("lock threads done", 0);
+
+    startTicks = stats->totalTicks;
+    startSwitches = stats->numContextSwitches;
+    for (i = 0; i < LockThreads; i++)
+	(new Thread("lock thread"))->Fork(LockThread, i);
+    for (i = 0; i < LockThreads; i++)
+	threadsDone->P();
+    ticks = stats->totalTicks - startTicks;
+    switches = stats->numContextSwitches - startSwitches;
+    ops = LockThreads * LockOps;
+
+    printf("%s,%d,%d,%d,%d,%d,%d,%d\n", schemeNames[which], percent, 
+	   LockThreads, ops, ticks, switches, 
+	   (int) (ops * 1000.0 / max(ticks, 1)), seqLock->getRetries());
+
+    delete mutex;
+    delete rwLock;
+    delete seqLock;
+    delete threadsDone;
+}
+
+//----------------------------------------------------------------------
+// PreemptedWriter, WaitingReader
+// 	The two threads of the preempted writer run.
+//----------------------------------------------------------------------
+
+static void
+PreemptedWriter(_int value)
+{
+    seqLock->WriteBegin();
+    writing->V();
+    WriteTable(value);
+    seqLock->WriteEnd();
+    threadsDone->V();
+}
+
+static void
+WaitingReader(_int dummy)
+{
+    unsigned seq;
+    bool ok;
+
+    do {
+	seq = seqLock->ReadBegin();
+	ok = ReadTable();
+    } while (seqLock->ReadRetry(seq));
+    ASSERT(ok);
+    threadsDone->V();
+}
+
+//----------------------------------------------------------------------
+// PreemptedWriterRun
+// 	Start a low-priority writer, and once it is in the middle of its
+//	write, a high-priority reader; print the run's line once both 
+//	are done.  We run at the reader's priority meanwhile, so that the
+//	writer only runs when everyone else is waiting.
+//----------------------------------------------------------------------
+
+static void
+PreemptedWriterRun()
+{
+    int oldPriority = currentThread->getBasePriority();
+    int startTicks, startSwitches, ticks, switches;
+
+    seqLock = new SeqLock("bench seqlock");
+    threadsDone = new Semaphore("lock threads done", 0);
+    writing = new Semaphore("writer started", 0);
+
+    currentThread->setPriority(ReaderPriority);
+    startTicks = stats->totalTicks;
+    startSwitches = stats->numContextSwitches;
+    (new Thread("writer", WriterPriority))->Fork(PreemptedWriter, 1);
+    writing->P();
+    (new Thread("reader", ReaderPriority))->Fork(WaitingReader, 0);
+    threadsDone->P();
+    threadsDone->P();
+    ticks = stats->totalTicks - startTicks;
+    switches = stats->numContextSwitches - startSwitches;
+    currentThread->setPriority(oldPriority);
+
+    printf("seqlock preempted writer,50,2,2,%d,%d,%d,%d\n", ticks, 
+	   switches, (int) (2 * 1000.0 / max(ticks, 1)), 
+	   seqLock->getRetries());
+
+    delete seqLock;
+    delete threadsDone;
+    delete writing;
+}
+
+//----------------------------------------------------------------------
+// LockTest
+// 	Run every scheme at every read/write mix, then the preempted 
+//	writer.
+//----------------------------------------------------------------------
+
+void
+LockTest()
+{
+    int p, s;
+
+    printf("scheme,read percent,threads,operations,ticks,switches,"
+	   "operations per 1000 ticks,seqlock retries\n");
+    for (p = 0; p < (int) (sizeof(readPercents) / sizeof(int)); p++)
+	for (s = PlainLock; s <= Sequence; s++)
+	    LockRun((LockScheme) s, readPercents[p]);
+    PreemptedWriterRun();
+}
@@ -8,26 +8,58 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
-//		-s -x <nachos file> -c <consoleIn> <consoleOut>
-//		-f -cp <unix file> <nachos file>
+// Usage: nachos -d <debugflags> -rs <random seed #> -qt -lt -pp -at -pi -dl
+//		-ts -tl -tq <interactive> <normal> <batch> -cpus <# CPUs>
+//		-s -np <# physical pages> -ps <page size>
+//		-tlb <# TLB entries> -tw <TLB ways> -noasid -pt <trace file> -bt
+//		-x <nachos file> -xp <copies> <nachos file>
+//		-c <consoleIn> <consoleOut>
+//		-f -ds <# disk tracks> -dm -snap <snapshot> -commit
+//		-cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -e <network orderability>
+//              -nt <ticks per packet> -nb <ticks per byte>
+//              -pw <period> <budget>
 //              -m <machine id>
-//              -o <other machine id>
+//              -o <other machine id> -ot <other machine id>
+//              -om <other machine id> -sw -oc <test> <# machines>
+//              -fsrv <# machines> -fcli <server id> <file>
 //              -z
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -ts time-slices threads, every TimerTicks
+//    -tl time-slices threads by scheduling class, stopping the timer while
+//	only one thread can run (see Scheduler::SetQuanta)
+//    -tq is -tl with the given time slices, in ticks, for each class
+//    -cpus simulates a multiprocessor with that many CPUs (see threads/cpu.h)
+//    -qt benchmarks the bounded queue (see threads/queuetest.cc)
+//    -lt benchmarks readers-writer and sequence locks (threads/locktest.cc)
+//    -pp benchmarks context switches and the kernel queues (switchtest.cc)
+//    -at tests sleeping on the alarm clock (see threads/alarmtest.cc)
+//    -pi benchmarks priority inversion on locks (threads/inversiontest.cc)
+//    -dl tests EDF reservations (see threads/deadlinetest.cc)
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
+//    -np sets the number of physical pages of user memory
+//    -ps sets the size of a page, in bytes
+//    -tlb runs user programs with a TLB of the given size (0 = page table)
+//    -tw sets the associativity of the TLB (default: fully associative)
+//    -noasid flushes the TLB on every switch between address spaces
+//    -pt writes a trace of page references and faults (see bin/pgreplay)
+//    -bt benchmarks BitMap allocation (see userprog/bitmaptest.cc)
 //    -x runs a user program
+//    -xp runs copies of a user program at once, to benchmark -cpus
 //    -c tests the console
 //
 //  FILESYS
 //    -f causes the physical disk to be formatted
+//    -ds sets the number of tracks on the disk (format it again, with -f)
+//    -dm maps the disk's UNIX file into memory (see machine/disk.h)
+//    -snap starts the disk from a snapshot, discarding what is written to it
+//    -commit keeps what is written, in the snapshot
 //    -cp copies a file from UNIX to Nachos
 //    -p prints a Nachos file to stdout
 //    -r removes a Nachos file from the file system
@@ -38,8 +70,17 @@
 //  NETWORK
 //    -n sets the network reliability
 //    -e sets the network orderability
+//    -nt sets the time to send a packet
+//    -nb sets the time to send each byte of it (1/bandwidth)
+//    -pw reserves CPU time for the postal worker (Scheduler::Reserve)
 //    -m sets this machine's host id (needed for the network)
 //    -o runs a simple test of the Nachos network software
+//    -ot benchmarks the reliable transport (run with -n 0.9 -e 0.9)
+//    -om benchmarks the post office's message rate
+//    -sw sends all packets through the simulated switch (bin/netswitch)
+//    -oc runs a cluster benchmark (see network/cluster.sh)
+//    -fsrv serves this machine's files to the others
+//    -fcli reads a file from the file server, with and without caching
 //
 //  NOTE -- flags are ignored until the relevant assignment.
 //  Some of the flags are interpreted here; some in system.cc.
@@ -61,8 +102,14 @@
 extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
 extern void Print(char *file), PerformanceTest(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out);
-extern void MailTest(int networkID);
-extern void SynchTest(void);
+extern void ParallelProcesses(char *file, int copies);
+extern void BitMapTest(void);
+extern void MailTest(int networkID), StreamTest(int networkID);
+extern void RateTest(int networkID), ClusterTest(char *test, int nodes);
+extern void FileServerTest(int nodes), FileClientTest(int server, char *file);
+extern void SynchTest(void), QueueTest(void), LockTest(void);
+extern void SwitchTest(void), AlarmTest(void), InversionTest(void);
+extern void DeadlineTest(void);
 
 //----------------------------------------------------------------------
 // main
@@ -98,11 +145,31 @@ main(int argc, char **argv)
 	argCount = 1;
         if (!strcmp(*argv, "-z"))               // print copyright
             printf ("%s", copyright);
+#ifdef THREADS
+        if (!strcmp(*argv, "-qt"))		// benchmark bounded queues
+            QueueTest();
+        if (!strcmp(*argv, "-lt"))		// benchmark read-mostly locks
+            LockTest();
+        if (!strcmp(*argv, "-pp"))		// benchmark context switches
+            SwitchTest();
+        if (!strcmp(*argv, "-at"))		// test the alarm clock
+            AlarmTest();
+        if (!strcmp(*argv, "-pi"))		// benchmark priority inversion
+            InversionTest();
+        if (!strcmp(*argv, "-dl"))		// test EDF reservations
+            DeadlineTest();
+#endif // THREADS
 #ifdef USER_PROGRAM
+        if (!strcmp(*argv, "-bt"))		// benchmark bitmaps
+            BitMapTest();
         if (!strcmp(*argv, "-x")) {        	// run a user program
 	    ASSERT(argc > 1);
             StartProcess(*(argv + 1));
             argCount = 2;
+        } else if (!strcmp(*argv, "-xp")) {	// benchmark the CPUs
+	    ASSERT(argc > 2);
+            ParallelProcesses(*(argv + 2), atoi(*(argv + 1)));
+            argCount = 3;
         } else if (!strcmp(*argv, "-c")) {      // test the console
 	    if (argc == 1)
 	        ConsoleTest(NULL, NULL);
@@ -145,6 +212,30 @@ main(int argc, char **argv)
 						// start up another nachos
             MailTest(atoi(*(argv + 1)));
             argCount = 2;
+        } else if (!strcmp(*argv, "-ot")) {
+	    ASSERT(argc > 1);
+            Delay(2); 				// give the other nachos time
+            StreamTest(atoi(*(argv + 1)));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-om")) {
+	    ASSERT(argc > 1);
+            Delay(2); 				// give the other nachos time
+            RateTest(atoi(*(argv + 1)));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-oc")) {
+	    ASSERT(argc > 2);
+            Delay(2); 				// let the whole cluster start
+            ClusterTest(*(argv + 1), atoi(*(argv + 2)));
+            argCount = 3;
+        } else if (!strcmp(*argv, "-fsrv")) {
+	    ASSERT(argc > 1);
+            FileServerTest(atoi(*(argv + 1)));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-fcli")) {
+	    ASSERT(argc > 2);
+            Delay(2); 				// give the server time to start
+            FileClientTest(atoi(*(argv + 1)), *(argv + 2));
+            argCount = 3;
         }
 #endif // NETWORK
     }
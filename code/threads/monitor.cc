@@ -0,0 +1,226 @@
+// monitor.cc 
+//	Routines for monitors with Mesa or Hoare signaling.
+//
+//	As with the other synchronization routines, atomicity comes 
+//	from disabling interrupts; a thread that has to wait is put on 
+//	a queue, and is woken already owning the monitor.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "monitor.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Monitor::Monitor
+// 	Initialize a monitor, with no one inside.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"signalStyle" says whether its conditions signal Mesa- or 
+//		Hoare-style.
+//----------------------------------------------------------------------
+
+Monitor::Monitor(const char* debugName, SignalStyle signalStyle)
+{
+    name = (char*)debugName;
+    style = signalStyle;
+    owner = NULL;
+    entry = new ThreadQueue;
+    urgent = new ThreadQueue;
+}
+
+//----------------------------------------------------------------------
+// Monitor::~Monitor
+// 	De-allocate a monitor, when no one is using it any more.
+//----------------------------------------------------------------------
+
+Monitor::~Monitor()
+{
+    ASSERT(owner == NULL);
+    delete entry;
+    delete urgent;
+}
+
+//----------------------------------------------------------------------
+// Monitor::Enter
+// 	Take the monitor if it is free; otherwise, wait on the entry 
+//	queue until whoever leaves hands it to us.
+//----------------------------------------------------------------------
+
+void
+Monitor::Enter()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(owner != currentThread);	// monitors are not re-entrant
+    if (owner == NULL)
+	owner = currentThread;
+    else {
+	entry->Append(currentThread);
+	currentThread->Sleep();
+	ASSERT(owner == currentThread);	// HandOff gave it to us
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Monitor::Exit
+// 	Leave the monitor.
+//----------------------------------------------------------------------
+
+void
+Monitor::Exit()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(owner == currentThread);
+    HandOff();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Monitor::HandOff
+// 	The current thread is leaving the monitor (or waiting).  Give it
+//	to a Hoare signaller waiting to get back in, if any; otherwise
+//	to the first thread on the entry queue; otherwise mark it free.
+//
+//	Called with interrupts off.
+//----------------------------------------------------------------------
+
+void
+Monitor::HandOff()
+{
+    Thread *next = urgent->Remove();
+
+    if (next == NULL)
+	next = entry->Remove();
+    owner = next;
+    if (next != NULL)
+	scheduler->ReadyToRun(next);
+}
+
+//----------------------------------------------------------------------
+// Monitor::isHeldByCurrentThread
+//----------------------------------------------------------------------
+
+bool
+Monitor::isHeldByCurrentThread()
+{
+    return owner == currentThread;
+}
+
+//----------------------------------------------------------------------
+// MonitorCondition::MonitorCondition
+// 	Initialize a condition of "monitor", with no one waiting.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+MonitorCondition::MonitorCondition(const char* debugName, Monitor *monitor)
+{
+    name = (char*)debugName;
+    mon = monitor;
+    queue = new ThreadQueue;
+}
+
+//----------------------------------------------------------------------
+// MonitorCondition::~MonitorCondition
+// 	De-allocate a condition, when no one is waiting on it.
+//----------------------------------------------------------------------
+
+MonitorCondition::~MonitorCondition()
+{
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// MonitorCondition::Wait
+// 	Leave the monitor and sleep until signaled.  Whoever wakes us 
+//	has already handed us the monitor.
+//----------------------------------------------------------------------
+
+void
+MonitorCondition::Wait()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(mon->owner == currentThread);
+    queue->Append(currentThread);
+    mon->HandOff();
+    currentThread->Sleep();
+    ASSERT(mon->owner == currentThread);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// MonitorCondition::Wake
+// 	Wake up "waiter", which has been taken off our queue.  Mesa-style,
+//	it joins the monitor's entry queue -- ahead of new arrivals, so 
+//	it is not overtaken -- and we carry on.  Hoare-style, we give it
+//	the monitor and wait to get it back.
+//
+//	Called with interrupts off.
+//----------------------------------------------------------------------
+
+void
+MonitorCondition::Wake(Thread *waiter)
+{
+    if (mon->style == MesaSignal)
+	mon->entry->Prepend(waiter);
+    else {
+	mon->urgent->Prepend(currentThread);
+	mon->owner = waiter;
+	scheduler->ReadyToRun(waiter);
+	currentThread->Sleep();
+	ASSERT(mon->owner == currentThread);
+    }
+}
+
+//----------------------------------------------------------------------
+// MonitorCondition::Signal
+// 	Wake up the first waiter, if any.
+//----------------------------------------------------------------------
+
+void
+MonitorCondition::Signal()
+{
+    Thread *waiter;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(mon->owner == currentThread);
+    waiter = queue->Remove();
+    if (waiter != NULL)
+	Wake(waiter);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// MonitorCondition::Broadcast
+// 	Wake up every thread waiting now, in the order they waited.  
+//	(Mesa-style, so that they end up in that order at the front of
+//	the entry queue, wake them last first.)  Threads that wait again
+//	while we are doing so, Hoare-style, stay asleep.
+//----------------------------------------------------------------------
+
+void
+MonitorCondition::Broadcast()
+{
+    Thread *waiter;
+    ThreadQueue *woken;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(mon->owner == currentThread);
+    woken = new ThreadQueue;
+    while ((waiter = queue->Remove()) != NULL) {
+	if (mon->style == MesaSignal)
+	    woken->Prepend(waiter);
+	else
+	    woken->Append(waiter);
+    }
+    while ((waiter = woken->Remove()) != NULL)
+	Wake(waiter);
+    delete woken;
+    (void) interrupt->SetLevel(oldLevel);
+}
@@ -0,0 +1,97 @@
+// monitor.h 
+//	Data structures for monitors: a lock plus condition variables, 
+//	with either Mesa or Hoare signaling.
+//
+//	A thread calls Enter to get into the monitor and Exit to leave;
+//	in between it may Wait on, or Signal, the monitor's conditions.
+//
+//	With *Mesa* signaling, Signal moves a waiter onto the monitor's
+//	entry queue and the signaller carries on; the waiter gets the
+//	monitor when it is next free, and must recheck its condition, 
+//	since another thread may have got in first.
+//
+//	With *Hoare* signaling, Signal hands the monitor straight to the 
+//	waiter, which runs at once with its condition still true; the 
+//	signaller waits on an "urgent" queue, and gets the monitor back
+//	(ahead of anyone entering) when the waiter leaves or waits.
+//
+//	Either way, the monitor is always handed directly from the 
+//	thread leaving it to the next one to run.  A woken thread never
+//	has to compete for the monitor, nor go back to sleep because 
+//	someone else holds it -- unlike Condition, where a thread woken
+//	while the signaller still holds the lock runs only to block 
+//	again in Lock::Acquire.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#include "copyright.h"
+#include "thread.h"
+
+enum SignalStyle { MesaSignal, HoareSignal };
+
+// The following class defines a monitor: its mutual exclusion, and
+// the queues of threads waiting to get in.
+
+class MonitorCondition;
+
+class Monitor {
+  public:
+    Monitor(const char* debugName, SignalStyle signalStyle);
+    ~Monitor();			// assumes no one is in or waiting
+    char* getName() { return name; }
+    SignalStyle getStyle() { return style; }
+
+    void Enter();		// wait until the monitor is free, then
+				// take it
+    void Exit();		// hand the monitor to the next thread, 
+				// if any
+    bool isHeldByCurrentThread();
+
+  private:
+    friend class MonitorCondition;
+    void HandOff();		// give the monitor away; interrupts off
+
+    char* name;
+    SignalStyle style;
+    Thread *owner;		// thread in the monitor, NULL if none
+    ThreadQueue *entry;		// threads waiting to Enter (and, with
+				// Mesa signaling, signalled waiters)
+    ThreadQueue *urgent;	// Hoare signallers waiting to get back in
+};
+
+// The following class defines a condition variable of a monitor.  All
+// operations must be made from inside the monitor.
+//
+//	Wait() -- leave the monitor and sleep until signaled; returns
+//		back inside the monitor
+//
+//	Signal() -- wake up a waiter, if there is one
+//
+//	Broadcast() -- wake up every waiter.  With Hoare signaling, each
+//		runs in turn before the broadcaster gets the monitor back.
+
+class MonitorCondition {
+  public:
+    MonitorCondition(const char* debugName, Monitor *monitor);
+    ~MonitorCondition();
+    char* getName() { return name; }
+
+    void Wait();
+    void Signal();
+    void Broadcast();
+    bool HasWaiters() { return !queue->IsEmpty(); }
+
+  private:
+    void Wake(Thread *waiter);	// wake a waiter; interrupts off
+
+    char* name;
+    Monitor *mon;		// the monitor this condition belongs to
+    ThreadQueue *queue;		// threads waiting on the condition
+};
+
+#endif // MONITOR_H
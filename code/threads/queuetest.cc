@@ -0,0 +1,177 @@
+// queuetest.cc 
+//	Benchmark for the bounded producer/consumer queue.
+//
+//	Each run moves QueueMessages messages from a set of producer 
+//	threads to a set of consumer threads, and counts the context 
+//	switches it took.  We vary the signaling style, the queue's 
+//	capacity, the number of producers and consumers, and the batch 
+//	size handed to PutN and GetN.
+//
+//	For comparison, each capacity and thread mix is also run through
+//	the design used by the monitor and demo1 Ring: a ring guarded by
+//	three semaphores, with a Yield after every message.
+//
+//	Output is one line per run, comma-separated, for a spreadsheet:
+//	    ./nachos -qt > queue.csv
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "synch.h"
+#include "boundedqueue.h"
+
+#define QueueMessages	4096	// messages moved in each run
+#define MaxBatch	8
+
+static int capacities[] = { 1, 4, 16, 64 };
+static int mixes[][2] = { {1, 1}, {4, 4}, {1, 4}, {4, 1} };	// producers,
+								// consumers
+static int batches[] = { 1, MaxBatch };
+
+// The run in progress
+static BoundedQueue *queue;
+static int batch;			// items per PutN or GetN (0: semaphores)
+static int perProducer, perConsumer;	// messages each must move
+static Semaphore *consumersDone;
+
+// The semaphore ring, when batch == 0
+static void **ring;
+static int ringSize, ringIn, ringOut;
+static Semaphore *slots, *items, *mutex;
+
+//----------------------------------------------------------------------
+// Producer, Consumer
+// 	Move this thread's share of the messages through the queue, 
+//	"batch" at a time; or, for the baseline, one at a time through
+//	the semaphore ring, yielding after each.
+//----------------------------------------------------------------------
+
+static void
+Producer(_int which)
+{
+    void *buffer[MaxBatch];
+    int sent, n, i;
+
+    for (sent = 0; sent < perProducer; sent += n) {
+	n = (batch == 0) ? 1 : min(batch, perProducer - sent);
+	for (i = 0; i < n; i++)
+	    buffer[i] = (void *) (which * perProducer + sent + i);
+	if (batch > 0) {
+	    queue->PutN(buffer, n);
+	    continue;
+	}
+	slots->P();
+	mutex->P();
+	ring[ringIn] = buffer[0];
+	ringIn = (ringIn + 1) % ringSize;
+	mutex->V();
+	items->V();
+	currentThread->Yield();
+    }
+}
+
+static void
+Consumer(_int which)
+{
+    void *buffer[MaxBatch];
+    int received, n;
+
+    for (received = 0; received < perConsumer; received += n) {
+	if (batch > 0) {
+	    n = queue->GetN(buffer, min(batch, perConsumer - received));
+	    continue;
+	}
+	n = 1;
+	items->P();
+	mutex->P();
+	buffer[0] = ring[ringOut];
+	ringOut = (ringOut + 1) % ringSize;
+	mutex->V();
+	slots->V();
+	currentThread->Yield();
+    }
+    consumersDone->V();
+}
+
+//----------------------------------------------------------------------
+// QueueRun
+// 	Do one run, and print its line.  "style" is ignored for the 
+//	semaphore baseline (batchSize 0).
+//----------------------------------------------------------------------
+
+static void
+QueueRun(SignalStyle style, int capacity, int producers, int consumers,
+	 int batchSize)
+{
+    int i, startTicks, startSwitches, ticks, switches;
+
+    batch = batchSize;
+    perProducer = QueueMessages / producers;
+    perConsumer = QueueMessages / consumers;
+    consumersDone = new Semaphore("consumers done", 0);
+    if (batch > 0)
+	queue = new BoundedQueue("bench queue", capacity, style);
+    else {
+	ring = new void *[capacity];
+	ringSize = capacity;
+	ringIn = ringOut = 0;
+	slots = new Semaphore("ring slots", capacity);
+	items = new Semaphore("ring items", 0);
+	mutex = new Semaphore("ring mutex", 1);
+    }
+
+    startTicks = stats->totalTicks;
+    startSwitches = stats->numContextSwitches;
+    for (i = 0; i < producers; i++)
+	(new Thread("producer"))->Fork(Producer, i);
+    for (i = 0; i < consumers; i++)
+	(new Thread("consumer"))->Fork(Consumer, i);
+    for (i = 0; i < consumers; i++)
+	consumersDone->P();
+    currentThread->Yield();		// let the producers finish
+    ticks = stats->totalTicks - startTicks;
+    switches = stats->numContextSwitches - startSwitches;
+
+    printf("%s,%d,%d,%d,%d,%d,%d,%d,%.2f\n", 
+	   (batch == 0) ? "semaphores" 
+			: ((style == MesaSignal) ? "mesa" : "hoare"),
+	   capacity, producers, consumers, batch, QueueMessages, ticks, 
+	   switches, (float) QueueMessages / max(switches, 1));
+
+    delete consumersDone;
+    if (batch > 0)
+	delete queue;
+    else {
+	delete [] ring;
+	delete slots;
+	delete items;
+	delete mutex;
+    }
+}
+
+//----------------------------------------------------------------------
+// QueueTest
+// 	Run the whole benchmark.
+//----------------------------------------------------------------------
+
+void
+QueueTest()
+{
+    int c, m, b;
+
+    printf("style,capacity,producers,consumers,batch,messages,ticks,"
+	   "switches,messages per switch\n");
+    for (c = 0; c < (int) (sizeof(capacities) / sizeof(int)); c++)
+	for (m = 0; m < (int) (sizeof(mixes) / sizeof(mixes[0])); m++) {
+	    QueueRun(MesaSignal, capacities[c], mixes[m][0], mixes[m][1], 0);
+	    for (b = 0; b < (int) (sizeof(batches) / sizeof(int)); b++) {
+		QueueRun(MesaSignal, capacities[c], mixes[m][0], 
+			 mixes[m][1], batches[b]);
+		QueueRun(HoareSignal, capacities[c], mixes[m][0], 
+			 mixes[m][1], batches[b]);
+	    }
+	}
+}
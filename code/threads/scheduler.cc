@@ -4,7 +4,8 @@
 //
 // 	These routines assume that interrupts are already disabled.
 //	If interrupts are disabled, we can assume mutual exclusion
-//	(since we are on a uniprocessor).
+//	(since we are on a uniprocessor, or a simulated multiprocessor
+//	whose CPUs only take turns when interrupts are on -- cpu.h).
 //
 // 	NOTE: We can't use Locks to provide mutual exclusion here, since
 // 	if we needed to wait for a lock, and the lock was busy, we would 
@@ -25,13 +26,16 @@
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads to empty.
+//	Time slicing, if any, is left to the timer until SetQuanta.
 //----------------------------------------------------------------------
 
 Scheduler::Scheduler()
 { 
-    for (int i = 0; i < NUM_PRIORITY_LEVELS; i++) {
-        readyList[i] = new List;
-    }
+    for (int i = 0; i < MaxCPUs; i++)
+	numReady[i] = 0;
+    reserved = 0;
+    for (int i = 0; i < NUM_SCHED_CLASSES; i++)
+	quantum[i] = 0;
 } 
 
 //----------------------------------------------------------------------
@@ -41,9 +45,6 @@ Scheduler::Scheduler()
 
 Scheduler::~Scheduler()
 { 
-    for (int i = 0; i < NUM_PRIORITY_LEVELS; i++) {
-        delete readyList[i];
-    }
 } 
 
 //----------------------------------------------------------------------
@@ -51,25 +52,109 @@ Scheduler::~Scheduler()
 // 	Mark a thread as ready, but not running.
 //	Put it on the ready list, for later scheduling onto the CPU.
 //
+//	On a multiprocessor, it goes on the ready list of the CPU it 
+//	last ran on, which may have the thread's memory cached -- or 
+//	this one's, if it has never run.  If that CPU is halted, it 
+//	gets an IPI to wake it up; if not, one that is halted does, so
+//	that it can take the thread over.
+//
+//	A thread with a reservation goes on the EDF list instead -- 
+//	unless it has used up its budget for the period, in which case 
+//	it stays blocked, and the alarm puts it back when the next 
+//	period starts.
+//
 //	"thread" is the thread to be put on the ready list.
 //----------------------------------------------------------------------
 
 void
 Scheduler::ReadyToRun (Thread *thread)
 {
-    DEBUG('t', "Putting thread %s on ready list with priority %d.\n", 
-          thread->getName(), thread->getPriority());
+    Reservation *r = thread->reservation;
+    int which = (thread->cpu >= 0) ? thread->cpu : currentCPU->getId();
+
+    if (r != NULL) {
+	if (thread == currentThread)	// yielding, so it's been running
+	    (void) Charge(thread);
+	else
+	    Replenish(thread, TRUE);	// waking up
+	if (r->used >= r->budget) {
+	    DEBUG('t', "Holding back thread %s until %d.\n", 
+		  thread->getName(), r->deadline);
+	    stats->numThrottles++;
+	    thread->setStatus(BLOCKED);
+	    alarmClock->ReadyAt(thread, r->deadline);
+	    return;
+	}
+	DEBUG('t', "Putting thread %s on EDF list with deadline %d.\n", 
+	      thread->getName(), r->deadline);
+	thread->setStatus(READY);
+	edfList.Insert(thread, r->deadline);
+    } else {
+	DEBUG('t', "Putting thread %s on ready list with priority %d.\n", 
+	      thread->getName(), thread->getPriority());
 
-    thread->setStatus(READY);
-    // Insert thread into the appropriate priority queue
-    int priority = thread->getPriority();
-    readyList[priority]->Append((void *)thread);
+	thread->setStatus(READY);
+	// Insert thread into the appropriate priority queue
+	int priority = thread->getPriority();
+	thread->cpu = which;
+	readyList[which][priority].Append(thread);
+	numReady[which]++;
+    }
+
+    if (cpus[which]->IsHalted())
+	cpus[which]->Wake();
+    else
+	for (int i = 0; i < numCPUs; i++)
+	    if (cpus[i]->IsHalted()) {
+		cpus[i]->Wake();
+		break;
+	    }
+
+    // if the timer was stopped because the running thread had the CPU
+    // to itself, it now has someone to share with
+    if ((thread != currentThread) && (timer != NULL) && timer->IsStopped()
+				  && (Quantum(currentThread) > 0))
+	timer->Start(Slice(currentThread));
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Requeue
+// 	Move a ready thread whose priority has just changed -- by priority
+//	inheritance, say -- from the ready list for "oldPriority" to the
+//	one for its new priority, at the back.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Requeue(Thread *thread, int oldPriority)
+{
+    ThreadQueue *lists;
+
+    if (thread->reservation != NULL)	// on the EDF list, which goes by
+	return;				// deadline, not priority
+    lists = readyList[thread->cpu];
+    if (lists[oldPriority].Remove(thread))
+	lists[thread->getPriority()].Append(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::IsEmpty
+// 	Return TRUE if no other thread is ready to run on this CPU:
+//	none is on its ready lists, or the EDF list.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::IsEmpty()
+{
+    return (numReady[currentCPU->getId()] == 0) && edfList.IsEmpty();
 }
 
 //----------------------------------------------------------------------
 // Scheduler::FindNextToRun
 // 	Return the next thread to be scheduled onto the CPU.
 //	If there are no ready threads, return NULL.
+//
+//	On a multiprocessor, a CPU with no ready threads of its own 
+//	takes one from the CPU with the most.
 // Side effect:
 //	Thread is removed from the ready list.
 //----------------------------------------------------------------------
@@ -77,16 +162,52 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {
+    Thread *nextThread;
+    int me = currentCPU->getId(), busiest = -1;
+
+    // Reserved threads come first, earliest deadline first
+    if (edfList.Remove(&nextThread, NULL)) {
+	DEBUG('t', "Found thread %s with deadline %d to run.\n", 
+	      nextThread->getName(), nextThread->reservation->deadline);
+	return nextThread;
+    }
+
+    if (numReady[me] > 0)
+	return TakeFrom(me);
+    for (int i = 0; i < numCPUs; i++)
+	if ((numReady[i] > 0) && ((busiest < 0) 
+				|| (numReady[i] > numReady[busiest])))
+	    busiest = i;
+    if (busiest < 0)
+	return NULL;  // No threads ready
+    DEBUG('t', "CPU %d taking a thread from CPU %d.\n", me, busiest);
+    currentCPU->steals++;
+    return TakeFrom(busiest);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::TakeFrom
+// 	Remove the first thread on the highest priority ready list of
+//	CPU "cpu" that has threads, and return it.  There must be one.
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::TakeFrom(int cpu)
+{
+    Thread *nextThread;
+
     // Find the highest priority queue that has threads
     for (int i = 0; i < NUM_PRIORITY_LEVELS; i++) {
-        if (!readyList[i]->IsEmpty()) {
-            Thread *nextThread = (Thread *)readyList[i]->Remove();
+        if (!readyList[cpu][i].IsEmpty()) {
+            nextThread = readyList[cpu][i].Remove();
+            numReady[cpu]--;
             DEBUG('t', "Found thread %s with priority %d to run.\n", 
                   nextThread->getName(), i);
             return nextThread;
         }
     }
-    return NULL;  // No threads ready
+    ASSERT(FALSE);
+    return NULL;
 }
 
 //----------------------------------------------------------------------
@@ -117,9 +238,19 @@ Scheduler::Run (Thread *nextThread)
     
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
+    (void) Charge(oldThread);		    // for its reserved CPU time
 
     currentThread = nextThread;		    // switch to the next thread
+    nextThread->cpu = currentCPU->getId();
+    stats->numContextSwitches++;
     currentThread->setStatus(RUNNING);      // nextThread is now running
+    if (nextThread->reservation != NULL) {
+	Replenish(nextThread, FALSE);	    // it may have waited too long
+	nextThread->reservation->since = stats->totalTicks;
+	nextThread->reservation->idleSince = stats->idleTicks;
+    }
+    if ((timer != NULL) && (Slice(nextThread) > 0))
+	timer->Start(Slice(nextThread));    // with a fresh time slice
     
     DEBUG('t', "Switching from thread \"%s\" to thread \"%s\"\n",
 	  oldThread->getName(), nextThread->getName());
@@ -150,7 +281,209 @@ Scheduler::Run (Thread *nextThread)
 #endif
 }
 
-////----------------------------------------------------------------------
+//----------------------------------------------------------------------
+// PrintThread
+// 	Print one thread on a ready list.
+//----------------------------------------------------------------------
+
+static void
+PrintThread(Thread *thread)
+{
+    thread->Print();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SetQuanta
+// 	Turn on tickless time slicing: from now on, each thread runs for
+//	the time slice of its class ("ticks", indexed by SchedClass) 
+//	before it has to yield, and the timer is stopped while no other
+//	thread is ready to run.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SetQuanta(int *ticks)
+{
+    for (int i = 0; i < NUM_SCHED_CLASSES; i++) {
+	ASSERT(ticks[i] > 0);
+	quantum[i] = ticks[i];
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Slice
+// 	Return how long "thread" may run before the timer must interrupt
+//	it: its time slice (Quantum), or what is left of its reserved
+//	budget, whichever is less.  0 if neither applies.
+//----------------------------------------------------------------------
+
+int
+Scheduler::Slice(Thread *thread)
+{
+    int slice = Quantum(thread), left;
+    Reservation *r = thread->reservation;
+
+    if (r != NULL) {
+	left = max(r->budget - r->used, 1);
+	slice = (slice > 0) ? min(slice, left) : left;
+    }
+    return slice;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::MoreUrgent
+// 	Return TRUE if "thread" should run before "other": reserved 
+//	threads before the rest, earliest deadline first, and the rest 
+//	by priority.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::MoreUrgent(Thread *thread, Thread *other)
+{
+    if (thread->reservation != NULL)
+	return (other->reservation == NULL)
+	    || (thread->reservation->deadline < other->reservation->deadline);
+    if (other->reservation != NULL)
+	return FALSE;
+    return thread->getPriority() < other->getPriority();
+}
+
+// thousandths of the CPU a reservation takes, rounded up
+#define ShareOf(period, budget) (((budget) * 1000 + (period) - 1) / (period))
+
+//----------------------------------------------------------------------
+// Scheduler::Reserve
+// 	Give "thread" "budget" ticks of CPU time every "period" ticks,
+//	each by the end of the period, starting now -- if, with the 
+//	reservations already made, that comes to no more than 
+//	EdfUtilization thousandths of the CPU.  Otherwise, change 
+//	nothing, and return FALSE.  A thread may change its own 
+//	reservation this way.
+//
+//	"thread" must not be on the ready list: it is either the 
+//	current thread, blocked, or not yet forked.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::Reserve(Thread *thread, int period, int budget)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Reservation *r = thread->reservation;
+    int share = ShareOf(period, budget);
+    int old = (r != NULL) ? ShareOf(r->period, r->budget) : 0;
+
+    ASSERT((budget > 0) && (budget <= period));
+    ASSERT(thread->getStatus() != READY);
+    if (reserved - old + share > EdfUtilization) {
+	DEBUG('t', "No room to reserve %d of every %d ticks for %s.\n",
+	      budget, period, thread->getName());
+	(void) interrupt->SetLevel(oldLevel);
+	return FALSE;
+    }
+    reserved += share - old;
+    if (r == NULL)
+	r = thread->reservation = new Reservation;
+    r->period = period;
+    r->budget = budget;
+    r->deadline = stats->totalTicks + period;
+    r->used = 0;
+    r->since = stats->totalTicks;
+    r->idleSince = stats->idleTicks;
+
+    StartTimer();			// to enforce the budget
+    if (thread == currentThread)
+	timer->Start(Slice(thread));
+    (void) interrupt->SetLevel(oldLevel);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Unreserve
+// 	Give up "thread"'s reservation; it goes back to being scheduled 
+//	by its priority.  As with Reserve, it must not be on the ready
+//	list.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Unreserve(Thread *thread)
+{
+    Reservation *r = thread->reservation;
+
+    ASSERT(thread->getStatus() != READY);
+    if (r != NULL) {
+	reserved -= ShareOf(r->period, r->budget);
+	delete r;
+	thread->reservation = NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Charge
+// 	Charge a reserved thread that has been running for the CPU time
+//	it has used since it was last charged (leaving out any time the
+//	CPU sat idle while it was asleep).  Return TRUE if it has now 
+//	used up its budget for the period.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::Charge(Thread *thread)
+{
+    Reservation *r = thread->reservation;
+
+    if (r == NULL)
+	return FALSE;
+    r->used += (stats->totalTicks - r->since) 
+				- (stats->idleTicks - r->idleSince);
+    r->since = stats->totalTicks;
+    r->idleSince = stats->idleTicks;
+    if (thread->getStatus() != BLOCKED)	// else when it wakes up
+	Replenish(thread, FALSE);
+    return r->used >= r->budget;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Replenish
+// 	Bring "thread"'s reservation up to date.
+//
+//	A thread that has been ready or running ("waking" FALSE) gets a 
+//	full budget each time a period ends, and the next period's 
+//	deadline.  If it did not get its budget in time, it has missed
+//	its deadline.
+//
+//	A thread that has been blocked ("waking" TRUE) starts a new 
+//	period now, unless what is left of its budget will fit in the 
+//	current one at its reserved rate.  So its new work gets a whole
+//	period, without taking more of the CPU than it reserved (this 
+//	is the "constant bandwidth server" rule).
+//----------------------------------------------------------------------
+
+void
+Scheduler::Replenish(Thread *thread, bool waking)
+{
+    Reservation *r = thread->reservation;
+    int now = stats->totalTicks;
+
+    if (waking) {
+	if ((now >= r->deadline) || ((r->budget - r->used) * r->period 
+					> (r->deadline - now) * r->budget)) {
+	    r->deadline = now + r->period;
+	    r->used = 0;
+	}
+	return;
+    }
+    if (now < r->deadline)
+	return;
+    if (r->used < r->budget) {
+	DEBUG('t', "Thread %s missed its deadline %d, at %d.\n", 
+	      thread->getName(), r->deadline, now);
+	stats->numDeadlineMisses++;
+    }
+    do {				// periods stay in step, however
+	r->deadline += r->period;	// late we notice
+    } while (r->deadline <= now);
+    r->used = 0;
+}
+
+//----------------------------------------------------------------------
 // Scheduler::Print
 // 	Print the scheduler state -- in other words, the contents of
 //	the ready list.  For debugging.
@@ -159,11 +492,14 @@ void
 Scheduler::Print()
 {
     printf("Ready list contents by priority:\n");
-    for (int i = 0; i < NUM_PRIORITY_LEVELS; i++) {
-        if (!readyList[i]->IsEmpty()) {
-            printf("Priority %d: ", i);
-            readyList[i]->Mapcar((VoidFunctionPtr) ThreadPrint);
-            printf("\n");
+    for (int c = 0; c < numCPUs; c++)
+        for (int i = 0; i < NUM_PRIORITY_LEVELS; i++) {
+            if (!readyList[c][i].IsEmpty()) {
+                if (numCPUs > 1)
+                    printf("CPU %d, ", c);
+                printf("Priority %d: ", i);
+                readyList[c][i].Mapcar(PrintThread);
+                printf("\n");
+            }
         }
-    }
 }
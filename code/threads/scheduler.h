@@ -12,6 +12,8 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "typedlist.h"
+#include "cpu.h"
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
@@ -20,20 +22,72 @@
 // Number of priority levels for multi-level queue
 #define NUM_PRIORITY_LEVELS 100
 
+// With time slicing (-tl), each thread gets the time slice of its 
+// scheduling class, a band of priorities: the most urgent threads get
+// short slices, so that they respond quickly, and background threads 
+// long ones, so that they switch less.
+enum SchedClass { InteractiveClass, NormalClass, BatchClass };
+#define NUM_SCHED_CLASSES 3
+#define SchedClassOf(priority) \
+	((SchedClass) ((priority) * NUM_SCHED_CLASSES / NUM_PRIORITY_LEVELS))
+
+// Threads with latency targets can instead reserve "budget" ticks of 
+// CPU time every "period" ticks (Reserve).  They run ahead of every
+// priority, earliest deadline first, and a thread that uses up its 
+// budget waits for its next period.  So that all of them can meet 
+// their deadlines, and the other threads still get some of the CPU, 
+// reservations are only granted up to EdfUtilization thousandths of
+// the CPU in all.
+#define EdfUtilization 900
+
 class Scheduler {
   public:
     Scheduler();			// Initialize list of ready threads 
     ~Scheduler();			// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
+    void Requeue(Thread* thread, int oldPriority);
+					// thread's priority changed while
+					// it was on the ready list
     Thread* FindNextToRun();		// Dequeue first thread on the ready 
 					// list, if any, and return thread.
     void Run(Thread* nextThread);	// Cause nextThread to start running
     void Print();			// Print contents of ready list
+    bool IsEmpty();			// no one else to run, on this CPU?
+    bool MoreUrgent(Thread *thread, Thread *other);
+					// should thread run before other?
+
+    bool Reserve(Thread *thread, int period, int budget);
+					// schedule thread by deadline; 
+					// FALSE if there isn't room
+    void Unreserve(Thread *thread);	// back to its priority
+    bool Charge(Thread *thread);	// account for a reserved thread's
+					// CPU time; TRUE if it has used up
+					// its budget
+
+    void SetQuanta(int *ticks);		// time slice each thread by its
+					// class, stopping the timer while
+					// no one else is ready to run
+    int Quantum(Thread *thread)		// thread's time slice; 0 if we
+	{ return quantum[SchedClassOf(thread->getPriority())]; }
+					// aren't slicing this way
+    int Slice(Thread *thread);		// ... cut short to what is left 
+					// of its budget, if reserved
     
   private:
-    List *readyList[NUM_PRIORITY_LEVELS];  // array of lists for each priority level
-						// priority 0 (highest) to 99 (lowest)
+    ThreadQueue readyList[MaxCPUs][NUM_PRIORITY_LEVELS];
+					// for each CPU, a queue for each 
+					// priority level, priority 0 
+					// (highest) to 99 (lowest)
+    int numReady[MaxCPUs];		// threads on each CPU's ready lists
+    SortedQueue<Thread *> edfList;	// reserved threads, by deadline;
+					// shared by all the CPUs
+    int reserved;			// thousandths of the CPU reserved
+
+    Thread *TakeFrom(int cpu);		// most urgent of cpu's ready threads
+    void Replenish(Thread *thread, bool waking);
+					// start a new period, if it's time
+    int quantum[NUM_SCHED_CLASSES];	// time slice for each class
 };
 
 #endif // SCHEDULER_H
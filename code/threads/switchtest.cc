@@ -0,0 +1,186 @@
+// switchtest.cc
+//	Benchmark of context switching, and of the queues it goes through.
+//
+//	Two ping-pong runs, each timed in host seconds and counted in
+//	context switches:
+//	  - yield: two threads Yield to each other SwitchRounds times
+//	  - semaphore: two threads hand a token back and forth,
+//	    SwitchRounds times, through a pair of semaphores
+//	Every switch goes through the ready list, and every semaphore
+//	handoff through a semaphore's wait queue.
+//
+//	Then the queue operations themselves, with and without the
+//	typed lists (typedlist.h), in host nanoseconds per operation:
+//	  - append and remove a thread, on a List and on a ThreadQueue
+//	  - insert and remove an interrupt with SwitchQueueDepth others
+//	    pending, on a List (SortedInsert/SortedRemove of a new'ed
+//	    PendingInterrupt, as Interrupt::Schedule used to) and on a
+//	    SortedQueue
+//	so that one binary gives both the before and the after.
+//
+//	Output is comma-separated:
+//	    ./nachos -pp > switch.csv
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "synch.h"
+#include "typedlist.h"
+
+#define SwitchRounds	100000	// round trips per ping-pong run
+#define SwitchQueueOps	1000000	// operations timed per queue
+#define SwitchQueueDepth 8	// interrupts already pending
+
+static Semaphore *ping, *pong;
+static Semaphore *done;
+
+//----------------------------------------------------------------------
+// YieldPartner, SemaphorePartner
+// 	The other half of each ping-pong run.
+//----------------------------------------------------------------------
+
+static void
+YieldPartner(_int rounds)
+{
+    for (int i = 0; i < rounds; i++)
+	currentThread->Yield();
+    done->V();
+}
+
+static void
+SemaphorePartner(_int rounds)
+{
+    for (int i = 0; i < rounds; i++) {
+	ping->P();
+	pong->V();
+    }
+    done->V();
+}
+
+//----------------------------------------------------------------------
+// PingPong
+// 	Do one ping-pong run, and print its line.
+//----------------------------------------------------------------------
+
+static void
+PingPong(bool useSemaphores)
+{
+    int startSwitches, startTicks, switches, i;
+    double start, seconds;
+
+    done = new Semaphore("ping-pong done", 0);
+    ping = new Semaphore("ping", 0);
+    pong = new Semaphore("pong", 0);
+
+    startSwitches = stats->numContextSwitches;
+    startTicks = stats->totalTicks;
+    start = WallClock();
+    if (useSemaphores) {
+	(new Thread("partner"))->Fork(SemaphorePartner, SwitchRounds);
+	for (i = 0; i < SwitchRounds; i++) {
+	    ping->V();
+	    pong->P();
+	}
+    } else {
+	(new Thread("partner"))->Fork(YieldPartner, SwitchRounds);
+	for (i = 0; i < SwitchRounds; i++)
+	    currentThread->Yield();
+    }
+    done->P();
+    seconds = WallClock() - start;
+    switches = stats->numContextSwitches - startSwitches;
+
+    printf("%s,%d,%d,%d,%.3f,%.0f\n",
+	   useSemaphores ? "semaphore ping-pong" : "yield ping-pong",
+	   SwitchRounds, stats->totalTicks - startTicks, switches, seconds,
+	   switches / ((seconds > 0) ? seconds : 1e-9));
+
+    delete done;
+    delete ping;
+    delete pong;
+}
+
+//----------------------------------------------------------------------
+// QueueOps
+// 	Time SwitchQueueOps operations on one kind of queue, and print
+//	the line.  The queues are filled the way the kernel would: a
+//	few threads waiting their turn, a few interrupts pending.
+//----------------------------------------------------------------------
+
+static void
+QueueOps(const char *what, bool typed, bool sorted)
+{
+    Thread *threads[SwitchQueueDepth];
+    List list;
+    ThreadQueue queue;
+    SortedQueue<PendingInterrupt> pending;
+    PendingInterrupt event(NULL, 0, 0, TimerInt);
+    int i, when;
+    double start, seconds;
+
+    for (i = 0; i < SwitchQueueDepth; i++) {
+	threads[i] = new Thread("queued");
+	if (sorted && typed)
+	    pending.Insert(event, i * 2);
+	else if (sorted)
+	    list.SortedInsert(new PendingInterrupt(NULL, 0, i * 2, TimerInt),
+			      i * 2);
+	else if (typed)
+	    queue.Append(threads[i]);
+	else
+	    list.Append((void *) threads[i]);
+    }
+
+    // each operation puts one item on and takes one off; on the sorted
+    // queues the new interrupt goes in behind those already pending
+    start = WallClock();
+    for (i = 0; i < SwitchQueueOps; i++) {
+	if (sorted && typed) {
+	    pending.Insert(event, SwitchQueueDepth);
+	    pending.Remove(&event, &when);
+	} else if (sorted) {
+	    list.SortedInsert(new PendingInterrupt(NULL, 0, SwitchQueueDepth,
+						   TimerInt), SwitchQueueDepth);
+	    delete (PendingInterrupt *) list.SortedRemove(&when);
+	} else if (typed)
+	    queue.Append(queue.Remove());
+	else
+	    list.Append((Thread *) list.Remove());
+    }
+    seconds = WallClock() - start;
+
+    printf("%s,%d,,,%.3f,%.0f\n", what, SwitchQueueOps, seconds,
+	   seconds * 1e9 / SwitchQueueOps);
+
+    while (!list.IsEmpty()) {
+	void *item = list.Remove();
+	if (sorted)
+	    delete (PendingInterrupt *) item;
+    }
+    while (queue.Remove() != NULL)
+	;
+    for (i = 0; i < SwitchQueueDepth; i++)
+	delete threads[i];
+}
+
+//----------------------------------------------------------------------
+// SwitchTest
+// 	Run the whole benchmark.  For the ping-pong lines the last column
+//	is switches per host second; for the queue lines, it is host
+//	nanoseconds per operation.
+//----------------------------------------------------------------------
+
+void
+SwitchTest()
+{
+    printf("test,rounds,ticks,switches,seconds,per second or ns per op\n");
+    PingPong(FALSE);
+    PingPong(TRUE);
+    QueueOps("List append/remove", FALSE, FALSE);
+    QueueOps("ThreadQueue append/remove", TRUE, FALSE);
+    QueueOps("List sorted insert/remove", FALSE, TRUE);
+    QueueOps("SortedQueue insert/remove", TRUE, TRUE);
+}
@@ -37,7 +37,7 @@ Semaphore::Semaphore(const char* debugName, int initialValue)
 {
     name = (char*)debugName;
     value = initialValue;
-    queue = new List;
+    queue = new ThreadQueue;
 }
 
 //----------------------------------------------------------------------
@@ -67,7 +67,7 @@ Semaphore::P()
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
     
     while (value == 0) { 			// semaphore not available
-	queue->Append((void *)currentThread);	// so go to sleep
+	queue->Append(currentThread);		// so go to sleep
 	currentThread->Sleep();
     } 
     value--; 					// semaphore available, 
@@ -76,6 +76,25 @@ Semaphore::P()
     (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
 }
 
+//----------------------------------------------------------------------
+// Semaphore::TryP
+// 	Decrement the semaphore value if it is > 0, and return TRUE;
+//	otherwise return FALSE at once, rather than wait.  Can be called
+//	by a thread that must not block.
+//----------------------------------------------------------------------
+
+bool
+Semaphore::TryP()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    bool taken = (value > 0);
+
+    if (taken)
+	value--;
+    (void) interrupt->SetLevel(oldLevel);
+    return taken;
+}
+
 //----------------------------------------------------------------------
 // Semaphore::V
 // 	Increment semaphore value, waking up a waiter if necessary.
@@ -90,7 +109,7 @@ Semaphore::V()
     Thread *thread;
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-    thread = (Thread *)queue->Remove();
+    thread = queue->Remove();
     if (thread != NULL)	   // make thread ready, consuming the V immediately
 	scheduler->ReadyToRun(thread);
     value++;
@@ -103,14 +122,30 @@ Semaphore::V()
 // 	Initialize a lock, so that it can be used for synchronization.
 //
 //	"debugName" is an arbitrary name, useful for debugging.
+//	"how" is the protocol by which the owner's priority is raised;
+//	by default, it inherits the priority of its waiters.
+//	"ceilingPriority" is the priority the owner runs at, at least,
+//	under PriorityCeiling.
 //----------------------------------------------------------------------
 
-
 Lock::Lock(const char* debugName) 
 {
     name = (char*)debugName;
     owner = NULL;
-    lock = new Semaphore(name,1);
+    waiters = new ThreadQueue;
+    protocol = InheritPriority;
+    ceiling = 0;
+    nextHeld = NULL;
+}
+
+Lock::Lock(const char* debugName, LockProtocol how, int ceilingPriority) 
+{
+    name = (char*)debugName;
+    owner = NULL;
+    waiters = new ThreadQueue;
+    protocol = how;
+    ceiling = ceilingPriority;
+    nextHeld = NULL;
 }
 
 
@@ -121,40 +156,140 @@ Lock::Lock(const char* debugName)
 //----------------------------------------------------------------------
 Lock::~Lock() 
 {
-    delete lock;
+    delete waiters;
 }
 
 //----------------------------------------------------------------------
 // Lock::Acquire
-//      Use a binary semaphore to implement the lock.  Record which 
-//      thread acquired the lock in order to assure that only the
-//      same thread releases it.
+//      Wait until the lock is FREE, then record the current thread as
+//      its owner, so that only the same thread releases it.
+//
+//      While we wait, the owner runs at our priority, at least; once
+//      we own the lock, we run at the priority it demands.  Unless the
+//      lock is NoInheritance, Release hands it straight to the waiter
+//      it wakes, so we may wake up owning it already.
 //----------------------------------------------------------------------
 void Lock::Acquire() 
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);  // disable interrupts
 
-    lock->P();                            // procure the semaphore
+    ASSERT(owner != currentThread);	  // we would wait forever
+    while (owner != NULL) {		  // lock BUSY, so go to sleep
+	waiters->Append(currentThread);
+	if (protocol != NoInheritance) {
+	    currentThread->waitingOn = this;
+	    owner->UpdatePriority();	  // lend it our priority
+	}
+	currentThread->Sleep();
+	if (owner == currentThread) {	  // handed over by Lock::Unlock
+	    (void) interrupt->SetLevel(oldLevel);
+	    return;
+	}
+    }
     owner = currentThread;                // record the new owner of the lock
+    if (protocol != NoInheritance) {
+	currentThread->waitingOn = NULL;
+	nextHeld = currentThread->heldLocks;
+	currentThread->heldLocks = this;
+	currentThread->UpdatePriority();
+    }
     (void) interrupt->SetLevel(oldLevel); // re-enable interrupts
 }
 
 //----------------------------------------------------------------------
 // Lock::Release
-//      Set the lock to be free (i.e. vanquish the semaphore).  Check
-//      that the currentThread is allowed to release this lock.
+//      Give up the lock, waking up a waiter if there is one (see 
+//      Unlock).  Check that the currentThread is allowed to release
+//      this lock.
+//
+//      Unless this is a NoInheritance, if the thread woken (or any other) 
+//      is now more urgent than we are, let it run.
 //----------------------------------------------------------------------
 void Lock::Release() 
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);  // disable interrupts
+    int heldAt = currentThread->getPriority();
+    Thread *thread;
 
     // Ensure: a) lock is BUSY  b) this thread is the same one that acquired it.
     ASSERT(currentThread == owner);        
-    owner = NULL;                          // clear the owner
-    lock->V();                             // vanquish the semaphore
+    thread = Unlock();
+    if ((protocol != NoInheritance) 
+	    && (((thread != NULL) 
+		 && (thread->getPriority() < currentThread->getPriority()))
+		|| (currentThread->getPriority() > heldAt)))
+	currentThread->Yield();
     (void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Lock::Unlock
+//      Set the lock to be FREE, give up any priority it lent us, and
+//      put the waiter to be served next on the ready list.  Return it,
+//      or NULL if no one was waiting.
+//
+//      A NoInheritance lock is left free: the waiter tries again for it
+//      when it runs, and another thread may get there first.  Otherwise
+//      the waiter is made the owner here, so that the most urgent 
+//      waiter really is served next.
+//
+//      Called with interrupts disabled, by the owner.
+//----------------------------------------------------------------------
+Thread *
+Lock::Unlock()
+{
+    Thread *thread, *next;
+    Lock **held;
+
+    owner = NULL;                          // clear the owner
+    if (protocol == NoInheritance)
+	thread = waiters->Remove();	   // first come, first served
+    else {
+	for (held = &currentThread->heldLocks; *held != this; 
+						held = &(*held)->nextHeld)
+	    ASSERT(*held != NULL);
+	*held = nextHeld;
+	nextHeld = NULL;
+	currentThread->UpdatePriority();
+
+	thread = waiters->First();	   // most urgent first
+	for (next = thread; next != NULL; next = next->queueLink.next)
+	    if (next->getPriority() < thread->getPriority())
+		thread = next;
+	if (thread != NULL) {
+	    waiters->Remove(thread);
+	    thread->waitingOn = NULL;
+	    owner = thread;		   // hand it over, as Acquire would
+	    nextHeld = thread->heldLocks;
+	    thread->heldLocks = this;
+	    thread->UpdatePriority();
+	}
+    }
+    if (thread != NULL)
+	scheduler->ReadyToRun(thread);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// Lock::Demand
+//      Return the priority the owner must run at, at least, while it 
+//      holds the lock: that of its most urgent waiter, or the ceiling.
+//
+//      Called with interrupts disabled.
+//----------------------------------------------------------------------
+int
+Lock::Demand()
+{
+    int demand = NUM_PRIORITY_LEVELS - 1;
+
+    if (protocol == PriorityCeiling)
+	demand = ceiling;
+    for (Thread *next = waiters->First(); next != NULL; 
+					next = next->queueLink.next)
+	demand = min(demand, next->getPriority());
+    return demand;
+}
+
 
 //----------------------------------------------------------------------
 // Lock::isHeldByCurrentThread
@@ -179,7 +314,7 @@ bool Lock::isHeldByCurrentThread()
 Condition::Condition(const char* debugName) 
 { 
     name = (char*)debugName;
-    queue = new List;
+    queue = new ThreadQueue;
     lock = NULL;
 }
 
@@ -213,7 +348,8 @@ void Condition::Wait(Lock* conditionLock)
     } 
     ASSERT(lock == conditionLock); // another pre-condition
     queue->Append(currentThread);  // add this thread to the waiting list
-    conditionLock->Release();      // release the lock
+    conditionLock->Unlock();       // release the lock; we can't yield, 
+				   // being on the queue already
     currentThread->Sleep();        // goto sleep
     conditionLock->Acquire();      // awaken: re-acquire the lock
     (void) interrupt->SetLevel(oldLevel);
@@ -234,7 +370,7 @@ void Condition::Signal(Lock* conditionLock)
     ASSERT(conditionLock->isHeldByCurrentThread());
     if(!queue->IsEmpty()) {
 	ASSERT(lock == conditionLock);
-	nextThread = (Thread *)queue->Remove();
+	nextThread = queue->Remove();
 	scheduler->ReadyToRun(nextThread);      // wake up the thread
     } 
     (void) interrupt->SetLevel(oldLevel);
@@ -255,9 +391,243 @@ void Condition::Broadcast(Lock* conditionLock)
     ASSERT(conditionLock->isHeldByCurrentThread());
     if(!queue->IsEmpty()) {
 	ASSERT(lock == conditionLock);
-	while( (nextThread = (Thread *)queue->Remove()) ) {
+	while( (nextThread = queue->Remove()) ) {
 	    scheduler->ReadyToRun(nextThread);  // wake up the thread
 	}
     } 
     (void) interrupt->SetLevel(oldLevel);
 }
+
+//----------------------------------------------------------------------
+// RWLock::RWLock
+// 	Initialize a readers-writer lock, with no one holding it.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+RWLock::RWLock(const char* debugName)
+{
+    name = (char*)debugName;
+    lock = new Lock(debugName);
+    readOk = new Condition(debugName);
+    writeOk = new Condition(debugName);
+    upgradeOk = new Condition(debugName);
+    readers = waitingWriters = 0;
+    writer = NULL;
+    upgrading = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RWLock::~RWLock
+// 	De-allocate the lock.  Assume no one holds it or is waiting.
+//----------------------------------------------------------------------
+
+RWLock::~RWLock()
+{
+    delete lock;
+    delete readOk;
+    delete writeOk;
+    delete upgradeOk;
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireRead
+//      Wait until no writer holds the lock, is waiting for it, or is
+//	upgrading to it; then join the readers.
+//----------------------------------------------------------------------
+
+void
+RWLock::AcquireRead()
+{
+    lock->Acquire();
+    while ((writer != NULL) || (waitingWriters > 0) || upgrading)
+	readOk->Wait(lock);
+    readers++;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseRead
+//      Leave the readers.  If only an upgrading reader is left, let it
+//	go ahead; if no one is left, let a writer in.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReleaseRead()
+{
+    lock->Acquire();
+    ASSERT(readers > 0);
+    readers--;
+    if (upgrading && (readers == 1))
+	upgradeOk->Signal(lock);
+    else if (readers == 0)
+	writeOk->Signal(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireWrite
+//      Wait until no one else holds the lock, and no reader is 
+//	upgrading; then take it.
+//----------------------------------------------------------------------
+
+void
+RWLock::AcquireWrite()
+{
+    lock->Acquire();
+    waitingWriters++;
+    while ((writer != NULL) || (readers > 0) || upgrading)
+	writeOk->Wait(lock);
+    waitingWriters--;
+    writer = currentThread;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseWrite
+//      Give up the lock: to the next writer if one is waiting, 
+//	otherwise to every waiting reader.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReleaseWrite()
+{
+    lock->Acquire();
+    ASSERT(writer == currentThread);
+    writer = NULL;
+    if (waitingWriters > 0)
+	writeOk->Signal(lock);
+    else
+	readOk->Broadcast(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::Upgrade
+//      Turn our read hold into a write hold, once the other readers 
+//	have left.  New readers and writers wait meanwhile.  Returns 
+//	FALSE, without waiting, if another reader is already upgrading:
+//	neither of us could ever proceed.
+//----------------------------------------------------------------------
+
+bool
+RWLock::Upgrade()
+{
+    lock->Acquire();
+    ASSERT(readers > 0);
+    if (upgrading) {
+	lock->Release();
+	return FALSE;
+    }
+    upgrading = TRUE;
+    while (readers > 1)
+	upgradeOk->Wait(lock);
+    readers--;
+    upgrading = FALSE;
+    writer = currentThread;
+    lock->Release();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// RWLock::Downgrade
+//      Turn our write hold into a read hold.  Other readers may join
+//	us, unless a writer is waiting.
+//----------------------------------------------------------------------
+
+void
+RWLock::Downgrade()
+{
+    lock->Acquire();
+    ASSERT(writer == currentThread);
+    writer = NULL;
+    readers++;
+    if (waitingWriters == 0)
+	readOk->Broadcast(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::isWriteHeldByCurrentThread
+//----------------------------------------------------------------------
+
+bool
+RWLock::isWriteHeldByCurrentThread()
+{
+    return writer == currentThread;
+}
+
+//----------------------------------------------------------------------
+// SeqLock::SeqLock
+// 	Initialize a sequence lock, with no write in progress.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+SeqLock::SeqLock(const char* debugName)
+{
+    name = (char*)debugName;
+    writeLock = new Lock(debugName);
+    sequence = 0;
+    retries = 0;
+}
+
+SeqLock::~SeqLock()
+{
+    delete writeLock;
+}
+
+//----------------------------------------------------------------------
+// SeqLock::ReadBegin
+//      Return the sequence number, once it is even.  A writer can only
+//	be in the middle of a write if it was switched out there, holding
+//	the write lock; wait for it on that.  Yielding would not do: if
+//	we are more urgent than the writer, we would just be picked again.
+//	Waiting on the lock lends the writer our priority.
+//----------------------------------------------------------------------
+
+unsigned
+SeqLock::ReadBegin()
+{
+    unsigned start;
+
+    while ((start = sequence) & 1) {
+	writeLock->Acquire();
+	writeLock->Release();
+    }
+    return start;
+}
+
+//----------------------------------------------------------------------
+// SeqLock::ReadRetry
+//      Return TRUE if a writer has started since ReadBegin returned 
+//	"start", in which case what was read may be inconsistent.
+//----------------------------------------------------------------------
+
+bool
+SeqLock::ReadRetry(unsigned start)
+{
+    if (sequence == start)
+	return FALSE;
+    retries++;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SeqLock::WriteBegin, SeqLock::WriteEnd
+//      Bracket a write.  The sequence number is odd in between.
+//----------------------------------------------------------------------
+
+void
+SeqLock::WriteBegin()
+{
+    writeLock->Acquire();
+    sequence++;
+}
+
+void
+SeqLock::WriteEnd()
+{
+    sequence++;
+    writeLock->Release();
+}
@@ -45,11 +45,12 @@ class Semaphore {
     
     void P();	 // these are the only operations on a semaphore
     void V();	 // they are both *atomic*
+    bool TryP(); // P, if it wouldn't have to wait; FALSE if it would
     
   private:
     char* name;  // useful for debugging
     int value;         // semaphore value, always >= 0
-    List *queue;       // threads waiting in P() for the value to be > 0
+    ThreadQueue *queue;  // threads waiting in P() for the value to be > 0
 };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -63,10 +64,33 @@ class Semaphore {
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).  
+//
+// So that a low-priority thread holding a lock cannot keep a 
+// high-priority thread waiting for it while medium-priority threads
+// run ("priority inversion"), the holder's priority is raised while
+// it holds the lock, by one of these protocols:
+//
+//	InheritPriority -- to that of the most urgent thread waiting
+//		for the lock, passed along any chain of locks held by
+//		waiting threads (the default)
+//
+//	PriorityCeiling -- to the lock's ceiling, the priority of the 
+//		most urgent thread that will ever use it, as soon as it 
+//		is acquired
+//
+//	NoInheritance -- not at all; waiters are woken first come, 
+//		first served, and try again for the lock
+//
+// Under the first two, Release makes the most urgent waiter the owner
+// before it runs, so no other thread can take the lock first, and 
+// lets it run at once if it is more urgent than we are.
+
+enum LockProtocol { NoInheritance, InheritPriority, PriorityCeiling };
 
 class Lock {
   public:
     Lock(const char* debugName);  		// initialize lock to be FREE
+    Lock(const char* debugName, LockProtocol how, int ceilingPriority = 0);
     ~Lock();				// deallocate lock
     char* getName() { return name; }	// debugging assist
 
@@ -78,10 +102,21 @@ class Lock {
 					// checking in Release, and in
 					// Condition variable ops below.
 
+    Thread *getOwner() { return owner; }	// NULL if FREE
+    int Demand();			// priority the owner must run at
+    Lock *nextHeld;			// next lock on the owner's 
+					// heldLocks list
+
   private:
+    friend class Condition;
+    Thread *Unlock();			// Release, without yielding to
+					// the thread woken, if any
+
     char* name;				// for debugging
     Thread *owner;                      // remember who acquired the lock
-    Semaphore *lock;                    // use semaphore for the actual lock
+    ThreadQueue *waiters;		// threads waiting in Acquire
+    LockProtocol protocol;		// how the owner's priority is raised
+    int ceiling;			// for PriorityCeiling
 };
 
 // The following class defines a "condition variable".  A condition
@@ -133,8 +168,92 @@ class Condition {
 
   private:
     char* name;
-    List* queue;  // threads waiting on the condition
+    ThreadQueue* queue;  // threads waiting on the condition
     Lock* lock;   // debugging aid:  used to check correctness of
                   // arguments to Wait, Signal and Broacast
 };
+
+// The following class defines a "readers-writer lock".  Any number of
+// readers may hold the lock at once, or a single writer:
+//
+//	AcquireRead/ReleaseRead -- share the lock with other readers
+//
+//	AcquireWrite/ReleaseWrite -- hold the lock alone
+//
+//	Upgrade -- turn a read hold into a write hold, without letting
+//		another writer in between.  Only one reader can be 
+//		upgrading at a time: if another already is, Upgrade returns
+//		FALSE (still holding the read lock), and the caller must 
+//		ReleaseRead and AcquireWrite instead.
+//
+//	Downgrade -- turn a write hold into a read hold
+//
+// Writers have preference: once a writer is waiting, new readers wait
+// behind it, so a steady stream of readers cannot starve writers.
+
+class RWLock {
+  public:
+    RWLock(const char* debugName);	// initialize lock to be FREE
+    ~RWLock();
+    char* getName() { return name; }
+
+    void AcquireRead();
+    void ReleaseRead();
+    void AcquireWrite();
+    void ReleaseWrite();
+    bool Upgrade();
+    void Downgrade();
+
+    bool isWriteHeldByCurrentThread();
+
+  private:
+    char* name;
+    Lock *lock;				// protects the fields below
+    Condition *readOk;			// readers wait here
+    Condition *writeOk;			// writers wait here
+    Condition *upgradeOk;		// an upgrader waits here for the
+					// other readers to leave
+    int readers;			// threads holding the read lock
+    int waitingWriters;			// threads waiting in AcquireWrite
+    Thread *writer;			// thread holding the write lock
+    bool upgrading;			// a reader is waiting in Upgrade
+};
+
+// The following class defines a "sequence lock", for small records 
+// that are read far more often than written.  Readers never block a 
+// writer, nor each other; instead a reader checks afterwards whether
+// a writer got in, and if so reads again:
+//
+//	do {
+//	    seq = seqLock->ReadBegin();
+//	    ... copy the record ...
+//	} while (seqLock->ReadRetry(seq));
+//
+// Writers are serialized with a Lock, and bump the sequence number
+// before and after they write; it is odd while a write is in progress.
+// The reader's copy may be inconsistent until ReadRetry says it is 
+// not, so it must not act on it -- follow pointers, say -- before then.
+
+class SeqLock {
+  public:
+    SeqLock(const char* debugName);
+    ~SeqLock();
+    char* getName() { return name; }
+
+    unsigned ReadBegin();		// wait out any write in progress, 
+					// and return the sequence number
+    bool ReadRetry(unsigned start);	// did a write happen since
+					// ReadBegin returned "start"?
+    void WriteBegin();
+    void WriteEnd();
+
+    int getRetries() { return retries; }	// reads done over
+
+  private:
+    char* name;
+    Lock *writeLock;			// one writer at a time
+    volatile unsigned sequence;		// odd while a write is in progress
+    int retries;
+};
+
 #endif // SYNCH_H
@@ -18,6 +18,13 @@ Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
+Alarm *alarmClock;			// wakes up sleeping threads
+int numCPUs = 1;			// CPUs simulated
+CPU *cpus[MaxCPUs];			// ... each with its current thread
+CPU *currentCPU;			// the CPU taking its turn
+
+static bool timeSlicing;		// preempt threads on every timer
+					// interrupt (-rs, -ts)
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -29,6 +36,8 @@ SynchDisk   *synchDisk;
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
 Machine *machine;	// user program memory and registers
+PageTrace *pageTrace;	// page reference trace, if any
+ProcessTable *processTable;	// running user programs
 #endif
 
 #ifdef NETWORK
@@ -54,16 +63,56 @@ extern void Cleanup();
 //	if the interrupted thread called Yield at the point it is 
 //	was interrupted.
 //
+//	With tickless time slicing (Scheduler::SetQuanta), there is no 
+//	point switching when no other thread is ready: stop the timer 
+//	instead, until one is (Scheduler::ReadyToRun).  Otherwise give
+//	the thread a slice of its own length, in case it is the one
+//	chosen to run again.
+//
+//	A thread with an EDF reservation (Scheduler::Reserve) is charged
+//	for its CPU time here, and switched out once it has used up its 
+//	budget.  If the timer is only on for that, it does nothing else.
+//
 //	"dummy" is because every interrupt handler takes one argument,
 //		whether it needs it or not.
 //----------------------------------------------------------------------
 static void
 TimerInterruptHandler(_int dummy)
 {
+    if (!scheduler->Charge(currentThread)) {	// unless out of budget
+	if (scheduler->Quantum(currentThread) > 0) {
+	    if (scheduler->IsEmpty()) {
+		timer->Stop();
+		return;
+	    }
+	    timer->Start(scheduler->Slice(currentThread));
+	} else if (!timeSlicing) {
+	    if (scheduler->Slice(currentThread) > 0)
+		timer->Start(scheduler->Slice(currentThread));
+	    else
+		timer->Stop();
+	    return;
+	}
+    }
     if (interrupt->getStatus() != IdleMode)
 	interrupt->YieldOnReturn();
 }
 
+//----------------------------------------------------------------------
+// StartTimer
+// 	Start the timer device, if it isn't running already, for 
+//	enforcing reservations.  Unless we are time slicing, it only
+//	interrupts a reserved thread at the end of its budget.
+//----------------------------------------------------------------------
+void
+StartTimer()
+{
+    if (timer == NULL) {
+	timer = new Timer(TimerInterruptHandler, 0, FALSE);
+	timer->Stop();
+    }
+}
+
 //----------------------------------------------------------------------
 // Initialize
 // 	Initialize Nachos global data structures.  Interpret command
@@ -80,9 +129,12 @@ Initialize(int argc, char **argv)
     int argCount;
     char* debugArgs = (char*)"";
     bool randomYield = FALSE;
+    bool timeSlice = FALSE;	// preempt threads every TimerTicks
+    int quanta[NUM_SCHED_CLASSES] = { 0 };	// ... or by class, ticklessly
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    char *traceFile = NULL;	// where to write the page trace
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
@@ -91,6 +143,7 @@ Initialize(int argc, char **argv)
     double rely = 1;		// network reliability
     double order = 1;           // network orderability
     int netname = 0;		// UNIX socket name
+    int workerPeriod = 0, workerBudget = 0;	// postal worker reservation
 #endif
     
     for (argc--, argv++; argc > 0; argc -= argCount, argv += argCount) {
@@ -108,15 +161,69 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-ts")) {
+	    timeSlice = TRUE;
+	} else if (!strcmp(*argv, "-tl")) {
+	    quanta[InteractiveClass] = TimerTicks;
+	    quanta[NormalClass] = 2 * TimerTicks;
+	    quanta[BatchClass] = 4 * TimerTicks;
+	} else if (!strcmp(*argv, "-tq")) {
+	    ASSERT(argc > NUM_SCHED_CLASSES);
+	    for (int i = 0; i < NUM_SCHED_CLASSES; i++)
+		quanta[i] = atoi(*(argv + 1 + i));	// ticks, by class
+	    argCount = 1 + NUM_SCHED_CLASSES;
+	} else if (!strcmp(*argv, "-cpus")) {
+	    ASSERT(argc > 1);
+	    numCPUs = atoi(*(argv + 1));	// simulate a multiprocessor
+	    ASSERT((numCPUs > 0) && (numCPUs <= MaxCPUs));
+	    argCount = 2;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	else if (!strcmp(*argv, "-np")) {
+	    ASSERT(argc > 1);
+	    NumPhysPages = atoi(*(argv + 1));	// number of physical pages
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-ps")) {
+	    ASSERT(argc > 1);
+	    PageSize = atoi(*(argv + 1));	// page size in bytes
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tlb")) {
+	    ASSERT(argc > 1);
+	    TLBSize = atoi(*(argv + 1));	// 0 for no TLB
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tw")) {
+	    ASSERT(argc > 1);
+	    TLBWays = atoi(*(argv + 1));	// TLB associativity
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-noasid"))
+	    useASIDs = FALSE;
+	else if (!strcmp(*argv, "-pt")) {
+	    ASSERT(argc > 1);
+	    traceFile = *(argv + 1);		// page trace file
+	    argCount = 2;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
 	    format = TRUE;
 #endif
+#ifdef FILESYS
+	if (!strcmp(*argv, "-ds")) {
+	    ASSERT(argc > 1);
+	    diskTracks = atoi(*(argv + 1));	// size of the disk
+	    ASSERT(diskTracks > 0);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-dm"))
+	    diskMapped = TRUE;			// map DISK into memory
+	else if (!strcmp(*argv, "-snap")) {
+	    ASSERT(argc > 1);
+	    diskSnapshot = *(argv + 1);		// start from DISK.<name>
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-commit"))
+	    diskCommit = TRUE;			// keep the changes to it
+#endif
 #ifdef NETWORK
 	if (!strcmp(*argv, "-n")) {
 	    ASSERT(argc > 1);
@@ -130,6 +237,24 @@ Initialize(int argc, char **argv)
 	    ASSERT(argc > 1);
 	    netname = atoi(*(argv + 1));
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-sw")) {
+	    NetworkSwitched = TRUE;		// go through bin/netswitch
+	} else if (!strcmp(*argv, "-nt")) {
+	    ASSERT(argc > 1);
+	    NetworkTime = atoi(*(argv + 1));	// ticks per packet
+	    ASSERT(NetworkTime > 0);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-nb")) {
+	    ASSERT(argc > 1);
+	    NetworkByteTime = atoi(*(argv + 1));	// ticks per byte
+	    ASSERT(NetworkByteTime >= 0);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-pw")) {
+	    ASSERT(argc > 2);
+	    workerPeriod = atoi(*(argv + 1));
+	    workerBudget = atoi(*(argv + 2));
+	    ASSERT((workerBudget > 0) && (workerBudget <= workerPeriod));
+	    argCount = 3;
 	}
 #endif
     }
@@ -138,8 +263,12 @@ Initialize(int argc, char **argv)
     stats = new Statistics();			// collect statistics
     interrupt = new Interrupt;			// start up interrupt handling
     scheduler = new Scheduler();		// initialize the ready queue
-    if (randomYield)				// start the timer (if needed)
-	timer = new Timer(TimerInterruptHandler, 0, randomYield);
+    alarmClock = new Alarm();			// no one is asleep yet
+    if (quanta[0] > 0)				// slice by class
+	scheduler->SetQuanta(quanta);
+    timeSlicing = randomYield || timeSlice;
+    if (randomYield || timeSlice || (quanta[0] > 0))	// start the timer 
+	timer = new Timer(TimerInterruptHandler, 0, randomYield);  // (if needed)
 
     threadToBeDestroyed = NULL;
 
@@ -148,12 +277,21 @@ Initialize(int argc, char **argv)
     // object to save its state. 
     currentThread = new Thread("main");		
     currentThread->setStatus(RUNNING);
+    for (int i = 0; i < numCPUs; i++)		// it runs on CPU 0
+	cpus[i] = new CPU(i);
+    currentCPU = cpus[0];
 
     interrupt->Enable();
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
     
 #ifdef USER_PROGRAM
+    ASSERT(NumPhysPages > 0);
+    ASSERT((PageSize > 0) && ((PageSize % 4) == 0));	// whole words only
     machine = new Machine(debugUserProg);	// this must come first
+    pageTrace = NULL;
+    if (traceFile != NULL)
+	pageTrace = new PageTrace(traceFile);
+    processTable = new ProcessTable();
 #endif
 
 #ifdef FILESYS
@@ -165,7 +303,8 @@ Initialize(int argc, char **argv)
 #endif
 
 #ifdef NETWORK
-    postOffice = new PostOffice(netname, rely, order, 10);
+    postOffice = new PostOffice(netname, rely, order, NumMailBoxes,
+				workerPeriod, workerBudget);
 #endif
 }
 
@@ -182,6 +321,11 @@ Cleanup()
 #endif
     
 #ifdef USER_PROGRAM
+    if (pageTrace != NULL)
+	delete pageTrace;
+    // The process table, and the address spaces in it, are left alone:
+    // a process on another CPU may be half way through a page fault,
+    // and freeing its address space would wait for the core map.
     delete machine;
 #endif
 
@@ -194,6 +338,7 @@ Cleanup()
 #endif
     
     delete timer;
+    delete alarmClock;
     delete scheduler;
     delete interrupt;
     
@@ -15,10 +15,14 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "alarm.h"
+#include "cpu.h"
 
 // Initialization and cleanup routines
 extern void Initialize(int argc, char **argv); 	// Initialization,
 						// called before anything else
+extern void StartTimer();			// Start the timer, if it isn't
+						// already (Scheduler::Reserve)
 extern void Cleanup();				// Cleanup, called when
 						// Nachos is done.
 
@@ -28,10 +32,18 @@ extern Scheduler *scheduler;			// the ready list
 extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
+extern Alarm *alarmClock;			// sleeping threads, by wakeup time
+extern int numCPUs;				// CPUs simulated (-cpus)
+extern CPU *cpus[MaxCPUs];			// ... and each of them
+extern CPU *currentCPU;				// the one taking its turn
 
 #ifdef USER_PROGRAM
 #include "machine.h"
+#include "pagetrace.h"
+#include "process.h"
 extern Machine* machine;	// user program memory and registers
+extern PageTrace* pageTrace;	// page reference trace, if any
+extern ProcessTable* processTable;	// running user programs
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB 
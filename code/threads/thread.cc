@@ -41,13 +41,20 @@ Thread::Thread(const char* threadName)
     parent = currentThread; // 设置父线程为当前线程
 #ifdef USER_PROGRAM
     space = NULL;
+    pid = -1;
 #endif
     // 优先级继承：新线程继承当前线程的优先级
+    // (the priority it was given, not one it has inherited through a lock)
     if (currentThread != NULL) {
-        priority = currentThread->getPriority();
+        priority = currentThread->getBasePriority();
     } else {
         priority = 0; // 默认优先级
     }
+    basePriority = priority;
+    heldLocks = NULL;
+    waitingOn = NULL;
+    reservation = NULL;
+    cpu = -1;
 } 
 
 //----------------------------------------------------------------------
@@ -74,8 +81,14 @@ Thread::Thread(const char* threadName, int threadPriority)
     } else {
         priority = threadPriority;
     }
+    basePriority = priority;
+    heldLocks = NULL;
+    waitingOn = NULL;
+    reservation = NULL;
+    cpu = -1;
 #ifdef USER_PROGRAM
     space = NULL;
+    pid = -1;
 #endif
 }
 
@@ -96,6 +109,8 @@ Thread::~Thread()
     DEBUG('t', "Deleting thread \"%s\"\n", name);
 
     ASSERT(this != currentThread);
+    if (reservation != NULL)
+	scheduler->Unreserve(this);
     if (stack != NULL)
 		DeallocBoundedArray((char *) stack, StackSize * sizeof(_int));
 }
@@ -176,6 +191,11 @@ Thread::CheckOverflow()
 //	so that Scheduler::Run() will call the destructor, once we're
 //	running in the context of a different thread.
 //
+//	On a multiprocessor, the thread that finished before us, on 
+//	another CPU, may still be waiting for that, if that CPU went on
+//	to a thread that was just starting up.  It is no longer running,
+//	so we can delete it now.
+//
 // 	NOTE: we disable interrupts, so that we don't get a time slice 
 //	between setting threadToBeDestroyed, and going to sleep.
 //----------------------------------------------------------------------
@@ -189,6 +209,8 @@ Thread::Finish ()
     
     DEBUG('t', "Finishing thread \"%s\"\n", getName());
     
+    if (threadToBeDestroyed != NULL)
+	delete threadToBeDestroyed;
     threadToBeDestroyed = currentThread;
     Sleep();					// invokes SWITCH
     // not reached
@@ -209,6 +231,13 @@ Thread::Finish ()
 //	atomically.  On return, we re-set the interrupt level to its
 //	original state, in case we are called with interrupts disabled. 
 //
+//	A thread with an EDF reservation that has used up its budget
+//	for the period is not put back on the ready list; it sleeps
+//	until the next period, whether anyone else is ready or not.
+//
+//	A CPU's idle thread doesn't yield; it goes looking for work as
+//	soon as it can (see cpu.cc).
+//
 // 	Similar to Thread::Sleep(), but a little different.
 //----------------------------------------------------------------------
 
@@ -216,13 +245,21 @@ void
 Thread::Yield ()
 {
     Thread *nextThread;
-    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    IntStatus oldLevel;
     
+    if (this == currentCPU->idleThread)
+	return;
+    oldLevel = interrupt->SetLevel(IntOff);
     ASSERT(this == currentThread);
     
     DEBUG('t', "Yielding thread \"%s\"\n", getName());
     
     scheduler->ReadyToRun(this);
+    if (status == BLOCKED) {		// out of reserved CPU time, so
+	Sleep();			// wait for the next period
+	(void) interrupt->SetLevel(oldLevel);
+	return;
+    }
 
     nextThread = scheduler->FindNextToRun();
     ASSERT(nextThread != NULL);
@@ -245,7 +282,8 @@ Thread::Yield ()
 //	we have no thread to run.  "Interrupt::Idle" is called
 //	to signify that we should idle the CPU until the next I/O interrupt
 //	occurs (the only thing that could cause a thread to become
-//	ready to run).
+//	ready to run).  On a multiprocessor, this CPU runs its idle 
+//	thread instead, while the others carry on.
 //
 //	NOTE: we assume interrupts are already disabled, because it
 //	is called from the synchronization routines which must
@@ -264,8 +302,13 @@ Thread::Sleep ()
     DEBUG('t', "Sleeping thread \"%s\"\n", getName());
 
     status = BLOCKED;
-    while ((nextThread = scheduler->FindNextToRun()) == NULL)
+    while ((nextThread = scheduler->FindNextToRun()) == NULL) {
+	if (currentCPU->idleThread != NULL) {
+	    nextThread = currentCPU->idleThread;
+	    break;
+	}
 	interrupt->Idle();	// no one to run, wait for an interrupt
+    }
         
     scheduler->Run(nextThread); // returns when we've been signalled
 }
@@ -404,18 +447,50 @@ Thread::StackAllocate (VoidFunctionPtr func, _int arg)
 // Thread::setPriority
 //	Set the thread's priority with range checking.
 //	Priority must be between 0 and 99 (lower number means higher priority).
+//	A thread holding locks keeps any higher priority it inherited 
+//	through them.
 //----------------------------------------------------------------------
 
 void
 Thread::setPriority(int newPriority)
 {
     if (newPriority < 0) {
-        priority = 0;
+        basePriority = 0;
     } else if (newPriority > 99) {
-        priority = 99;
+        basePriority = 99;
     } else {
-        priority = newPriority;
+        basePriority = newPriority;
+    }
+    UpdatePriority();
+}
+
+//----------------------------------------------------------------------
+// Thread::UpdatePriority
+//	Recompute the thread's priority: its base priority, raised to the
+//	highest priority demanded by any lock it holds (Lock::Demand).
+//	If that changes it, move it to its new ready list, if it is on 
+//	one, and pass the change on to the owner of the lock it is 
+//	waiting for, if any.
+//----------------------------------------------------------------------
+
+void
+Thread::UpdatePriority()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int newPriority = basePriority, oldPriority = priority;
+
+    for (Lock *lock = heldLocks; lock != NULL; lock = lock->nextHeld)
+	newPriority = min(newPriority, lock->Demand());
+    if (newPriority != oldPriority) {
+	DEBUG('t', "Thread \"%s\" priority %d -> %d\n", name, oldPriority,
+	      newPriority);
+	priority = newPriority;
+	if (status == READY)
+	    scheduler->Requeue(this, oldPriority);
+	if ((waitingOn != NULL) && (waitingOn->getOwner() != NULL))
+	    waitingOn->getOwner()->UpdatePriority();
     }
+    (void) interrupt->SetLevel(oldLevel);
 }
 
 #ifdef USER_PROGRAM
@@ -39,6 +39,7 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "typedlist.h"
 
 #ifdef USER_PROGRAM
 #include "machine.h"
@@ -60,6 +61,22 @@
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED };
 
+class Lock;
+
+// The following class defines an earliest-deadline-first reservation
+// (Scheduler::Reserve): "budget" ticks of CPU time in every "period"
+// ticks, each period's worth by the end of the period, its deadline.
+
+class Reservation {
+  public:
+    int period;			// ticks
+    int budget;			// ticks of CPU time per period
+    int deadline;		// end of the current period
+    int used;			// CPU time used so far in this period
+    int since;			// when it was last charged for, if running
+    int idleSince;		// stats->idleTicks then
+};
+
 // external function, dummy routine whose sole job is to call Thread::Print
 extern void ThreadPrint(_int arg);	 
 
@@ -102,12 +119,32 @@ class Thread {
     int getPriority() { return priority; }    // get thread priority
     void setPriority(int newPriority); // set thread priority with range checking
 						// overflowed its stack
+    int getBasePriority() { return basePriority; }  // priority before
+						// any inheritance
+    void UpdatePriority();			// recompute priority after
+						// a change in the locks held
     void setStatus(ThreadStatus st) { status = st; }
+    ThreadStatus getStatus() { return status; }
     char* getName() { return (name); }
     void Print() { printf("%s, ", name); }
     Thread* getParent() { return parent; }  // 获取父线程
     void setParent(Thread* p) { parent = p; }  // 设置父线程
 
+    ListLink<Thread> queueLink;		// for the ready list, or whichever
+					// queue the thread is waiting on --
+					// never more than one at a time
+
+    // Priority inheritance: "priority" is the higher of the base
+    // priority and the priorities passed on through these (Lock)
+    Lock *heldLocks;			// locks held that pass on priority
+    Lock *waitingOn;			// lock we are waiting for, if any
+
+    Reservation *reservation;		// scheduled by deadline, not by
+					// priority, if not NULL
+
+    int cpu;				// CPU whose ready lists it goes on:
+					// the one it last ran on, or -1
+
   private:
     // some of the private data for this class is listed above
     
@@ -115,6 +152,7 @@ class Thread {
 					// NULL if this is the main thread
 					// (If NULL, don't deallocate stack)
     int priority;			// thread priority (lower number means higher priority)
+    int basePriority;			// ... as set, without inheritance
     Thread* parent;			// parent thread for priority inheritance
     ThreadStatus status;		// ready, running or blocked
     char* name;
@@ -122,6 +160,8 @@ class Thread {
     void StackAllocate(VoidFunctionPtr func, _int arg);
     					// Allocate a stack for thread.
 					// Used internally by Fork()
+    friend class CPU;			// ... and for idle threads, which
+					// never go on the ready list
 
 #ifdef USER_PROGRAM
 // A thread running a user program actually has *two* sets of CPU registers -- 
@@ -135,9 +175,14 @@ class Thread {
     void RestoreUserState();		// restore user-level register state
 
     AddrSpace *space;			// User code this thread is running.
+    int pid;				// Process it belongs to, or -1
 #endif
 };
 
+// A queue of threads: the ready list, or the threads waiting on a 
+// synchronization object.
+typedef TypedList<Thread, &Thread::queueLink> ThreadQueue;
+
 // Magical machine-dependent routines, defined in switch.s
 
 extern "C" {
@@ -0,0 +1,220 @@
+// typedlist.h 
+//	Type-safe lists that allocate nothing when items are added.
+//
+//	List (list.h) holds "void *" items, and allocates a ListElement 
+//	for each one added.  The lists here are for the kernel's hot 
+//	paths -- the ready list, the wait queues, the pending interrupts
+//	-- where that allocation, and the casts, are wasted:
+//
+//	TypedList is an "intrusive" list: the link lives inside the item
+//	(a ListLink member), so an item can be on one such list at a 
+//	time, per link, and adding it costs nothing but pointer updates.
+//	A thread, for instance, is either ready or waiting on exactly one
+//	queue, so one link does for all of those.
+//
+//	SortedQueue keeps copies of its items, in order of an integer key,
+//	in nodes taken from a free list of its own; it only allocates
+//	when it grows past the most items it has ever held.
+//
+//	Everything is in this header, so that the compiler can inline it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TYPEDLIST_H
+#define TYPEDLIST_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines the link an item of type T needs in
+// order to go on a TypedList.
+
+template <class T>
+class ListLink {
+  public:
+    ListLink() { next = NULL; onList = FALSE; }
+
+    T *next;			// next item on the list, NULL at the end
+    bool onList;		// catches an item put on two lists at once
+};
+
+// The following class defines an intrusive list of T's, linked 
+// through their member "Link".  For example:
+//
+//	class Thread { ... ListLink<Thread> queueLink; ... };
+//	TypedList<Thread, &Thread::queueLink> readyList;
+//
+// The list does not own its items, and does not delete them.
+
+template <class T, ListLink<T> T::*Link>
+class TypedList {
+  public:
+    TypedList() { first = last = NULL; }
+
+    bool IsEmpty() { return first == NULL; }
+    T *First() { return first; }	// first item, left on the list
+
+    void Append(T *item) {		// put item at the end
+	ListLink<T> *link = &(item->*Link);
+
+	ASSERT(!link->onList);
+	link->onList = TRUE;
+	link->next = NULL;
+	if (first == NULL)
+	    first = item;
+	else
+	    (last->*Link).next = item;
+	last = item;
+    }
+
+    void Prepend(T *item) {		// put item at the front
+	ListLink<T> *link = &(item->*Link);
+
+	ASSERT(!link->onList);
+	link->onList = TRUE;
+	link->next = first;
+	if (first == NULL)
+	    last = item;
+	first = item;
+    }
+
+    T *Remove() {			// take the first item off; NULL if
+	T *item = first;		// the list is empty
+
+	if (item != NULL) {
+	    first = (item->*Link).next;
+	    if (first == NULL)
+		last = NULL;
+	    (item->*Link).next = NULL;
+	    (item->*Link).onList = FALSE;
+	}
+	return item;
+    }
+
+    bool Remove(T *item) {		// take item off, wherever it is;
+	T *prev = NULL, *ptr;		// FALSE if it isn't on this list
+
+	for (ptr = first; (ptr != NULL) && (ptr != item); 
+					ptr = (ptr->*Link).next)
+	    prev = ptr;
+	if (ptr == NULL)
+	    return FALSE;
+	if (prev == NULL)
+	    first = (item->*Link).next;
+	else
+	    (prev->*Link).next = (item->*Link).next;
+	if (last == item)
+	    last = prev;
+	(item->*Link).next = NULL;
+	(item->*Link).onList = FALSE;
+	return TRUE;
+    }
+
+    void Mapcar(void (*func)(T *)) {	// apply func to every item
+	for (T *item = first; item != NULL; item = (item->*Link).next)
+	    (*func)(item);
+    }
+
+  private:
+    T *first;			// head of the list, NULL if empty
+    T *last;			// last item on the list
+};
+
+// The following class defines a queue of T's kept sorted by an integer
+// key, lowest first; items with equal keys come out in the order they
+// went in.  Items are copied in and out.
+
+#define SortedQueueChunk 16	// nodes allocated at a time
+
+template <class T>
+class SortedQueue {
+  public:
+    SortedQueue() { first = freeNodes = NULL; chunks = NULL; }
+    ~SortedQueue() {
+	Chunk *chunk;
+
+	while ((chunk = chunks) != NULL) {
+	    chunks = chunk->next;
+	    delete chunk;
+	}
+    }
+
+    bool IsEmpty() { return first == NULL; }
+
+    void Insert(T item, int key) {	// put item after any with keys
+	Node *node, **ptr;		// <= key
+
+	if (freeNodes == NULL)
+	    Grow();
+	node = freeNodes;
+	freeNodes = node->next;
+	node->item = item;
+	node->key = key;
+	for (ptr = &first; (*ptr != NULL) && ((*ptr)->key <= key); 
+						ptr = &(*ptr)->next)
+	    ;
+	node->next = *ptr;
+	*ptr = node;
+    }
+
+    bool Peek(T *item, int *key) {	// copy out the first item, leaving
+	if (first == NULL)		// it on the queue; FALSE if empty
+	    return FALSE;
+	if (item != NULL)
+	    *item = first->item;
+	if (key != NULL)
+	    *key = first->key;
+	return TRUE;
+    }
+
+    bool Remove(T *item, int *key) {	// take the first item off; FALSE
+	Node *node = first;		// if the queue is empty
+
+	if (node == NULL)
+	    return FALSE;
+	if (item != NULL)
+	    *item = node->item;
+	if (key != NULL)
+	    *key = node->key;
+	first = node->next;
+	node->next = freeNodes;
+	freeNodes = node;
+	return TRUE;
+    }
+
+    void Mapcar(void (*func)(T *)) {	// apply func to every item
+	for (Node *node = first; node != NULL; node = node->next)
+	    (*func)(&node->item);
+    }
+
+  private:
+    struct Node {
+	T item;
+	int key;
+	Node *next;
+    };
+    struct Chunk {
+	Chunk *next;
+	Node nodes[SortedQueueChunk];
+    };
+
+    void Grow() {			// add a chunk of nodes to the free
+	Chunk *chunk = new Chunk;	// list
+	int i;
+
+	chunk->next = chunks;
+	chunks = chunk;
+	for (i = 0; i < SortedQueueChunk; i++) {
+	    chunk->nodes[i].next = freeNodes;
+	    freeNodes = &chunk->nodes[i];
+	}
+    }
+
+    Node *first;		// the queue, in order of key
+    Node *freeNodes;		// unused nodes
+    Chunk *chunks;		// every chunk allocated, for the destructor
+};
+
+#endif // TYPEDLIST_H
@@ -18,12 +18,37 @@
 #include "copyright.h"
 #include "system.h"
 #include "addrspace.h"
-#include "noff.h"
 #include "bitmap.h"
+#include "syscall.h"
+#include "synch.h"
  
 // Static bitmap to keep track of physical page allocation 
 static BitMap* physPageBitmap = NULL;
 
+// The core map: which address space, and which of its virtual pages,
+// occupies each physical frame.  Used to pick and evict a victim
+// when memory is full.  It is shared by every CPU, and a fault can 
+// wait for the disk half way through changing it, so it (and the
+// frame bitmap, and swap) is only touched with coreMapLock held.
+static AddrSpace** frameOwner = NULL;
+static int* frameVPN = NULL;
+static int clockHand = 0;		// next frame the clock looks at
+static Lock* coreMapLock = NULL;
+
+// Swap space for dirty pages that have been evicted.  The file is
+// only created the first time a dirty page has to be written out.
+static BitMap* swapMap = NULL;
+static OpenFile* swapFile = NULL;
+
+// Address space IDs for TLB entries.  ID 0 is never handed out; it is
+// shared by address spaces created when the others are all in use,
+// and its entries belong to whichever of those ran last -- on each
+// CPU, which is why there is a table of owners for each.
+static BitMap* asidMap = NULL;
+static AddrSpace* asidOwner[MaxCPUs][NumASIDs];
+static int* tlbNext[MaxCPUs];		// next way to replace, in each set
+					// of each CPU's TLB
+
 //----------------------------------------------------------------------
 // SwapHeader
 // 	Do little endian to big endian conversion on the bytes in the 
@@ -49,23 +74,27 @@ SwapHeader (NoffHeader *noffH)
 //----------------------------------------------------------------------
 // AddrSpace::AddrSpace
 // 	Create an address space to run a user program.
-//	Load the program from a file "executable", and set everything
-//	up so that we can start executing user instructions.
+//	Nothing is read from "file" except the NOFF header: every
+//	page starts out invalid, and is filled in by PageFault the first
+//	time the program touches it.  Code and initialized data come
+//	from the executable; uninitialized data and the stack are
+//	simply zero-filled, so they cost no I/O at all.
 //
 //	Assumes that the object code file is in NOFF format.
 //
-//	First, set up the translation from program memory to physical 
-//	memory.  For now, this is really simple (1:1), since we are
-//	only uniprogramming, and we have a single unsegmented page table
+//	The address space may be larger than physical memory; when
+//	memory is full, a victim frame is chosen by the clock algorithm.
 //
-//	"executable" is the file containing the object code to load into memory
+//	"file" is the file containing the object code to load into
+//	memory.  It stays open, as "executable", until the address space
+//	is deleted.
 //----------------------------------------------------------------------
 
-AddrSpace::AddrSpace(OpenFile *executable)
+AddrSpace::AddrSpace(OpenFile *file)
 {
-    NoffHeader noffH;
-    unsigned int size;
+    unsigned int i, size;
 
+    executable = file;
     executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
     if ((noffH.noffMagic != NOFFMAGIC) && 
 		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
@@ -79,86 +108,91 @@ AddrSpace::AddrSpace(OpenFile *executable)
     numPages = divRoundUp(size, PageSize);
     size = numPages * PageSize;
 
-    ASSERT(numPages <= NumPhysPages);		// check we're not trying
-						// to run anything too big --
-						// at least until we have
-						// virtual memory
-
     DEBUG('a', "Initializing address space, num pages %d, size %d\n", 
 					numPages, size);
-// Initialize the physical page bitmap if it hasn't been initialized yet
+// Initialize the physical page bitmap and core map if it hasn't been 
+// initialized yet -- NumPhysPages is only known once Initialize has run
     if (physPageBitmap == NULL) {
         physPageBitmap = new BitMap(NumPhysPages);
+        frameOwner = new AddrSpace*[NumPhysPages];
+        frameVPN = new int[NumPhysPages];
+        for (i = 0; i < (unsigned) NumPhysPages; i++)
+            frameOwner[i] = NULL;
+        coreMapLock = new Lock("core map");
+        swapMap = new BitMap(SwapPages);
+        asidMap = new BitMap(NumASIDs);
+        asidMap->Mark(0);
+        for (int c = 0; c < MaxCPUs; c++)
+            for (i = 0; i < NumASIDs; i++)
+                asidOwner[c][i] = NULL;
+        if (machine->tlb != NULL) {
+            for (int c = 0; c < numCPUs; c++) {
+                tlbNext[c] = new int[machine->tlbSets];
+                for (i = 0; i < (unsigned) machine->tlbSets; i++)
+                    tlbNext[c][i] = 0;
+            }
+        }
     }
+    asid = useASIDs ? asidMap->Find() : -1;
+    if (asid < 0)
+        asid = 0;
+    else
+        for (int c = 0; c < numCPUs; c++)
+            asidOwner[c][asid] = this;
 
-// first, set up the translation 
+// first, set up the translation; nothing is resident yet
     pageTable = new TranslationEntry[numPages];
-    for (unsigned int i = 0; i < numPages; i++) {
+    swapSlot = new int[numPages];
+    for (i = 0; i < numPages; i++) {
 	pageTable[i].virtualPage = i;	// virtual page number
-	pageTable[i].physicalPage = physPageBitmap->Find(); // allocate physical page
-	ASSERT(pageTable[i].physicalPage >= 0); // make sure allocation succeeded
-	pageTable[i].valid = TRUE;
+	pageTable[i].physicalPage = -1;
+	pageTable[i].valid = FALSE;
 	pageTable[i].use = FALSE;
 	pageTable[i].dirty = FALSE;
 	pageTable[i].readOnly = FALSE;
+	swapSlot[i] = -1;
     }
 
-    // Print address space information for debugging
-    Print();
-    
-// zero out the entire address space, to zero the unitialized data segment 
-// and the stack segment
-    bzero(machine->mainMemory, size);
-
-// then, copy in the code and data segments into memory using page table mapping
-    if (noffH.code.size > 0) {
-        DEBUG('a', "Initializing code segment, at 0x%x, size %d\n", 
-			noffH.code.virtualAddr, noffH.code.size);
-        
-        // Load code segment using page table mapping
-        for (int i = 0; i < noffH.code.size; i++) {
-            int virtAddr = noffH.code.virtualAddr + i;
-            int virtPage = virtAddr / PageSize;
-            int offset = virtAddr % PageSize;
-            int physPage = pageTable[virtPage].physicalPage;
-            int physAddr = physPage * PageSize + offset;
-            char ch;
-            executable->ReadAt(&ch, 1, noffH.code.inFileAddr + i);
-            machine->mainMemory[physAddr] = ch;
-        }
-    }
-    if (noffH.initData.size > 0) {
-        DEBUG('a', "Initializing data segment, at 0x%x, size %d\n", 
-			noffH.initData.virtualAddr, noffH.initData.size);
-            
-        // Load data segment using page table mapping
-        for (int i = 0; i < noffH.initData.size; i++) {
-            int virtAddr = noffH.initData.virtualAddr + i;
-            int virtPage = virtAddr / PageSize;
-            int offset = virtAddr % PageSize;
-            int physPage = pageTable[virtPage].physicalPage;
-            int physAddr = physPage * PageSize + offset;
-            char ch;
-            executable->ReadAt(&ch, 1, noffH.initData.inFileAddr + i);
-            machine->mainMemory[physAddr] = ch;
-        }
-    }
-
+// no files are open yet; descriptors 0 and 1 are the console
+    for (i = 0; i < MaxOpenFiles; i++)
+        openFiles[i] = NULL;
 
+    if (DebugIsEnabled('a'))
+        Print();
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
-// 	Deallocate an address space, freeing physical pages.
+// 	Deallocate an address space, freeing physical pages and swap
+//	space, and closing the executable and any files left open.
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace()
 {
-    // Free physical pages allocated to this address space
+    for (int fd = 0; fd < MaxOpenFiles; fd++)
+        if (openFiles[fd] != NULL)
+            delete openFiles[fd];
+    for (int c = 0; c < numCPUs; c++)
+        if (asidOwner[c][asid] == this) {
+            if (machine->tlb != NULL)
+                TLBFlush(asid, c);
+            asidOwner[c][asid] = NULL;
+        }
+    if (asid != 0)
+        asidMap->Clear(asid);
+    coreMapLock->Acquire();
     for (unsigned int i = 0; i < numPages; i++) {
-        physPageBitmap->Clear(pageTable[i].physicalPage);
+        if (pageTable[i].valid) {
+            physPageBitmap->Clear(pageTable[i].physicalPage);
+            frameOwner[pageTable[i].physicalPage] = NULL;
+        }
+        if (swapSlot[i] >= 0)
+            swapMap->Clear(swapSlot[i]);
     }
+    coreMapLock->Release();
     delete [] pageTable;
+    delete [] swapSlot;
+    delete executable;
 }
 
 //----------------------------------------------------------------------
@@ -171,12 +205,381 @@ void AddrSpace::Print()
     printf("--- Address Space Information ---\n");
     printf("Number of pages: %d\n", numPages);
     for (unsigned int i = 0; i < numPages; i++) {
-        printf("Virtual page %d -> Physical page %d\n", 
-               pageTable[i].virtualPage, pageTable[i].physicalPage);
+        if (pageTable[i].valid)
+            printf("Virtual page %d -> Physical page %d\n", 
+                   pageTable[i].virtualPage, pageTable[i].physicalPage);
+        else
+            printf("Virtual page %d -> not resident\n", 
+                   pageTable[i].virtualPage);
     }
     printf("------------------------------\n");
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::AllocFrame
+// 	Return a free physical frame, evicting some page if memory is
+//	full.  The victim is chosen by the clock (second chance)
+//	algorithm over all frames, whichever address space owns them.
+//
+//	"evicted" is set to the virtual page that was evicted, or -1,
+//	and "dirty" to whether it had to be written to swap.
+//
+//	Called with coreMapLock held.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::AllocFrame(int *evicted, bool *dirty)
+{
+    int frame = physPageBitmap->Find();
+
+    ASSERT(coreMapLock->isHeldByCurrentThread());
+    *evicted = -1;
+    *dirty = FALSE;
+    if ((frame < 0) && (machine->tlb != NULL)) {
+        // the up to date use bits are in the TLBs
+        for (int c = 0; c < numCPUs; c++) {
+            TranslationEntry *tlb = cpus[c]->GetTLB();
+
+            for (int i = 0; i < TLBSize; i++)
+                if (tlb[i].valid) {
+                    TLBWriteBack(&tlb[i], c);
+                    tlb[i].use = FALSE;
+                }
+        }
+    }
+    while (frame < 0) {
+        AddrSpace *owner = frameOwner[clockHand];
+        TranslationEntry *entry = &owner->pageTable[frameVPN[clockHand]];
+
+        if (entry->use)
+            entry->use = FALSE;		// give it a second chance
+        else {
+            *evicted = frameVPN[clockHand];
+            *dirty = owner->Evict(*evicted);
+            frame = physPageBitmap->Find();
+        }
+        clockHand = (clockHand + 1) % NumPhysPages;
+    }
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PageFault
+// 	Make the page containing "badVAddr" resident, so that the 
+//	faulting instruction can be re-executed.  With a TLB, this is
+//	called on every TLB miss; the page may well be in memory already,
+//	and then all we have to do is refill the TLB.  Returns FALSE if
+//	the address is outside the address space.
+//
+//	Faults on other CPUs, or by threads that run while this one 
+//	waits for the disk, wait for coreMapLock; once we have it, the 
+//	page may have been brought in by one of them already.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::PageFault(int badVAddr)
+{
+    unsigned int vpn = (unsigned) badVAddr / PageSize;
+    int frame, evicted;
+    bool dirty;
+
+    if (vpn >= numPages)
+        return FALSE;
+    if (pageTable[vpn].valid) {		// just a TLB miss, or another
+        if (machine->tlb != NULL)		// thread brought it in
+            TLBLoad(vpn);
+        return TRUE;
+    }
+
+    coreMapLock->Acquire();
+    if (!pageTable[vpn].valid) {
+        stats->numPageFaults++;
+        frame = AllocFrame(&evicted, &dirty);
+        if (pageTrace != NULL)
+            pageTrace->Fault(asid, vpn, evicted, dirty);
+        DEBUG('a', "Page fault at 0x%x, loading page %d into frame %d\n",
+					badVAddr, vpn, frame);
+        LoadPage(vpn, frame);
+        frameOwner[frame] = this;
+        frameVPN[frame] = vpn;
+
+        pageTable[vpn].physicalPage = frame;
+        pageTable[vpn].valid = TRUE;
+        pageTable[vpn].use = FALSE;
+        pageTable[vpn].dirty = FALSE;
+    }
+    if (machine->tlb != NULL)
+        TLBLoad(vpn);
+    coreMapLock->Release();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::LoadPage
+// 	Fill physical page "frame" with the contents of virtual page
+//	"vpn".  A page that was written out to swap comes back from
+//	there; otherwise the page is zeroed and whatever part of the
+//	code and initialized data segments falls in it is read from
+//	the executable.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::LoadPage(int vpn, int frame)
+{
+    char *page = &(machine->mainMemory[frame * PageSize]);
+
+    if (swapSlot[vpn] >= 0) {
+        swapFile->ReadAt(page, PageSize, swapSlot[vpn] * PageSize);
+        stats->numPageIns++;
+        return;
+    }
+
+    bzero(page, PageSize);
+    if (LoadSegment(&noffH.code, vpn, page) + 
+		LoadSegment(&noffH.initData, vpn, page) > 0)
+        stats->numPageIns++;
+    else
+        stats->numZeroFills++;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::LoadSegment
+// 	Copy the part of segment "seg" that overlaps virtual page "vpn"
+//	from the executable into "page".  Returns the number of bytes
+//	read.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::LoadSegment(Segment *seg, int vpn, char *page)
+{
+    int pageStart = vpn * PageSize;
+    int start = max(seg->virtualAddr, pageStart);
+    int end = min(seg->virtualAddr + seg->size, pageStart + PageSize);
+
+    if (start >= end)
+        return 0;
+    executable->ReadAt(page + (start - pageStart), end - start,
+		seg->inFileAddr + (start - seg->virtualAddr));
+    return end - start;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Evict
+// 	Give up the physical frame holding virtual page "vpn".  A dirty
+//	page is written to swap; a clean one can always be brought
+//	back from wherever it came from.  Returns TRUE if the page
+//	was dirty.  Called with coreMapLock held.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::Evict(int vpn)
+{
+    TranslationEntry *entry = &pageTable[vpn];
+    int frame = entry->physicalPage;
+    bool dirty;
+
+    ASSERT(entry->valid);
+    if (machine->tlb != NULL)
+        TLBInvalidate(vpn);		// also picks up the dirty bit
+    DEBUG('a', "Evicting page %d from frame %d%s\n", vpn, frame,
+					entry->dirty ? " (dirty)" : "");
+    if (entry->dirty) {
+        if (swapFile == NULL) {
+            bool created = fileSystem->Create((char *)"SWAP", 
+						SwapPages * PageSize);
+            ASSERT(created);
+            swapFile = fileSystem->Open((char *)"SWAP");
+            ASSERT(swapFile != NULL);
+        }
+        if (swapSlot[vpn] < 0) {
+            swapSlot[vpn] = swapMap->FindNext();
+            ASSERT(swapSlot[vpn] >= 0);		// out of swap space
+        }
+        swapFile->WriteAt(&(machine->mainMemory[frame * PageSize]), 
+			PageSize, swapSlot[vpn] * PageSize);
+        stats->numPageOuts++;
+    }
+    dirty = entry->dirty;
+    entry->valid = FALSE;
+    entry->physicalPage = -1;
+    frameOwner[frame] = NULL;
+    physPageBitmap->Clear(frame);
+    return dirty;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::TLBWriteBack
+// 	The hardware sets the use and dirty bits in the TLB, not in the
+//	page table.  Copy them to the page table entry the TLB "entry"
+//	was loaded from, before the entry is replaced or looked at by
+//	page replacement.  The entry is in the TLB of CPU "cpu".
+//----------------------------------------------------------------------
+
+void
+AddrSpace::TLBWriteBack(TranslationEntry *entry, int cpu)
+{
+    AddrSpace *owner = asidOwner[cpu][entry->asid];
+    TranslationEntry *pte;
+
+    if (owner == NULL)
+        return;
+    pte = &owner->pageTable[entry->virtualPage];
+    ASSERT(pte->valid && (pte->physicalPage == entry->physicalPage));
+    pte->use = pte->use || entry->use;
+    pte->dirty = pte->dirty || entry->dirty;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::TLBFlush
+// 	Invalidate every entry tagged with address space ID "id" in the
+//	TLB of CPU "cpu".  If that is another CPU, and it had any, it is
+//	sent an IPI to shoot them down.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::TLBFlush(int id, int cpu)
+{
+    TranslationEntry *tlb = cpus[cpu]->GetTLB();
+    bool found = FALSE;
+
+    DEBUG('a', "Flushing TLB entries of address space %d\n", id);
+    for (int i = 0; i < TLBSize; i++)
+        if (tlb[i].valid && (tlb[i].asid == id)) {
+            TLBWriteBack(&tlb[i], cpu);
+            tlb[i].valid = FALSE;
+            found = TRUE;
+        }
+    if (found && (cpus[cpu] != currentCPU))
+        cpus[cpu]->ipis++;
+    stats->numTLBFlushes++;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::TLBLoad
+// 	TLB miss handler: copy the page table entry for "vpn", which
+//	must be resident, into the TLB.  The entry goes into an empty
+//	way of the set "vpn" maps to, or else replaces the ways of the
+//	set in round robin order.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::TLBLoad(int vpn)
+{
+    int set = vpn % machine->tlbSets;
+    int first = set * TLBWays;
+    int i, victim = -1, *next = tlbNext[currentCPU->getId()];
+
+    for (i = first; i < first + TLBWays; i++)
+        if (!machine->tlb[i].valid) {
+            victim = i;
+            break;
+        }
+    if (victim < 0) {
+        victim = first + next[set];
+        next[set] = (next[set] + 1) % TLBWays;
+        TLBWriteBack(&machine->tlb[victim], currentCPU->getId());
+    }
+    DEBUG('a', "TLB miss on page %d, loading into entry %d\n", vpn, victim);
+    machine->tlb[victim] = pageTable[vpn];
+    machine->tlb[victim].asid = asid;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::TLBInvalidate
+// 	Remove the TLB entry for "vpn" of this address space, if there
+//	is one, keeping its use and dirty bits.  On a multiprocessor, 
+//	the entry may be in the TLB of any CPU that ran us; each other
+//	CPU that has it is sent an IPI to shoot it down.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::TLBInvalidate(int vpn)
+{
+    int first = (vpn % machine->tlbSets) * TLBWays;
+
+    for (int c = 0; c < numCPUs; c++) {
+        TranslationEntry *tlb = cpus[c]->GetTLB();
+
+        if (asidOwner[c][asid] != this)	// our entries were flushed
+            continue;			// already
+        for (int i = first; i < first + TLBWays; i++)
+            if (tlb[i].valid && (tlb[i].asid == asid) &&
+			(tlb[i].virtualPage == vpn)) {
+                TLBWriteBack(&tlb[i], c);
+                tlb[i].valid = FALSE;
+                if (cpus[c] != currentCPU)
+                    cpus[c]->ipis++;
+            }
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::NumResident
+// 	Return the number of pages of this address space that are
+//	currently in physical memory.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::NumResident()
+{
+    int count = 0;
+
+    for (unsigned int i = 0; i < numPages; i++)
+        if (pageTable[i].valid)
+            count++;
+    return count;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::OpenFd
+// 	Enter "file" into the descriptor table, at the lowest free
+//	OpenFileId.  Returns the OpenFileId, or -1 if too many files are
+//	open already.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::OpenFd(OpenFile *file)
+{
+    for (int fd = ConsoleOutput + 1; fd < MaxOpenFiles; fd++)
+        if (openFiles[fd] == NULL) {
+            openFiles[fd] = file;
+            return fd;
+        }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::GetFile
+// 	Return the file open as "fd", or NULL if "fd" is not an open
+//	file (the console descriptors are not files either).
+//----------------------------------------------------------------------
+
+OpenFile *
+AddrSpace::GetFile(int fd)
+{
+    if ((fd < 0) || (fd >= MaxOpenFiles))
+        return NULL;
+    return openFiles[fd];
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CloseFd
+// 	Close the file open as "fd", and free the descriptor.  Returns
+//	FALSE if "fd" was not open.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::CloseFd(int fd)
+{
+    OpenFile *file = GetFile(fd);
+
+    if (file == NULL)
+        return FALSE;
+    delete file;
+    openFiles[fd] = NULL;
+    return TRUE;
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::InitRegisters
 // 	Set the initial values for the user-level register set.
@@ -225,13 +628,28 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      Without a TLB, tell the machine where to find the page table.
+//	With a TLB, switch the current address space ID; entries of
+//	other address spaces stay cached, unless we share ID 0 with
+//	the address space that ran before us on this CPU.  (The ID is 
+//	set in either case, so that page traces can tell address 
+//	spaces apart.)
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() 
 {
-    machine->pageTable = pageTable;
-    machine->pageTableSize = numPages;
+    int cpu = currentCPU->getId();
+
+    machine->currentASID = asid;
+    if (machine->tlb == NULL) {
+        machine->pageTable = pageTable;
+        machine->pageTableSize = numPages;
+        return;
+    }
+    if (asidOwner[cpu][asid] != this) {
+        TLBFlush(asid, cpu);
+        asidOwner[cpu][asid] = this;
+    }
 }
 
 
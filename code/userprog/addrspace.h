@@ -2,9 +2,11 @@
 //	Data structures to keep track of executing user programs 
 //	(address spaces).
 //
-//	For now, we don't keep any information about address spaces.
-//	The user level CPU state is saved and restored in the thread
-//	executing the user program (see thread.h).
+//	An address space remembers the NOFF segment layout of its
+//	executable and keeps the file open, so that pages are brought
+//	into memory only when the program first touches them (see
+//	AddrSpace::PageFault).  The user level CPU state is saved and
+//	restored in the thread executing the user program (see thread.h).
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -16,14 +18,23 @@
 #include "copyright.h"
 #include "filesys.h"
 #include "bitmap.h"
+#include "noff.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
+#define SwapPages		1024	// number of pages in the swap file
+#define MaxOpenFiles		16	// size of the descriptor table; 
+					// ConsoleInput and ConsoleOutput
+					// (0 and 1) are always "open"
+#define NumASIDs		64	// address space IDs the TLB can tell
+					// apart; ID 0 is shared by any
+					// address spaces that didn't get one
 
 class AddrSpace {
   public:
-    AddrSpace(OpenFile *executable);	// Create an address space,
-					// initializing it with the program
-					// stored in the file "executable"
+    AddrSpace(OpenFile *executable);	// Create an address space for
+					// the program stored in the file
+					// "executable"; the address space
+					// takes ownership of the file
     ~AddrSpace();			// De-allocate an address space
 
     void InitRegisters();		// Initialize user-level CPU registers,
@@ -33,11 +44,55 @@ class AddrSpace {
     void RestoreState();		// info on a context switch 
     void Print();            // Print address space information
 
+    bool PageFault(int badVAddr);	// Bring in the page containing
+					// "badVAddr", and load it into the
+					// TLB if there is one; FALSE if 
+					// the address is out of range
+    bool Evict(int vpn);		// Give up the frame holding "vpn",
+					// saving it to swap if dirty
+    int NumResident();			// Number of pages currently in memory
+
+    int OpenFd(OpenFile *file);		// Enter "file" in the descriptor 
+					// table; returns its OpenFileId, or
+					// -1 if the table is full
+    OpenFile *GetFile(int fd);		// The file open as "fd", or NULL
+    bool CloseFd(int fd);		// Close "fd"; FALSE if not open
+
   private:
+    static int AllocFrame(int *evicted, bool *dirty);
+					// Find a free frame, evicting a
+					// page if memory is full
+    static void TLBWriteBack(TranslationEntry *entry, int cpu);
+					// Copy use/dirty bits of an entry in
+					// a CPU's TLB back to its page table
+					// entry
+    static void TLBFlush(int id, int cpu);
+					// Invalidate all of a CPU's TLB 
+					// entries of an address space ID
+    void TLBLoad(int vpn);		// Put "vpn" into the TLB
+    void TLBInvalidate(int vpn);	// Drop "vpn" from the TLB, if there
+    void LoadPage(int vpn, int frame);	// Fill "frame" with page "vpn"
+    int LoadSegment(Segment *seg, int vpn, char *page);
+					// Copy the part of "seg" that falls
+					// in page "vpn" from the executable
+
     TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+    OpenFile *executable;		// Backing store for code and data
+    NoffHeader noffH;			// Segment layout of "executable"
+    int *swapSlot;			// Swap page holding each virtual
+					// page, or -1 if it was never evicted
+					// dirty
+    int asid;				// Tags this space's TLB entries
+    OpenFile *openFiles[MaxOpenFiles];	// Files open in this address space,
+					// indexed by OpenFileId
 };
 
+// The kernel thread of a new process starts here (exception.cc): set
+// up the user registers for currentThread->space, and jump to user
+// code.  Never returns.
+extern void UserThreadStart(_int dummy);
+
 #endif // ADDRSPACE_H
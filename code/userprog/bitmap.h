@@ -3,7 +3,9 @@
 //	can be either on or off.
 //
 //	Represented as an array of unsigned integers, on which we do
-//	modulo arithmetic to find the bit we are interested in.
+//	modulo arithmetic to find the bit we are interested in.  Searches
+//	go a word at a time, skipping words with no clear bits, and the 
+//	number of clear bits is kept up to date rather than counted.
 //
 //	The bitmap can be parameterized with with the number of bits being 
 //	managed.
@@ -40,10 +42,16 @@ class BitMap {
     void Mark(int which);   	// Set the "nth" bit
     void Clear(int which);  	// Clear the "nth" bit
     bool Test(int which);   	// Is the "nth" bit set?
-    int Find();            	// Return the # of a clear bit, and as a side
-				// effect, set the bit. 
+    int Find();            	// Return the # of the first clear bit, and
+				// as a side effect, set the bit. 
 				// If no bits are clear, return -1.
-    int NumClear();		// Return the number of clear bits
+    int FindNext();		// Like Find, but start looking just past 
+				// the bit FindNext found last time (next
+				// fit), wrapping around at the end
+    int FindRun(int n, int hint);	// Find "n" clear bits in a row, 
+				// at or after "hint" if possible, set them
+				// and return the first; -1 if none
+    int NumClear() { return numClear; }	// Return the number of clear bits
 
     void Print();		// Print contents of bitmap
     
@@ -53,12 +61,21 @@ class BitMap {
     void WriteBack(OpenFile *file); 	// write contents to disk
 
   private:
+    int NextClear(int from);		// # of first clear bit >= from, or
+					// numBits if none
+    int NextSet(int from);		// # of first set bit >= from, or
+					// numBits if none
+    void CountClear();			// recompute numClear from the map
+
     int numBits;			// number of bits in the bitmap
     int numWords;			// number of words of bitmap storage
 					// (rounded up if numBits is not a
 					//  multiple of the number of bits in
 					//  a word)
     unsigned int *map;			// bit storage
+    int numClear;			// number of clear bits
+    int firstClear;			// no bit below this is clear
+    int nextFit;			// where FindNext starts looking
 };
 
 #endif // BITMAP_H
@@ -0,0 +1,154 @@
+// bitmaptest.cc 
+//	Micro-benchmark of BitMap allocation on a large map.
+//
+//	A map of BitMapTestBits bits is filled at random to a given 
+//	fraction, then we time, in host microseconds per call:
+//	  - Find, after freeing a random bit, so the fill stays the same
+//	  - FindNext, the same way
+//	  - FindRun of BitMapTestRun bits, from a random hint, freeing 
+//	    the run again afterwards
+//	  - NumClear
+//	and, for comparison, Find and NumClear done the old way, testing
+//	one bit at a time from bit 0.  These are costs on the host, not
+//	in simulated time, so they are measured with the host clock.
+//
+//	Output is comma-separated:
+//	    ./nachos -bt > bitmap.csv
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "bitmap.h"
+
+#define BitMapTestBits	(1 << 20)
+#define BitMapTestOps	20000		// calls timed per operation
+#define BitMapOldOps	100		// the old way is much slower
+#define BitMapTestRun	8
+
+static int fills[] = { 50, 90, 99 };	// percent of bits set
+
+//----------------------------------------------------------------------
+// OldFind, OldNumClear
+// 	Find and NumClear as they were: test every bit from bit 0.
+//----------------------------------------------------------------------
+
+static int
+OldFind(BitMap *map)
+{
+    for (int i = 0; i < BitMapTestBits; i++)
+	if (!map->Test(i)) {
+	    map->Mark(i);
+	    return i;
+	}
+    return -1;
+}
+
+static int
+OldNumClear(BitMap *map)
+{
+    int count = 0;
+
+    for (int i = 0; i < BitMapTestBits; i++)
+	if (!map->Test(i)) count++;
+    return count;
+}
+
+//----------------------------------------------------------------------
+// FreeRandom
+// 	Clear a randomly chosen set bit, so the next allocation does not
+//	change how full the map is.
+//----------------------------------------------------------------------
+
+static void
+FreeRandom(BitMap *map)
+{
+    int which;
+
+    do {
+	which = Random() % BitMapTestBits;
+    } while (!map->Test(which));
+    map->Clear(which);
+}
+
+//----------------------------------------------------------------------
+// Report
+// 	Print one line: microseconds per call, since "start".
+//----------------------------------------------------------------------
+
+static void
+Report(const char *operation, int fill, int calls, double start)
+{
+    printf("%s,%d,%d,%.3f\n", operation, fill, calls, 
+	   (WallClock() - start) * 1000000.0 / calls);
+}
+
+//----------------------------------------------------------------------
+// BitMapTest
+// 	Time each operation at each fill.  Freeing a random bit is part
+//	of the Find and FindNext times; it is the same for both, and for
+//	the old Find.
+//----------------------------------------------------------------------
+
+void
+BitMapTest()
+{
+    BitMap *map;
+    int f, i, which, clear;
+    double start;
+
+    printf("operation,fill percent,calls,microseconds per call\n");
+    for (f = 0; f < (int) (sizeof(fills) / sizeof(int)); f++) {
+	map = new BitMap(BitMapTestBits);
+	for (i = 0; i < BitMapTestBits; i++)
+	    if ((Random() % 100) < fills[f])
+		map->Mark(i);
+
+	start = WallClock();
+	for (i = 0; i < BitMapTestOps; i++) {
+	    FreeRandom(map);
+	    which = map->Find();
+	    ASSERT(which >= 0);
+	}
+	Report("Find", fills[f], BitMapTestOps, start);
+
+	start = WallClock();
+	for (i = 0; i < BitMapOldOps; i++) {
+	    FreeRandom(map);
+	    which = OldFind(map);
+	    ASSERT(which >= 0);
+	}
+	Report("old Find", fills[f], BitMapOldOps, start);
+
+	start = WallClock();
+	for (i = 0; i < BitMapTestOps; i++) {
+	    FreeRandom(map);
+	    which = map->FindNext();
+	    ASSERT(which >= 0);
+	}
+	Report("FindNext", fills[f], BitMapTestOps, start);
+
+	start = WallClock();
+	for (i = 0; i < BitMapTestOps; i++) {
+	    which = map->FindRun(BitMapTestRun, Random() % BitMapTestBits);
+	    if (which >= 0)
+		for (int j = which; j < which + BitMapTestRun; j++)
+		    map->Clear(j);
+	}
+	Report("FindRun", fills[f], BitMapTestOps, start);
+
+	start = WallClock();
+	for (i = 0; i < BitMapTestOps; i++)
+	    clear = map->NumClear();
+	Report("NumClear", fills[f], BitMapTestOps, start);
+
+	start = WallClock();
+	for (i = 0; i < BitMapOldOps; i++)
+	    ASSERT(OldNumClear(map) == clear);
+	Report("old NumClear", fills[f], BitMapOldOps, start);
+
+	delete map;
+    }
+}
@@ -4,8 +4,9 @@
 //	transfer back to here from user code:
 //
 //	syscall -- The user code explicitly requests to call a procedure
-//	in the Nachos kernel.  Right now, the only function we support is
-//	"Halt".
+//	in the Nachos kernel.  Right now, we support "Halt", "PrintInt",
+//	the process control calls "Exit", "Exec" and "Join", and the file
+//	calls "Create", "Open", "Read", "Write" and "Close".
 //
 //	exceptions -- The user code does something that the CPU can't handle.
 //	For instance, accessing memory that doesn't exist, arithmetic errors,
@@ -14,8 +15,8 @@
 //	Interrupts (which can also cause control to transfer from user
 //	code into the Nachos kernel) are handled elsewhere.
 //
-// For now, this only handles the Halt() system call.
-// Everything else core dumps.
+// Page faults (and TLB misses) are handled too; anything else
+// core dumps.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -26,6 +27,13 @@
 #include "syscall.h"
 #include "addrspace.h"
 #include "thread.h"
+#include "usermem.h"
+#include "synchconsole.h"
+
+#define IOBufferSize	4096	// Read/Write copy through a kernel buffer
+				// of at most this many bytes at a time
+
+static SynchConsole *synchConsole = NULL;	// made on first use
 
 //----------------------------------------------------------------------
 // AdvancePC
@@ -40,20 +48,171 @@ static void AdvancePC()
     machine->WriteRegister(NextPCReg, pc + 4);
 }
 
-// Function to start user program execution in a new thread
-static void UserThreadStart(_int arg)
+//----------------------------------------------------------------------
+// UserThreadStart
+// 	The kernel thread of a new process starts here: set up the
+//	user registers for its address space, and jump to user code.
+//	Exec, and ParallelProcesses (progtest.cc), fork it.
+//----------------------------------------------------------------------
+
+void UserThreadStart(_int arg)
 {
-    // Restore the address space state (page tables)
+    currentThread->space->InitRegisters();
     currentThread->space->RestoreState();
-    
-    // Restore user register state (should have been initialized by space->InitRegisters())
-    currentThread->RestoreUserState();
-    
-    // Start user program execution
+
     machine->Run();
     ASSERT(FALSE); // Should never reach here
 }
 
+//----------------------------------------------------------------------
+// ExecProcess
+// 	Start the program named by the string at user address "nameAddr"
+//	in a process of its own, a child of the current process.  
+//	Returns the new process ID, or -1 if it can't be started.
+//----------------------------------------------------------------------
+
+static int ExecProcess(int nameAddr)
+{
+    char filename[MaxUserString];
+    OpenFile *executable;
+    AddrSpace *space;
+    Thread *thread;
+    int pid;
+
+    if (CopyStringFromUser(nameAddr, filename, MaxUserString) < 0) {
+        printf("Exec: bad file name argument\n");
+        return -1;
+    }
+    DEBUG('a', "Exec(%s) by process %d\n", filename, currentThread->pid);
+
+    executable = fileSystem->Open(filename);
+    if (executable == NULL) {
+        printf("Unable to open file %s\n", filename);
+        return -1;
+    }
+    space = new AddrSpace(executable);	// keeps the file
+    pid = processTable->Create(space, currentThread->pid);
+    if (pid < 0) {
+        printf("Too many processes, can't run %s\n", filename);
+        delete space;
+        return -1;
+    }
+
+    thread = new Thread("user process");
+    thread->space = space;
+    thread->pid = pid;
+    thread->Fork(UserThreadStart, 0);
+    return pid;
+}
+
+//----------------------------------------------------------------------
+// ConsoleIO
+// 	Read or Write on the console: move up to "size" bytes between
+//	user address "addr" and the console, through "buffer".  Like a
+//	UNIX terminal, a read waits for a line and returns at most that
+//	line.  Returns the number of bytes moved; a bad address ends the
+//	transfer early.
+//
+//	The console is only created when a program first uses it, so 
+//	that runs which never touch it have no console interrupts.
+//----------------------------------------------------------------------
+
+static int ConsoleIO(char *buffer, int addr, int size, bool writing)
+{
+    int done = 0, n;
+
+    if (synchConsole == NULL)
+        synchConsole = new SynchConsole(NULL, NULL);
+    if (writing) {
+        fflush(stdout);			// keep order with PrintInt
+        for (; done < size; done += n) {
+            n = min(size - done, IOBufferSize);
+            if (!CopyFromUser(addr + done, buffer, n))
+                break;
+            synchConsole->Write(buffer, n);
+        }
+    } else {
+        n = synchConsole->Read(buffer, min(size, IOBufferSize));
+        if ((n > 0) && CopyToUser(addr, buffer, n))
+            done = n;
+    }
+    return done;
+}
+
+//----------------------------------------------------------------------
+// FileIO
+// 	Read or Write on an open file: move up to "size" bytes between
+//	user address "addr" and the current position of "file", through
+//	"buffer".  Returns the number of bytes moved, which is short at 
+//	the end of the file or on a bad address.
+//----------------------------------------------------------------------
+
+static int FileIO(OpenFile *file, char *buffer, int addr, int size, 
+			bool writing)
+{
+    int done = 0, n, moved;
+
+    while (done < size) {
+        n = min(size - done, IOBufferSize);
+        if (writing) {
+            if (!CopyFromUser(addr + done, buffer, n))
+                break;
+            moved = file->Write(buffer, n);
+        } else {
+            moved = file->Read(buffer, n);
+            if (!CopyToUser(addr + done, buffer, moved))
+                break;
+        }
+        done += moved;
+        if (moved < n)
+            break;
+    }
+    return done;
+}
+
+//----------------------------------------------------------------------
+// ReadWrite
+// 	The Read and Write system calls: move up to "size" bytes between
+//	user address "addr" and descriptor "fd" of the current process.
+//	Returns the number of bytes moved, or -1 if "fd" can't be used
+//	that way.
+//----------------------------------------------------------------------
+
+static int ReadWrite(int addr, int size, OpenFileId fd, bool writing)
+{
+    OpenFile *file = currentThread->space->GetFile(fd);
+    char *buffer;
+    int result;
+
+    if ((size < 0) || ((file == NULL) && 
+		(fd != (writing ? ConsoleOutput : ConsoleInput))))
+        return -1;
+    buffer = new char[IOBufferSize];
+    if (file == NULL)
+        result = ConsoleIO(buffer, addr, size, writing);
+    else
+        result = FileIO(file, buffer, addr, size, writing);
+    delete [] buffer;
+    return result;
+}
+
+//----------------------------------------------------------------------
+// ExitProcess
+// 	Terminate the current process with exit status "status": give
+//	up its address space, and finish its kernel thread.
+//----------------------------------------------------------------------
+
+static void ExitProcess(int status)
+{
+    int pid = currentThread->pid;
+
+    currentThread->space = NULL;	// freed by the process table
+    currentThread->pid = -1;
+    processTable->Exit(pid, status);
+    currentThread->Finish();
+    ASSERT(FALSE); // Should never reach here
+}
+
 //----------------------------------------------------------------------
 // ExceptionHandler
 // 	Entry point into the Nachos kernel.  Called when a user program
@@ -82,59 +241,87 @@ ExceptionHandler(ExceptionType which)
 {
     int type = machine->ReadRegister(2);
 
+    if (which == SyscallException)
+        stats->numSyscalls++;
+
     if ((which == SyscallException) && (type == SC_Halt)) {
         DEBUG('a', "Shutdown, initiated by user program.\n");
         interrupt->Halt();
     } 
+    else if ((which == SyscallException) && (type == SC_Exit)) {
+        ExitProcess(machine->ReadRegister(4));
+    }
     else if ((which == SyscallException) && (type == SC_Exec)) {
-        // Exec system call implementation
-        printf("Execute system call of Exec() \n");
-        char filename[50];
-        int addr = machine->ReadRegister(4);
-        int i = 0;
-        do {
-            machine->ReadMem(addr + i, 1, (int *)&filename[i]);
-        } while (filename[i++] != '\0');
-
-        printf("Exec(%s):\n", filename);
-
-        OpenFile *executable = fileSystem->Open(filename);
-        if (executable == NULL) {
-            printf("Unable to open file %s\n", filename);
-            machine->WriteRegister(2, -1);  // return -1 on failure
-            AdvancePC();
-            return;
-        }
-
-        AddrSpace *space = new AddrSpace(executable);
-        delete executable;
+        machine->WriteRegister(2, ExecProcess(machine->ReadRegister(4)));
+        AdvancePC();
+    }
+    else if ((which == SyscallException) && (type == SC_Join)) {
+        // Wait for a child to exit, and return its exit status; -1 if
+        // "pid" is not a child we may wait for.
+        int pid = machine->ReadRegister(4);
+        int status;
 
-        Thread *thread = new Thread("exec thread");
-        thread->space = space;
+        if (!processTable->Join(pid, currentThread->pid, &status))
+            status = -1;
+        machine->WriteRegister(2, status);
+        AdvancePC();
+    }
+    else if ((which == SyscallException) && 
+		((type == SC_Create) || (type == SC_Open))) {
+        // Create returns 0 on success, Open the new OpenFileId; -1 on
+        // any failure
+        char name[MaxUserString];
+        int result = -1;
+        OpenFile *file;
 
-          
-        // space->RestoreState();
+        if (CopyStringFromUser(machine->ReadRegister(4), name, 
+				MaxUserString) >= 0) {
+            if (type == SC_Create)
+                result = fileSystem->Create(name, 0) ? 0 : -1;
+            else if ((file = fileSystem->Open(name)) != NULL) {
+                result = currentThread->space->OpenFd(file);
+                if (result < 0)
+                    delete file;		// too many open files
+            }
+            DEBUG('a', "%s(%s) = %d\n", 
+		(type == SC_Create) ? "Create" : "Open", name, result);
+        }
+        machine->WriteRegister(2, result);
+        AdvancePC();
+    }
+    else if ((which == SyscallException) && 
+		((type == SC_Read) || (type == SC_Write))) {
+        machine->WriteRegister(2, ReadWrite(machine->ReadRegister(4),
+		machine->ReadRegister(5), machine->ReadRegister(6),
+		type == SC_Write));
+        AdvancePC();
+    }
+    else if ((which == SyscallException) && (type == SC_Close)) {
+        bool closed = currentThread->space->CloseFd(machine->ReadRegister(4));
 
-        machine->WriteRegister(2, (int)space);  // return space pointer as ID
+        machine->WriteRegister(2, closed ? 0 : -1);
+        AdvancePC();
+    }
+    else if ((which == SyscallException) && (type == SC_Sleep)) {
+        // Sleep for the given number of ticks; the CPU goes to other
+        // threads, or idles, until the alarm clock wakes us
+        alarmClock->WaitFor(machine->ReadRegister(4));
         AdvancePC();
-        // Save current thread's user state before forking
-        currentThread->SaveUserState();
-
-        scheduler->ReadyToRun(currentThread);
-
-        currentThread = thread;
-        space->InitRegisters();  
-        space->RestoreState();
-
-        machine->Run();
-        // Use Fork to properly initialize the new thread
-        // Fork will automatically put the new thread on ready queue
-        // thread->Fork((VoidFunctionPtr)UserThreadStart, 0);
-        
-        // // Put current thread on ready queue and yield
-        // // scheduler->ReadyToRun(currentThread);
-        // currentThread->Yield();                 // current thread yields, scheduler will pick next thread
-    
+    }
+    else if (which == PageFaultException) {
+        // A TLB miss, or a page that is not in memory yet.  Bring the
+        // page in; the faulting instruction is re-executed when we
+        // return, since the PC has not been advanced.  An address outside
+        // the address space kills only this process, as if it had called
+        // Exit(-1).
+        int badVAddr = machine->ReadRegister(BadVAddrReg);
+
+        if (!currentThread->space->PageFault(badVAddr)) {
+            printf("Process %d: page fault at bad address 0x%x\n",
+		currentThread->pid, badVAddr);
+            ExitProcess(-1);
+        }
+        return;
     }
     else if ((which == SyscallException) && (type == SC_PrintInt)) {
         // PrintInt system call implementation
@@ -0,0 +1,108 @@
+// pagetrace.cc 
+//	Routines to record a trace of page references and page faults.
+//
+//	The trace is written with the UNIX routines in sysdep.cc, not
+//	through the Nachos file system -- it is meant to be read by
+//	tools running on the host.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "pagetrace.h"
+
+//----------------------------------------------------------------------
+// PageTrace::PageTrace
+// 	Create the trace file "fileName", and write the header.
+//----------------------------------------------------------------------
+
+PageTrace::PageTrace(char *fileName)
+{
+    int magic = PGTRACEMAGIC;
+
+    fd = OpenForWrite(fileName);
+    WriteFile(fd, (char *) &magic, sizeof(int));
+    buffer = new TraceEvent[TraceBufferSize];
+    count = 0;
+    lastSpace = lastVPN = -1;
+}
+
+//----------------------------------------------------------------------
+// PageTrace::~PageTrace
+// 	Write out whatever is left in the buffer, and close the file.
+//----------------------------------------------------------------------
+
+PageTrace::~PageTrace()
+{
+    Flush();
+    Close(fd);
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// PageTrace::Reference
+// 	Record that page "vpn" of address space "space" was referenced,
+//	unless it is the same page as the last one recorded.  Called by 
+//	Machine::Translate on every successful translation, so it has
+//	to be cheap.
+//----------------------------------------------------------------------
+
+void
+PageTrace::Reference(int space, int vpn)
+{
+    if ((vpn == lastVPN) && (space == lastSpace))
+	return;
+    Record(space, vpn, TraceRef, -1, 0);
+}
+
+//----------------------------------------------------------------------
+// PageTrace::Fault
+// 	Record a page fault on page "vpn" of address space "space".
+//	"evicted" is the page that was replaced to make room (-1 if a
+//	frame was free), and "dirty" says whether it had to be written
+//	back.
+//----------------------------------------------------------------------
+
+void
+PageTrace::Fault(int space, int vpn, int evicted, bool dirty)
+{
+    Record(space, vpn, TraceFault, evicted, dirty ? 1 : 0);
+    lastSpace = lastVPN = -1;		// the retried reference counts
+}
+
+//----------------------------------------------------------------------
+// PageTrace::Record
+// 	Add an event to the buffer, writing the buffer out if it is full.
+//----------------------------------------------------------------------
+
+void
+PageTrace::Record(int space, int vpn, int type, int evicted, int dirty)
+{
+    TraceEvent *event = &buffer[count];
+
+    event->tick = stats->totalTicks;
+    event->space = space;
+    event->vpn = vpn;
+    event->type = type;
+    event->evicted = evicted;
+    event->dirty = dirty;
+    lastSpace = space;
+    lastVPN = vpn;
+    if (++count == TraceBufferSize)
+	Flush();
+}
+
+//----------------------------------------------------------------------
+// PageTrace::Flush
+// 	Write the buffered events to the trace file.
+//----------------------------------------------------------------------
+
+void
+PageTrace::Flush()
+{
+    if (count > 0)
+	WriteFile(fd, (char *) buffer, count * sizeof(TraceEvent));
+    count = 0;
+}
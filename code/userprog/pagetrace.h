@@ -0,0 +1,47 @@
+// pagetrace.h 
+//	Data structures to record the page reference string and page
+//	faults of user programs, for offline analysis.
+//
+//	Events are collected in a fixed size buffer in memory, so that
+//	recording a reference is only a few stores; the buffer is
+//	written to the trace file whenever it fills up, and when the
+//	trace is deleted.  The file format is defined in bin/pgtrace.h,
+//	and bin/pgreplay reads it.
+//
+//	Consecutive references to the same page are recorded only
+//	once: they are always hits, under any replacement policy, so
+//	they do not change the fault curves.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGETRACE_H
+#define PAGETRACE_H
+
+#include "copyright.h"
+#include "pgtrace.h"
+
+#define TraceBufferSize		1024	// events buffered before a write
+
+class PageTrace {
+  public:
+    PageTrace(char *fileName);		// Start a trace in "fileName"
+    ~PageTrace();			// Flush the trace and close the file
+
+    void Reference(int space, int vpn);	// Page "vpn" was translated
+    void Fault(int space, int vpn, int evicted, bool dirty);
+					// Page "vpn" was brought in,
+					// replacing "evicted"
+    void Flush();			// Write out the buffered events
+
+  private:
+    void Record(int space, int vpn, int type, int evicted, int dirty);
+
+    int fd;				// UNIX file the trace goes to
+    TraceEvent *buffer;			// Events not yet written
+    int count;				// Number of events in "buffer"
+    int lastSpace, lastVPN;		// The last page recorded
+};
+
+#endif // PAGETRACE_H
@@ -0,0 +1,183 @@
+// process.cc 
+//	Routines to manage the process table: creating processes,
+//	waiting for them to finish, and cleaning up after them.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "process.h"
+
+//----------------------------------------------------------------------
+// Process::Process
+// 	Initialize a process table entry for a running process.
+//----------------------------------------------------------------------
+
+Process::Process(int id, int parentId, AddrSpace *addrSpace)
+{
+    pid = id;
+    parentPid = parentId;
+    space = addrSpace;
+    exited = FALSE;
+    exitStatus = 0;
+}
+
+//----------------------------------------------------------------------
+// Process::~Process
+// 	De-allocate a process table entry.
+//----------------------------------------------------------------------
+
+Process::~Process()
+{
+    if (space != NULL)
+	delete space;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::ProcessTable
+// 	Initialize an empty process table.
+//----------------------------------------------------------------------
+
+ProcessTable::ProcessTable()
+{
+    for (int i = 0; i < MaxProcesses; i++)
+	table[i] = NULL;
+    pidMap = new BitMap(MaxProcesses);
+    lock = new Lock("process table");
+    exited = new Condition("process exited");
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::~ProcessTable
+// 	De-allocate the process table, and any process still in it.
+//----------------------------------------------------------------------
+
+ProcessTable::~ProcessTable()
+{
+    for (int i = 0; i < MaxProcesses; i++)
+	if (table[i] != NULL)
+	    delete table[i];
+    delete pidMap;
+    delete lock;
+    delete exited;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Create
+// 	Enter a new process, running in address space "space", into the
+//	table.  Returns the new process ID, or -1 if there is no room.
+//
+//	"parentPid" is the process that may Join the new one, or
+//	NoParent.
+//----------------------------------------------------------------------
+
+int
+ProcessTable::Create(AddrSpace *space, int parentPid)
+{
+    int pid;
+
+    lock->Acquire();
+    pid = pidMap->Find();
+    if (pid >= 0)
+	table[pid] = new Process(pid, parentPid, space);
+    lock->Release();
+    DEBUG('a', "Created process %d, parent %d\n", pid, parentPid);
+    return pid;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Join
+// 	Wait until process "pid" has exited, store its exit status in
+//	"status", and remove it from the table.  Only the parent of a
+//	process may wait for it, and only once; otherwise, returns FALSE
+//	immediately.
+//----------------------------------------------------------------------
+
+bool
+ProcessTable::Join(int pid, int parentPid, int *status)
+{
+    Process *child;
+
+    if ((pid < 0) || (pid >= MaxProcesses))
+	return FALSE;
+
+    lock->Acquire();
+    child = table[pid];
+    if ((child == NULL) || (child->parentPid != parentPid)) {
+	lock->Release();
+	return FALSE;
+    }
+    while (!child->exited)
+	exited->Wait(lock);
+    *status = child->exitStatus;
+    Free(pid);
+    lock->Release();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Exit
+// 	Process "pid" has finished with exit status "status".  Free its
+//	address space -- the calling thread must no longer be using
+//	it -- and keep the status for the parent to pick up.  A process
+//	that nobody can Join is removed right away.
+//
+//	Children that already exited will never be joined now, so they
+//	are reaped; children that are still running become orphans.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Exit(int pid, int status)
+{
+    Process *process;
+
+    lock->Acquire();
+    process = table[pid];
+    ASSERT(process != NULL && !process->exited);
+    DEBUG('a', "Process %d exited with status %d\n", pid, status);
+
+    delete process->space;
+    process->space = NULL;
+    process->exited = TRUE;
+    process->exitStatus = status;
+
+    for (int i = 0; i < MaxProcesses; i++)
+	if ((table[i] != NULL) && (table[i]->parentPid == pid)) {
+	    if (table[i]->exited)
+		Free(i);
+	    else
+		table[i]->parentPid = NoParent;
+	}
+
+    if (process->parentPid == NoParent)
+	Free(pid);
+    else
+	exited->Broadcast(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::NumProcesses
+// 	Return the number of processes in the table, zombies included.
+//----------------------------------------------------------------------
+
+int
+ProcessTable::NumProcesses()
+{
+    return MaxProcesses - pidMap->NumClear();
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Free
+// 	Delete the entry for process "pid".  Assumes the table is locked.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Free(int pid)
+{
+    delete table[pid];
+    table[pid] = NULL;
+    pidMap->Clear(pid);
+}
@@ -0,0 +1,76 @@
+// process.h 
+//	Data structures to keep track of user processes.
+//
+//	Every user program that is running -- or that has exited, but
+//	whose parent has not collected its exit status yet (a "zombie")
+//	-- has an entry in the process table, indexed by its process ID.
+//	The process ID is what Exec returns to the user program as its
+//	SpaceId.
+//
+//	A process is run by its own kernel thread.  When it exits, its
+//	address space (and with it, its memory and swap space) is freed
+//	right away; only the exit status is kept around until the parent
+//	Joins, or itself exits.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROCESS_H
+#define PROCESS_H
+
+#include "copyright.h"
+#include "addrspace.h"
+#include "bitmap.h"
+#include "synch.h"
+
+#define MaxProcesses	512	// size of the process table
+#define NoParent	-1	// parent ID of an orphaned process
+
+// The following class defines an entry in the process table.
+
+class Process {
+  public:
+    Process(int id, int parentId, AddrSpace *addrSpace);
+    ~Process();				// Also frees the address space,
+					// if the process is still running
+
+    int pid;				// Process ID
+    int parentPid;			// Who may Join us; NoParent if
+					// nobody can
+    AddrSpace *space;			// NULL once the process exited
+    bool exited;			// TRUE for a zombie
+    int exitStatus;			// Valid once "exited" is TRUE
+};
+
+// The process table itself.  All operations are atomic with respect
+// to each other.
+
+class ProcessTable {
+  public:
+    ProcessTable();
+    ~ProcessTable();
+
+    int Create(AddrSpace *space, int parentPid);
+					// Add a process running in "space";
+					// returns its ID, or -1 if the 
+					// table is full
+    bool Join(int pid, int parentPid, int *status);
+					// Wait for child "pid" to exit, and
+					// reap it; FALSE if "pid" is not a
+					// child of "parentPid"
+    void Exit(int pid, int status);	// Process "pid" is done: free its
+					// address space, and reap or orphan
+					// its own children
+    int NumProcesses();			// Number of entries in use
+
+  private:
+    void Free(int pid);			// Remove entry "pid"
+
+    Process *table[MaxProcesses];
+    BitMap *pidMap;			// which process IDs are in use
+    Lock *lock;				// protects the table
+    Condition *exited;			// signalled whenever a process exits
+};
+
+#endif // PROCESS_H
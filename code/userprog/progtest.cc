@@ -16,8 +16,11 @@
 
 //----------------------------------------------------------------------
 // StartProcess
-// 	Run a user program.  Open the executable, load it into
-//	memory, and jump to it.
+// 	Run a user program.  Open the executable, set up its address
+//	space, and jump to it.  Pages are only loaded as the program
+//	touches them, so none are resident when it starts, however big
+//	it is; the pages it went on to load are in the "Paging:"
+//	statistics.
 //----------------------------------------------------------------------
 
 void
@@ -30,20 +33,97 @@ StartProcess(char *filename)
 	printf("Unable to open file %s\n", filename);
 	return;
     }
-    space = new AddrSpace(executable);    
+    space = new AddrSpace(executable);	// the address space keeps
+					// the file open to page from it
     currentThread->space = space;
-
-    delete executable;			// close file
+    currentThread->pid = processTable->Create(space, NoParent);
 
     space->InitRegisters();		// set the initial register values
     space->RestoreState();		// load page table register
 
+    DEBUG('a', "Started %s, %d pages resident\n", filename,
+		space->NumResident());
+
     machine->Run();			// jump to the user progam
     ASSERT(FALSE);			// machine->Run never returns;
 					// the address space exits
 					// by doing the syscall "exit"
 }
 
+//----------------------------------------------------------------------
+// ParallelProcesses
+// 	Scalability benchmark for the multiprocessor (-cpus): start 
+//	"copies" processes running user program "filename", all at once,
+//	and wait until they have all exited.  Then print the time that
+//	took; the CPU time used, over all the CPUs, and what fraction of
+//	their time that was; the context switches, threads taken by idle
+//	CPUs, and IPIs it took; and the copies' exit status, which should
+//	be the same for all of them.
+//
+//	Output is comma-separated, one line per run; for instance
+//	    for n in 1 2 4 8; do ./nachos -cpus $n -xp 8 matmult; done
+//----------------------------------------------------------------------
+
+void
+ParallelProcesses(char *filename, int copies)
+{
+    int *pids = new int[copies];
+    int started, i, status, first = 0, ticks, busy, steals = 0, ipis = 0;
+    int startTicks = stats->totalTicks;
+    int startBusy = stats->systemTicks + stats->userTicks;
+    int startSwitches = stats->numContextSwitches;
+    OpenFile *executable;
+    AddrSpace *space;
+    Thread *thread;
+
+    for (i = 0; i < numCPUs; i++) {
+	steals -= cpus[i]->steals;
+	ipis -= cpus[i]->ipis;
+    }
+
+    // we become a process, with no address space, so that we can 
+    // Join the copies
+    currentThread->pid = processTable->Create(NULL, NoParent);
+    ASSERT(currentThread->pid >= 0);
+    for (started = 0; started < copies; started++) {
+	executable = fileSystem->Open(filename);
+	if (executable == NULL) {
+	    printf("Unable to open file %s\n", filename);
+	    break;
+	}
+	space = new AddrSpace(executable);
+	pids[started] = processTable->Create(space, currentThread->pid);
+	ASSERT(pids[started] >= 0);
+	thread = new Thread("user process");
+	thread->space = space;
+	thread->pid = pids[started];
+	thread->Fork(UserThreadStart, 0);
+    }
+    for (i = 0; i < started; i++) {
+	(void) processTable->Join(pids[i], currentThread->pid, &status);
+	if (i == 0)
+	    first = status;
+	else if (status != first)
+	    printf("Copy %d exited with %d, copy 0 with %d\n", i, status, 
+		   first);
+    }
+    processTable->Exit(currentThread->pid, 0);
+    currentThread->pid = -1;
+
+    ticks = stats->totalTicks - startTicks;
+    busy = stats->systemTicks + stats->userTicks - startBusy;
+    for (i = 0; i < numCPUs; i++) {
+	steals += cpus[i]->steals;
+	ipis += cpus[i]->ipis;
+    }
+    printf("cpus,processes,ticks,busy ticks,utilization %%,switches,"
+	   "steals,IPIs,exit status\n");
+    printf("%d,%d,%d,%d,%d,%d,%d,%d,%d\n", numCPUs, started, ticks, busy,
+	   (ticks > 0) ? busy * 100 / (ticks * numCPUs) : 0,
+	   stats->numContextSwitches - startSwitches, steals, ipis, first);
+    delete [] pids;
+}
+
 // Data structures needed for the console test.  Threads making
 // I/O requests wait on a Semaphore to delay until the I/O completes.
 
@@ -62,7 +142,7 @@ static void WriteDone(_int arg) { writeDone->V(); }
 //----------------------------------------------------------------------
 // ConsoleTest
 // 	Test the console by echoing characters typed at the input onto
-//	the output.  Stop when the user types a 'q'.
+//	the output.  Stop when the user types a 'q', or the input runs out.
 //----------------------------------------------------------------------
 
 void 
@@ -77,6 +157,7 @@ ConsoleTest (char *in, char *out)
     for (;;) {
 	readAvail->P();		// wait for character to arrive
 	ch = console->GetChar();
+	if (console->AtEOF()) return;
 	console->PutChar(ch);	// echo it!
 	writeDone->P() ;        // wait for write to finish
 	if (ch == 'q') return;  // if q, quit
@@ -0,0 +1,289 @@
+// synchconsole.cc 
+//	Routines to synchronously access the console.  The console 
+//	device is asynchronous (output returns immediately, and an
+//	interrupt happens later on; input arrives by interrupt whenever 
+//	a character is typed).  This is a layer on top of the console 
+//	providing a synchronous interface.
+//
+//	Output goes through a ring buffer.  The writer only has to wait 
+//	when the ring is full; the write-done interrupt hands the device
+//	the next burst straight away, so a long write costs one 
+//	interrupt per ConsoleFifoSize characters rather than one per 
+//	character.
+//
+//	Input is cooked a line at a time by the read interrupt handler,
+//	and the device is only asked to poll the keyboard while some 
+//	thread is waiting for a line.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "synchconsole.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// ConsoleReadAvail, ConsoleWriteDone
+// 	Console interrupt handlers.  Need these to be C routines, because 
+//	C++ can't handle pointers to member functions.
+//----------------------------------------------------------------------
+
+static void
+ConsoleReadAvail(_int arg)
+{
+    SynchConsole *con = (SynchConsole *)arg;
+
+    con->ReadAvail();
+}
+
+static void
+ConsoleWriteDone(_int arg)
+{
+    SynchConsole *con = (SynchConsole *)arg;
+
+    con->WriteDone();
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::SynchConsole
+// 	Initialize the synchronous interface to the console, in turn
+//	initializing the console device.  Keyboard polling is left off 
+//	until somebody reads.
+//
+//	"readFile" -- UNIX file simulating the keyboard (NULL -> use stdin)
+//	"writeFile" -- UNIX file simulating the display (NULL -> use stdout)
+//----------------------------------------------------------------------
+
+SynchConsole::SynchConsole(char *readFile, char *writeFile)
+{
+    readLock = new Lock("synch console read");
+    writeLock = new Lock("synch console write");
+    outProgress = new Semaphore("console output", 0);
+    lineAvail = new Semaphore("console line", 0);
+    outHead = outCount = outBusy = 0;
+    lineLength = 0;
+    inHead = inCount = 0;
+    inEOF = FALSE;
+    console = new Console(readFile, writeFile, ConsoleReadAvail, 
+				ConsoleWriteDone, (_int) this);
+    console->EnableRead(FALSE);
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::~SynchConsole
+// 	De-allocate data structures needed for the synchronous console
+//	abstraction.
+//----------------------------------------------------------------------
+
+SynchConsole::~SynchConsole()
+{
+    delete console;
+    delete lineAvail;
+    delete outProgress;
+    delete writeLock;
+    delete readLock;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::Write
+// 	Queue "size" characters from "buffer" for output.  Return once
+//	every one of them has been given to the device (though the last 
+//	burst may not have completed yet).
+//----------------------------------------------------------------------
+
+void
+SynchConsole::Write(char *buffer, int size)
+{
+    IntStatus oldLevel;
+    int tail, n;
+
+    writeLock->Acquire();			// only one writer at a time
+    oldLevel = interrupt->SetLevel(IntOff);
+    while (size > 0) {
+	while (outCount == ConsoleRingSize)
+	    outProgress->P();			// wait for room
+	tail = (outHead + outCount) % ConsoleRingSize;
+	n = min(size, ConsoleRingSize - outCount);
+	n = min(n, ConsoleRingSize - tail);
+	bcopy(buffer, &outRing[tail], n);
+	outCount += n;
+	buffer += n;
+	size -= n;
+	if (outBusy == 0)
+	    StartOutput();
+    }
+    while (outCount > outBusy)
+	outProgress->P();			// wait for the rest to go
+    (void) interrupt->SetLevel(oldLevel);
+    writeLock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::PutChar
+// 	Write one character to the console.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::PutChar(char ch)
+{
+    Write(&ch, 1);
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::StartOutput
+// 	Give the idle device as much of the queued output as its FIFO
+//	holds (without wrapping around the ring).  Called with
+//	interrupts off.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::StartOutput()
+{
+    int n = min(outCount, ConsoleFifoSize);
+
+    n = min(n, ConsoleRingSize - outHead);
+    console->PutChars(&outRing[outHead], n);
+    outBusy = n;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::WriteDone
+// 	Console write interrupt handler.  Retire the burst that has gone
+//	out, start the next, and wake any waiting writer.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::WriteDone()
+{
+    outHead = (outHead + outBusy) % ConsoleRingSize;
+    outCount -= outBusy;
+    outBusy = 0;
+    if (outCount > 0)
+	StartOutput();
+    outProgress->V();
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::Read
+// 	Wait for a line of input, then move up to "size" characters of 
+//	it into "buffer".  Never returns more than one line, so that a
+//	"\n" always ends a Read.  Returns the number of characters read,
+//	or 0 at end of file.
+//----------------------------------------------------------------------
+
+int
+SynchConsole::Read(char *buffer, int size)
+{
+    IntStatus oldLevel;
+    int n = 0;
+    char ch;
+
+    readLock->Acquire();			// only one reader at a time
+    oldLevel = interrupt->SetLevel(IntOff);
+    if ((inCount == 0) && !inEOF) {
+	console->EnableRead(TRUE);
+	while ((inCount == 0) && !inEOF)
+	    lineAvail->P();			// wait for a whole line
+	console->EnableRead(FALSE);
+    }
+    while ((n < size) && (inCount > 0)) {
+	ch = input[inHead];
+	inHead = (inHead + 1) % ConsoleInputSize;
+	inCount--;
+	buffer[n++] = ch;
+	if (ch == '\n')
+	    break;
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    readLock->Release();
+    return n;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::GetChar
+// 	Read one character from the console, or return EOF at the end
+//	of the input.
+//----------------------------------------------------------------------
+
+int
+SynchConsole::GetChar()
+{
+    char ch;
+
+    if (Read(&ch, 1) == 0)
+	return EOF;
+    return ch;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::ReadAvail
+// 	Console read interrupt handler.  Take the character from the 
+//	device and cook it.  At end of file, pass on any unfinished line
+//	and tell readers there will be no more.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::ReadAvail()
+{
+    char ch = console->GetChar();
+
+    if (ch != EOF)
+	CookChar(ch);
+    else if (console->AtEOF()) {
+	if (lineLength > 0)
+	    EndLine();
+	inEOF = TRUE;
+	lineAvail->V();
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::CookChar
+// 	Add a typed character to the line being collected, handling
+//	erase and line kill.  A newline, or a full line, makes the line
+//	available to readers.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::CookChar(char ch)
+{
+    switch (ch) {
+      case ConsoleErase:
+      case ConsoleDelete:
+	if (lineLength > 0)
+	    lineLength--;
+	break;
+      case ConsoleKill:
+	lineLength = 0;
+	break;
+      default:
+	line[lineLength++] = ch;
+	if ((ch == '\n') || (lineLength == ConsoleLineSize))
+	    EndLine();
+	break;
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::EndLine
+// 	Move the line being typed to the completed input, and wake up a
+//	reader.  Input that does not fit is thrown away, as a terminal
+//	would when its buffer overflows.
+//----------------------------------------------------------------------
+
+void
+SynchConsole::EndLine()
+{
+    int i, tail;
+
+    for (i = 0; (i < lineLength) && (inCount < ConsoleInputSize); i++) {
+	tail = (inHead + inCount) % ConsoleInputSize;
+	input[tail] = line[i];
+	inCount++;
+    }
+    if (i < lineLength)
+	DEBUG('a', "Console input overflow, %d chars lost\n", lineLength - i);
+    lineLength = 0;
+    lineAvail->V();
+}
@@ -0,0 +1,77 @@
+// synchconsole.h 
+//	Data structures to export a synchronous interface to the console
+//	device, for use by the system calls.
+//
+//	The raw console accepts one burst of output at a time and hands
+//	the kernel one input character at a time.  SynchConsole hides 
+//	that: output is queued in a ring buffer which the write-done
+//	interrupt drains ConsoleFifoSize characters at a time, and input
+//	is "cooked" -- collected a line at a time, with backspace and 
+//	line kill handled, before any of it is given to a reader.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SYNCHCONSOLE_H
+#define SYNCHCONSOLE_H
+
+#include "copyright.h"
+#include "console.h"
+#include "synch.h"
+
+#define ConsoleRingSize		256	// bytes of queued output
+#define ConsoleLineSize		128	// longest input line
+#define ConsoleInputSize	512	// bytes of completed input lines
+
+#define ConsoleErase		'\b'	// delete the last character typed
+#define ConsoleDelete		'\177'	// ... likewise
+#define ConsoleKill		'\025'	// (^U) delete the whole line
+
+// The following class defines a "synchronous" console abstraction.
+// Write returns once all of its characters have been handed to the
+// device, so nothing is lost if the machine halts straight after;
+// Read waits until a whole line has been typed, and returns at most
+// that one line.
+
+class SynchConsole {
+  public:
+    SynchConsole(char *readFile, char *writeFile);
+    				// Initialize the console device
+    ~SynchConsole();		// De-allocate the console
+
+    void Write(char *buffer, int size);	// Write "size" characters
+    void PutChar(char ch);	// Write one character
+
+    int Read(char *buffer, int size);	// Read up to "size" characters
+				// of the next line; 0 at end of file
+    int GetChar();		// Read one character, or EOF
+
+    void ReadAvail();		// Called by the console device interrupt
+    void WriteDone();		// handlers
+
+  private:
+    void StartOutput();		// Hand the device its next burst
+    void CookChar(char ch);	// Apply line editing to a typed char
+    void EndLine();		// Pass the line being typed to readers
+
+    Console *console;		// Raw console device
+    Lock *readLock;		// Only one reader at a time
+    Lock *writeLock;		// Only one writer at a time
+
+    char outRing[ConsoleRingSize];	// Queued output
+    int outHead;		// Oldest character not yet sent
+    int outCount;		// Characters queued, including those
+				// in the device
+    int outBusy;		// Characters in the device, 0 if idle
+    Semaphore *outProgress;	// Signalled on every write completion
+
+    char line[ConsoleLineSize];	// Line being typed
+    int lineLength;
+    char input[ConsoleInputSize];	// Completed lines
+    int inHead, inCount;
+    bool inEOF;			// No more input will arrive
+    Semaphore *lineAvail;	// Signalled when a line is completed
+};
+
+#endif // SYNCHCONSOLE_H
@@ -30,6 +30,7 @@
 #define SC_Fork		9
 #define SC_Yield	10
 #define SC_PrintInt	11
+#define SC_Sleep	12
 
 #ifndef IN_ASM
 
@@ -52,16 +53,17 @@ void Halt();
 /* This user program is done (status = 0 means exited normally). */
 void Exit(int status);	
 
-/* A unique identifier for an executing user program (address space) */
+/* A unique identifier for an executing user program (its process ID) */
 typedef int SpaceId;	
  
-/* Run the executable, stored in the Nachos file "name", and return the 
- * address space identifier
+/* Run the executable, stored in the Nachos file "name", as a new 
+ * process, and return its process ID (-1 if it could not be started).
  */
 SpaceId Exec(char *name);
  
 /* Only return once the the user program "id" has finished.  
- * Return the exit status.
+ * Return the exit status.  Only the process that Exec'ed "id" may
+ * Join it, and only once; otherwise -1 is returned right away.
  */
 int Join(SpaceId id); 	
  
@@ -128,6 +130,11 @@ void Yield();
 /* Print an integer value to the console */ 
 void PrintInt(int value);
 
+/* Sleep for "ticks" ticks of simulated time, without using the CPU;
+ * other programs run meanwhile.  Returns at once if "ticks" <= 0.
+ */
+void Sleep(int ticks);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
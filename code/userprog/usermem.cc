@@ -0,0 +1,119 @@
+// usermem.cc 
+//	Routines to copy data in and out of user address spaces.
+//
+//	We call Machine::Translate directly, instead of ReadMem/WriteMem,
+//	so that a page fault doesn't go through RaiseException -- we are
+//	already in the kernel, in the middle of a system call.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "usermem.h"
+
+//----------------------------------------------------------------------
+// UserToPhys
+// 	Translate user address "virtAddr" of the current address space
+//	into a pointer into main memory, bringing the page in (or into
+//	the TLB) if necessary.  Returns NULL if the address is bad.
+//
+//	"writing" -- TRUE if the kernel is about to store into the page,
+//		so that it is marked dirty
+//----------------------------------------------------------------------
+
+static char *
+UserToPhys(int virtAddr, bool writing)
+{
+    int physAddr;
+    ExceptionType exception;
+
+    while ((exception = machine->Translate(virtAddr, &physAddr, 1, writing))
+			!= NoException) {
+	if ((exception != PageFaultException) ||
+			!currentThread->space->PageFault(virtAddr))
+	    return NULL;
+    }
+    return &(machine->mainMemory[physAddr]);
+}
+
+//----------------------------------------------------------------------
+// CopyUser
+// 	Copy "size" bytes between user address "virtAddr" and kernel
+//	"buffer", one page at a time, in the direction given by 
+//	"toUser".  Returns FALSE if part of the range is bad; the bytes
+//	before that point have been copied.
+//----------------------------------------------------------------------
+
+static bool
+CopyUser(int virtAddr, char *buffer, int size, bool toUser)
+{
+    while (size > 0) {
+	int n = min(size, PageSize - (int) ((unsigned) virtAddr % PageSize));
+	char *phys = UserToPhys(virtAddr, toUser);
+
+	if (phys == NULL)
+	    return FALSE;
+	if (toUser)
+	    memcpy(phys, buffer, n);
+	else
+	    memcpy(buffer, phys, n);
+	virtAddr += n;
+	buffer += n;
+	size -= n;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// CopyFromUser, CopyToUser
+// 	Copy "size" bytes from user address "virtAddr" into "buffer", or
+//	from "buffer" to user address "virtAddr".  Return FALSE if part
+//	of the range is not a valid address.
+//----------------------------------------------------------------------
+
+bool
+CopyFromUser(int virtAddr, char *buffer, int size)
+{
+    return CopyUser(virtAddr, buffer, size, FALSE);
+}
+
+bool
+CopyToUser(int virtAddr, char *buffer, int size)
+{
+    return CopyUser(virtAddr, buffer, size, TRUE);
+}
+
+//----------------------------------------------------------------------
+// CopyStringFromUser
+// 	Copy the null-terminated string at user address "virtAddr" into
+//	"buffer", which holds "size" bytes, scanning each page for the
+//	terminator with memchr.  Returns the length of the string, or
+//	-1 if the string is at a bad address or is too long.
+//----------------------------------------------------------------------
+
+int
+CopyStringFromUser(int virtAddr, char *buffer, int size)
+{
+    int length = 0;
+
+    while (length < size) {
+	int n = min(size - length, 
+			PageSize - (int) ((unsigned) virtAddr % PageSize));
+	char *phys = UserToPhys(virtAddr, FALSE);
+	char *end;
+
+	if (phys == NULL)
+	    return -1;
+	end = (char *) memchr(phys, '\0', n);
+	if (end != NULL) {
+	    memcpy(buffer + length, phys, end - phys + 1);
+	    return length + (end - phys);
+	}
+	memcpy(buffer + length, phys, n);
+	virtAddr += n;
+	length += n;
+    }
+    return -1;			// no room for the terminator
+}
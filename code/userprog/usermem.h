@@ -0,0 +1,33 @@
+// usermem.h 
+//	Routines for the kernel to move data between its own memory and
+//	the virtual address space of the current user program, such as
+//	system call arguments and I/O buffers.
+//
+//	Rather than going through Machine::ReadMem/WriteMem a byte at a
+//	time, these translate each virtual page once and copy the whole
+//	run of bytes that lies in it.  A page that is not in memory is
+//	faulted in, and the copy carries on.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef USERMEM_H
+#define USERMEM_H
+
+#include "copyright.h"
+
+#define MaxUserString	128	// longest string argument (with the '\0')
+
+// Copy "size" bytes at user address "virtAddr" into "buffer", or from
+// "buffer" to "virtAddr".  Return FALSE if any part of the user
+// range is not a valid address.
+extern bool CopyFromUser(int virtAddr, char *buffer, int size);
+extern bool CopyToUser(int virtAddr, char *buffer, int size);
+
+// Copy the null-terminated string at user address "virtAddr" into 
+// "buffer", which holds "size" bytes.  Return the length of the 
+// string, or -1 if it is at a bad address or does not fit.
+extern int CopyStringFromUser(int virtAddr, char *buffer, int size);
+
+#endif // USERMEM_H